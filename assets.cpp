@@ -0,0 +1,40 @@
+#include "assets.h"
+#include "jobsystem.h"
+#include <iostream>
+
+bool loadTextures(const std::vector<TextureLoad>& loads) {
+    std::vector<sf::Image> images(loads.size());
+    std::vector<char> decoded(loads.size(), 0);
+
+    getJobSystem().parallelFor(0, static_cast<int>(loads.size()), 1, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            decoded[i] = images[i].loadFromFile(loads[i].path) ? 1 : 0;
+        }
+    });
+
+    bool success = true;
+    for (size_t i = 0; i < loads.size(); i++) {
+        if (!decoded[i] || !loads[i].texture->loadFromImage(images[i])) {
+            std::cout << "Could not load " << loads[i].path << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+void drawTorch(sf::Image& image) {
+    sf::Vector2u size = image.getSize();
+    float unit = size.x / 16.0f;
+    auto fill = [&](float left, float top, float right, float bottom, sf::Color color) {
+        for (unsigned y = static_cast<unsigned>(top * unit); y < static_cast<unsigned>(bottom * unit) && y < size.y; y++) {
+            for (unsigned x = static_cast<unsigned>(left * unit); x < static_cast<unsigned>(right * unit) && x < size.x; x++) {
+                image.setPixel({ x, y }, color);
+            }
+        }
+    };
+
+    // In 16x16 units: a stick with a flame on top
+    fill(7, 7, 9, 14, sf::Color{ 110, 70, 30 });
+    fill(6, 4, 10, 7, sf::Color{ 255, 140, 20 });
+    fill(7, 2, 9, 4, sf::Color{ 255, 220, 90 });
+}
@@ -0,0 +1,20 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+struct TextureLoad {
+    sf::Texture* texture;
+    std::string path;
+};
+
+// Decodes the image files in parallel on the job system, then uploads them to their
+// textures on the calling thread (which owns the GL context). False if any of them failed.
+bool loadTextures(const std::vector<TextureLoad>& loads);
+
+// Paints a torch (stick and flame) into the middle of an image, scaled to its size
+void drawTorch(sf::Image& image);
+
+#endif
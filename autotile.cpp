@@ -0,0 +1,160 @@
+#include "autotile.h"
+#include <algorithm>
+
+namespace {
+    const std::uint8_t TERRAIN_UNLOADED = 0xFF;
+
+    std::uint8_t getTerrain(TileType tileType) {
+        switch (tileType) {
+        case TileType::WATER: return 1;
+        case TileType::STONE: return 2;
+        case TileType::DIRT: return 3;
+        default: return 0; // Grass, and the trees and torches on it
+        }
+    }
+
+    // A diagonal neighbor only changes the shape when both sides next to it match
+    int reduceMask(int mask) {
+        int reduced = mask & (AUTOTILE_N | AUTOTILE_E | AUTOTILE_S | AUTOTILE_W);
+        if ((mask & AUTOTILE_N) && (mask & AUTOTILE_E)) reduced |= mask & AUTOTILE_NE;
+        if ((mask & AUTOTILE_S) && (mask & AUTOTILE_E)) reduced |= mask & AUTOTILE_SE;
+        if ((mask & AUTOTILE_S) && (mask & AUTOTILE_W)) reduced |= mask & AUTOTILE_SW;
+        if ((mask & AUTOTILE_N) && (mask & AUTOTILE_W)) reduced |= mask & AUTOTILE_NW;
+        return reduced;
+    }
+
+    // Shapes are the reduced masks in ascending order, so all eight neighbors matching is the last
+    struct ShapeTable {
+        std::uint8_t shapes[256];
+        std::uint8_t masks[AUTOTILE_SHAPES];
+
+        ShapeTable() {
+            std::uint8_t shapeOfReduced[256] = {};
+            int count = 0;
+            for (int mask = 0; mask < 256; mask++) {
+                if (reduceMask(mask) == mask) {
+                    masks[count] = static_cast<std::uint8_t>(mask);
+                    shapeOfReduced[mask] = static_cast<std::uint8_t>(count++);
+                }
+            }
+            for (int mask = 0; mask < 256; mask++) {
+                shapes[mask] = shapeOfReduced[reduceMask(mask)];
+            }
+        }
+    };
+
+    const ShapeTable& getShapeTable() {
+        static const ShapeTable table;
+        return table;
+    }
+
+    // Terrain of the tiles in a rectangle, row-major. Rows are walked in spans that stay
+    // within one chunk, with one lookup per chunk the rectangle touches rather than per
+    // tile. extra stands in for a chunk that isn't in chunks yet.
+    void gatherTerrain(const LoadedChunks& chunks, const Chunk* extra, int startX, int startY, int width, int height, std::uint8_t* out) {
+        int startChunkX = floorDiv(startX, CHUNK_SIZE);
+        int endChunkX = floorDiv(startX + width - 1, CHUNK_SIZE);
+        std::vector<const Chunk*> band(static_cast<size_t>(endChunkX - startChunkX + 1));
+
+        int y = startY;
+        while (y < startY + height) {
+            int chunkY = floorDiv(y, CHUNK_SIZE);
+            for (int chunkX = startChunkX; chunkX <= endChunkX; chunkX++) {
+                ChunkCoord coord = { chunkX, chunkY };
+                auto chunkIt = chunks.find(coord);
+                const Chunk*& source = band[chunkX - startChunkX];
+                source = (extra && extra->coord == coord) ? extra : (chunkIt != chunks.end()) ? chunkIt->second.get() : nullptr;
+            }
+
+            int bandEnd = std::min(startY + height, (chunkY + 1) * CHUNK_SIZE);
+            for (; y < bandEnd; y++) {
+                int tileY = y - chunkY * CHUNK_SIZE;
+                std::uint8_t* outRow = out + static_cast<size_t>(y - startY) * width;
+                int x = startX;
+                while (x < startX + width) {
+                    int chunkX = floorDiv(x, CHUNK_SIZE);
+                    int tileX = x - chunkX * CHUNK_SIZE;
+                    int span = std::min(startX + width - x, CHUNK_SIZE - tileX);
+                    const Chunk* source = band[chunkX - startChunkX];
+                    for (int i = 0; i < span; i++) {
+                        outRow[x - startX + i] = source ? getTerrain(source->tileTypes[tileY][tileX + i]) : TERRAIN_UNLOADED;
+                    }
+                    x += span;
+                }
+            }
+        }
+    }
+
+    // Shape of the tile at terrain, in a grid with rows stride apart
+    std::uint8_t getShapeAt(const std::uint8_t* terrain, int stride) {
+        std::uint8_t own = *terrain;
+        auto matches = [own](std::uint8_t neighbor) {
+            return neighbor == own || neighbor == TERRAIN_UNLOADED;
+        };
+
+        int mask = 0;
+        if (matches(terrain[-stride])) mask |= AUTOTILE_N;
+        if (matches(terrain[-stride + 1])) mask |= AUTOTILE_NE;
+        if (matches(terrain[1])) mask |= AUTOTILE_E;
+        if (matches(terrain[stride + 1])) mask |= AUTOTILE_SE;
+        if (matches(terrain[stride])) mask |= AUTOTILE_S;
+        if (matches(terrain[stride - 1])) mask |= AUTOTILE_SW;
+        if (matches(terrain[-1])) mask |= AUTOTILE_W;
+        if (matches(terrain[-stride - 1])) mask |= AUTOTILE_NW;
+        return getAutotileShape(static_cast<std::uint8_t>(mask));
+    }
+}
+
+std::uint8_t getAutotileShape(std::uint8_t neighborMask) {
+    return getShapeTable().shapes[neighborMask];
+}
+
+std::uint8_t getAutotileMask(std::uint8_t shape) {
+    return getShapeTable().masks[std::min<int>(shape, AUTOTILE_SHAPES - 1)];
+}
+
+void computeChunkAutotiles(const LoadedChunks& chunks, Chunk& chunk) {
+    // The chunk with a tile of its neighbors around it
+    const int PADDED = CHUNK_SIZE + 2;
+    std::uint8_t terrain[PADDED * PADDED];
+    int startX = static_cast<int>(chunk.coord.x * CHUNK_SIZE);
+    int startY = static_cast<int>(chunk.coord.y * CHUNK_SIZE);
+    gatherTerrain(chunks, &chunk, startX - 1, startY - 1, PADDED, PADDED, terrain);
+
+    for (int y = 0; y < CHUNK_SIZE; y++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            chunk.autotiles[y][x] = getShapeAt(&terrain[(y + 1) * PADDED + x + 1], PADDED);
+        }
+    }
+}
+
+void retileArea(LoadedChunks& chunks, int startX, int startY, int width, int height, std::vector<ChunkCoord>& changedChunks) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    int stride = width + 2;
+    std::vector<std::uint8_t> terrain(static_cast<size_t>(stride) * (height + 2));
+    gatherTerrain(chunks, nullptr, startX - 1, startY - 1, stride, height + 2, terrain.data());
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int worldX = startX + x;
+            int worldY = startY + y;
+            auto chunkIt = chunks.find(chunkOfTile(worldX, worldY));
+            if (chunkIt == chunks.end()) {
+                continue;
+            }
+
+            Chunk& chunk = *chunkIt->second;
+            std::uint8_t shape = getShapeAt(&terrain[static_cast<size_t>(y + 1) * stride + x + 1], stride);
+            std::uint8_t& stored = chunk.autotiles[floorMod(worldY, CHUNK_SIZE)][floorMod(worldX, CHUNK_SIZE)];
+            if (stored != shape) {
+                stored = shape;
+                if (std::find(changedChunks.begin(), changedChunks.end(), chunk.coord) == changedChunks.end()) {
+                    changedChunks.push_back(chunk.coord);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef AUTOTILE_H
+#define AUTOTILE_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+#include "constants.h"
+#include "chunk.h"
+#include "water.h"
+
+// Blob autotiling of terrain transitions. Every tile belongs to a terrain: grass (with the
+// trees and torches standing on it), water, stone or dirt. Its eight neighbors give a
+// bitmask of which share that terrain; a diagonal only counts when both sides next to it
+// do, which leaves AUTOTILE_SHAPES distinct shapes, and a 256-entry table maps every mask
+// to its shape. Chunk::autotiles holds each tile's shape. Tiles in unloaded chunks match
+// anything, so a chunk's border is filled in when its neighbor loads.
+enum AutotileNeighbor : std::uint8_t {
+    AUTOTILE_N = 1,
+    AUTOTILE_NE = 2,
+    AUTOTILE_E = 4,
+    AUTOTILE_SE = 8,
+    AUTOTILE_S = 16,
+    AUTOTILE_SW = 32,
+    AUTOTILE_W = 64,
+    AUTOTILE_NW = 128
+};
+
+std::uint8_t getAutotileShape(std::uint8_t neighborMask);
+std::uint8_t getAutotileMask(std::uint8_t shape); // The reduced neighbor mask a shape stands for
+
+// All of a chunk's shapes. The chunk need not be in chunks yet; its neighbors are read from there.
+void computeChunkAutotiles(const LoadedChunks& chunks, Chunk& chunk);
+
+// Recomputes the shapes of the loaded tiles in a rectangle of world tiles, after the tiles
+// in or around it changed. Reports each chunk whose shapes changed once.
+void retileArea(LoadedChunks& chunks, int startX, int startY, int width, int height, std::vector<ChunkCoord>& changedChunks);
+
+#endif
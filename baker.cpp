@@ -0,0 +1,189 @@
+// World baker: generates every chunk of a world in parallel and writes a memory-mappable
+// world file that Map::openBakedWorld can use instead of generating at runtime.
+//
+// Usage: baker [output] [--seed N] [--width TILES] [--height TILES] [--threads N] [--bench [SAMPLES]] [--scaling [CHUNKS]]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+
+#include "constants.h"
+#include "worldgen.h"
+#include "worldfile.h"
+#include "jobsystem.h"
+
+namespace {
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Generates chunks [0, chunkCount) of the world on the given job system. Each worker owns a
+    // generator, so noise caches are never shared between threads.
+    void generateChunks(JobSystem& jobs, std::uint32_t seed, int chunksX, int chunkCount, TileType* out) {
+        const int tilesPerChunk = CHUNK_SIZE * CHUNK_SIZE;
+        std::vector<WorldGenerator> generators(jobs.getWorkerCount(), WorldGenerator(seed));
+
+        jobs.parallelFor(0, chunkCount, 4, [&](int begin, int end) {
+            WorldGenerator& generator = generators[JobSystem::currentWorkerIndex()];
+            for (int chunkIndex = begin; chunkIndex < end; chunkIndex++) {
+                generator.generateChunk(chunkIndex % chunksX, chunkIndex / chunksX, out + static_cast<std::size_t>(chunkIndex) * tilesPerChunk);
+            }
+        });
+    }
+
+    // Chunk generation throughput with 1, 2, 4... workers up to threadCount, on fresh
+    // generators each run so every configuration does the same uncached work
+    void runScalingBenchmark(std::uint32_t seed, int chunksX, int chunkCount, unsigned threadCount) {
+        std::vector<TileType> tiles(static_cast<std::size_t>(chunkCount) * CHUNK_SIZE * CHUNK_SIZE);
+
+        std::vector<unsigned> workerCounts;
+        for (unsigned workers = 1; workers < threadCount; workers *= 2) {
+            workerCounts.push_back(workers);
+        }
+        workerCounts.push_back(threadCount);
+
+        std::cout << "Scaling benchmark: " << chunkCount << " chunks, up to " << threadCount << " workers ("
+            << std::thread::hardware_concurrency() << " hardware threads)" << std::endl;
+
+        double baseline = 0.0;
+        for (unsigned workers : workerCounts) {
+            JobSystem jobs(workers);
+            auto start = std::chrono::steady_clock::now();
+            generateChunks(jobs, seed, chunksX, chunkCount, tiles.data());
+            double seconds = secondsSince(start);
+
+            double chunksPerSecond = chunkCount / std::max(seconds, 1e-9);
+            if (baseline == 0.0) {
+                baseline = chunksPerSecond;
+            }
+            double speedup = chunksPerSecond / baseline;
+            std::cout << "  " << workers << " workers: " << static_cast<int>(chunksPerSecond) << " chunks/s, "
+                << speedup << "x speedup, " << static_cast<int>(100.0 * speedup / workers) << "% efficiency, "
+                << jobs.getJobsStolen() << " jobs stolen" << std::endl;
+        }
+    }
+
+    // Compares per-chunk latency of reading from the baked file against generating from scratch
+    void runBenchmark(const std::string& path, std::uint32_t seed, int samples) {
+        BakedWorld bakedWorld;
+        if (!bakedWorld.open(path)) {
+            std::cout << "Benchmark: could not open " << path << std::endl;
+            return;
+        }
+
+        const BakedWorldHeader& header = bakedWorld.getHeader();
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<int> pickX(0, static_cast<int>(header.chunksX) - 1);
+        std::uniform_int_distribution<int> pickY(0, static_cast<int>(header.chunksY) - 1);
+
+        std::vector<std::pair<int, int>> coords(samples);
+        for (auto& coord : coords) {
+            coord = { pickX(rng), pickY(rng) };
+        }
+
+        TileType tiles[CHUNK_SIZE * CHUNK_SIZE];
+        unsigned checksum = 0;
+
+        WorldGenerator generator(seed);
+        auto generateStart = std::chrono::steady_clock::now();
+        for (const auto& coord : coords) {
+            generator.generateChunk(coord.first, coord.second, tiles);
+            checksum += static_cast<unsigned>(tiles[0]);
+        }
+        double generateSeconds = secondsSince(generateStart);
+
+        auto loadStart = std::chrono::steady_clock::now();
+        for (const auto& coord : coords) {
+            const TileType* baked = bakedWorld.getChunkTiles(coord.first, coord.second);
+            std::copy(baked, baked + CHUNK_SIZE * CHUNK_SIZE, tiles);
+            checksum += static_cast<unsigned>(tiles[0]);
+        }
+        double loadSeconds = secondsSince(loadStart);
+
+        std::cout << "Benchmark over " << samples << " random chunks (checksum " << checksum << "):" << std::endl;
+        std::cout << "  generate:        " << generateSeconds * 1e6 / samples << " us/chunk" << std::endl;
+        std::cout << "  load from bake:  " << loadSeconds * 1e6 / samples << " us/chunk" << std::endl;
+        if (loadSeconds > 0.0) {
+            std::cout << "  speedup:         " << generateSeconds / loadSeconds << "x" << std::endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string outputPath = "world.bake";
+    std::uint32_t seed = 0;
+    int worldWidth = WORLD_WIDTH;
+    int worldHeight = WORLD_HEIGHT;
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    bool bench = false;
+    int benchSamples = 2000;
+    bool scaling = false;
+    int scalingChunks = 2000;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seed" && hasValue) seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--width" && hasValue) worldWidth = std::atoi(argv[++i]);
+        else if (arg == "--height" && hasValue) worldHeight = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue) threadCount = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--bench") {
+            bench = true;
+            if (hasValue && argv[i + 1][0] != '-') benchSamples = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--scaling") {
+            scaling = true;
+            if (hasValue && argv[i + 1][0] != '-') scalingChunks = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (!arg.empty() && arg[0] != '-') outputPath = arg;
+        else {
+            std::cout << "Usage: baker [output] [--seed N] [--width TILES] [--height TILES] [--threads N] [--bench [SAMPLES]] [--scaling [CHUNKS]]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (worldWidth <= 0 || worldHeight <= 0) {
+        std::cout << "World size must be positive" << std::endl;
+        return 1;
+    }
+
+    BakedWorldHeader header = makeBakedWorldHeader(seed, worldWidth, worldHeight);
+    const int chunkCount = static_cast<int>(header.chunksX * header.chunksY);
+    const int tilesPerChunk = CHUNK_SIZE * CHUNK_SIZE;
+
+    if (scaling) {
+        runScalingBenchmark(seed, static_cast<int>(header.chunksX), std::min(scalingChunks, chunkCount), threadCount);
+        return 0;
+    }
+
+    std::cout << "Baking " << header.chunksX << "x" << header.chunksY << " chunks (" << chunkCount
+        << ") with seed " << seed << " on " << threadCount << " threads..." << std::endl;
+
+    std::vector<TileType> chunkTiles(static_cast<std::size_t>(chunkCount) * tilesPerChunk);
+
+    auto bakeStart = std::chrono::steady_clock::now();
+    {
+        JobSystem jobs(threadCount);
+        generateChunks(jobs, seed, static_cast<int>(header.chunksX), chunkCount, chunkTiles.data());
+    }
+    double bakeSeconds = secondsSince(bakeStart);
+
+    std::cout << "Generated " << chunkCount << " chunks in " << bakeSeconds << " s ("
+        << static_cast<int>(chunkCount / std::max(bakeSeconds, 1e-9)) << " chunks/s)" << std::endl;
+
+    if (!writeBakedWorld(outputPath, header, chunkTiles)) {
+        return 1;
+    }
+    std::cout << "Wrote " << outputPath << std::endl;
+
+    if (bench) {
+        runBenchmark(outputPath, seed, benchSamples);
+    }
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "utils.h"
+
+// Timing summaries shared by the benchmark tools; millisecondsSince is in utils.h
+
+// The sample at or just above fraction of the way through the sorted samples; 0 with none
+inline double percentile(std::vector<double> samples, double fraction) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t index = std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+    return samples[index];
+}
+
+// One line of sample count, average and percentiles for a set of timings in milliseconds
+inline void reportTimes(const std::string& name, const std::vector<double>& times) {
+    if (times.empty()) {
+        std::cout << name << ": no samples" << std::endl;
+        return;
+    }
+    double total = 0.0;
+    for (double time : times) {
+        total += time;
+    }
+    std::cout << name << ": " << times.size() << " samples, avg " << total / times.size() << " ms, p50 "
+        << percentile(times, 0.5) << " ms, p99 " << percentile(times, 0.99) << " ms, max " << percentile(times, 1.0)
+        << " ms" << std::endl;
+}
+
+// Prints the verdict on the p99 frame against the 60 FPS budget; passes if it fits and passed is set
+inline bool reportFrameBudget(const std::vector<double>& frameTimes, bool passed = true) {
+    const double budget = 1000.0 / 60.0;
+    double p99 = percentile(frameTimes, 0.99);
+    passed = passed && p99 <= budget;
+    std::cout << "p99 frame uses " << (p99 / budget * 100.0) << "% of the " << budget << " ms budget at 60 FPS: "
+        << (passed ? "PASS" : "FAIL") << std::endl;
+    return passed;
+}
+
+#endif
@@ -2,39 +2,130 @@
 #define CHUNK_H
 
 #include <SFML/Graphics.hpp>
-#include <optional>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 #include "constants.h"
+#include "worldcoords.h"
 
-struct Tile {
-    TileType type;
-    sf::Sprite sprite;
+// Local tile indexing for a chunk edge of Size tiles. Size is a power of two, so an index is
+// a shift and an or, and the compiler folds all of it for each instantiation.
+template <int Size>
+struct ChunkLayout {
+    static_assert(Size >= 8 && Size <= 64 && (Size & (Size - 1)) == 0,
+        "Chunk edges are powers of two from 8 to 64, so local indices fit in 16 bits");
 
-    Tile() = default;
-    Tile(TileType t, sf::Texture& texture) : type(t), sprite(texture) {}
-};
+    static constexpr int SIZE = Size;
+    static constexpr int TILES = Size * Size;
+    static constexpr int SHIFT = (Size == 8) ? 3 : (Size == 16) ? 4 : (Size == 32) ? 5 : 6;
+    static constexpr int MASK = Size - 1;
 
-struct ChunkCoord {
-    int x, y;
+    static constexpr int index(int x, int y) { return (y << SHIFT) | x; }
+    static constexpr int localX(int index) { return index & MASK; }
+    static constexpr int localY(int index) { return index >> SHIFT; }
+};
 
-    bool operator==(const ChunkCoord& other) const {
-        return x == other.x && y == other.y;
-    }
+// Immutable copy of a chunk's tiles for the render thread. A changed chunk gets a new
+// mesh instead of modifying this one, so the renderer can hold it without locking.
+template <int Size>
+struct BasicChunkMesh {
+    ChunkCoord coord;
+    TileType tileTypes[Size][Size];
+    std::uint8_t waterLevels[Size][Size];
+    std::uint8_t light[Size][Size];
+    std::uint8_t autotiles[Size][Size];
 };
 
-struct Chunk {
+// A square of Size * Size tiles. The game builds with Size = CHUNK_SIZE (see Chunk below);
+// chunkbench instantiates the other edge lengths side by side to compare them.
+template <int Size>
+struct BasicChunk {
+    using Layout = ChunkLayout<Size>;
+    using Mesh = BasicChunkMesh<Size>;
+
     ChunkCoord coord;
-    std::optional<Tile> tiles[CHUNK_SIZE][CHUNK_SIZE];
-    bool solidTiles[CHUNK_SIZE][CHUNK_SIZE];
+    TileType tileTypes[Size][Size]; // Authoritative tile state, rows are contiguous
+    bool solidTiles[Size][Size];
+    std::uint8_t waterLevels[Size][Size]; // Standing water on DIRT tiles, see WaterSimulation
+    std::uint8_t light[Size][Size];       // Torch light 0-TORCH_LIGHT, see computeChunkLight
+    std::uint8_t autotiles[Size][Size];   // Terrain edge shape, below AUTOTILE_SHAPES; see autotile.h
     bool isLoaded = false;
 
-    Chunk(ChunkCoord c) : coord(c) {
+    // What the render thread sees of this chunk; rebuilt after every change to tileTypes
+    std::shared_ptr<const Mesh> mesh;
+
+    // Resource index: local tile indices (Layout::index) of harvestable tiles, and of light sources
+    std::vector<std::uint16_t> treeTiles;
+    std::vector<std::uint16_t> stoneTiles;
+    std::vector<std::uint16_t> torchTiles;
+
+    BasicChunk(ChunkCoord c) : coord(c) {
         // Initialize solid tiles to false
-        for (int y = 0; y < CHUNK_SIZE; y++) {
-            for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int y = 0; y < Size; y++) {
+            for (int x = 0; x < Size; x++) {
+                tileTypes[y][x] = TileType::GRASS;
                 solidTiles[y][x] = false;
+                waterLevels[y][x] = 0;
+                light[y][x] = 0;
+                autotiles[y][x] = AUTOTILE_SHAPES - 1; // No edges
+            }
+        }
+    }
+
+    void rebuildMesh() {
+        auto newMesh = std::make_shared<Mesh>();
+        newMesh->coord = coord;
+        std::copy(&tileTypes[0][0], &tileTypes[0][0] + Layout::TILES, &newMesh->tileTypes[0][0]);
+        std::copy(&waterLevels[0][0], &waterLevels[0][0] + Layout::TILES, &newMesh->waterLevels[0][0]);
+        std::copy(&light[0][0], &light[0][0] + Layout::TILES, &newMesh->light[0][0]);
+        std::copy(&autotiles[0][0], &autotiles[0][0] + Layout::TILES, &newMesh->autotiles[0][0]);
+        mesh = std::move(newMesh);
+    }
+
+    std::vector<std::uint16_t>* getResourceList(TileType type) {
+        switch (type) {
+        case TileType::TREE: return &treeTiles;
+        case TileType::STONE: return &stoneTiles;
+        case TileType::TORCH: return &torchTiles;
+        default: return nullptr;
+        }
+    }
+
+    const std::vector<std::uint16_t>* getResourceList(TileType type) const {
+        return const_cast<BasicChunk*>(this)->getResourceList(type);
+    }
+
+    void rebuildResourceIndex() {
+        treeTiles.clear();
+        stoneTiles.clear();
+        torchTiles.clear();
+        for (int y = 0; y < Size; y++) {
+            for (int x = 0; x < Size; x++) {
+                if (auto* list = getResourceList(tileTypes[y][x])) {
+                    list->push_back(static_cast<std::uint16_t>(Layout::index(x, y)));
+                }
             }
         }
     }
+
+    // Keep the resource index in sync with a single tile change
+    void updateResourceIndex(int x, int y, TileType oldType, TileType newType) {
+        std::uint16_t index = static_cast<std::uint16_t>(Layout::index(x, y));
+        if (auto* list = getResourceList(oldType)) {
+            auto it = std::find(list->begin(), list->end(), index);
+            if (it != list->end()) {
+                *it = list->back();
+                list->pop_back();
+            }
+        }
+        if (auto* list = getResourceList(newType)) {
+            list->push_back(index);
+        }
+    }
 };
 
+using Chunk = BasicChunk<CHUNK_SIZE>;
+using ChunkMesh = BasicChunkMesh<CHUNK_SIZE>;
+
 #endif
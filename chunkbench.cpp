@@ -0,0 +1,173 @@
+// Chunk size benchmark: builds the same square of world with 8, 16, 32 and 64-tile chunks
+// side by side and compares what the edge length costs. For each one it reports:
+//   - generation throughput, noise lattice cells evaluated per chunk and the longest single
+//     chunk load (a streaming hitch),
+//   - the cost of rebuilding a chunk's mesh after one tile edit,
+//   - memory for the chunks loaded around the player at the same view distance in tiles,
+//   - draw calls for a 2560x1440 view at the sprite and impostor zoom levels.
+// The game itself is built with one edge, CHUNK_SIZE (-DCHUNK_EDGE=N); this compares the
+// candidates without rebuilding.
+//
+// Usage: chunkbench [--tiles N] [--view-tiles N] [--seed N]
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "constants.h"
+#include "chunk.h"
+#include "map.h"
+#include "worldgen.h"
+#include "benchutil.h"
+
+namespace {
+    struct ConfigResult {
+        int size = 0;
+        int chunks = 0;
+        double tilesPerMillisecond = 0.0;
+        double noisePerChunk = 0.0;
+        double maxLoadMilliseconds = 0.0;
+        double meshRebuildMicroseconds = 0.0;
+        int streamRadius = 0;           // Chunks each way covering the view distance
+        double residentMegabytes = 0.0;
+        int drawCalls[3] = { 0, 0, 0 }; // Sprites at zoom 1, fine impostors at zoom 4, coarse at zoom 16
+    };
+
+    // What Map::loadChunks does to a freshly generated chunk, minus the cache and world ticking
+    template <int Size>
+    void loadChunk(BasicChunk<Size>& chunk, WorldGenerator& generator) {
+        generator.generateChunk<Size>(chunk.coord.x, chunk.coord.y, &chunk.tileTypes[0][0]);
+        for (int y = 0; y < Size; y++) {
+            for (int x = 0; x < Size; x++) {
+                chunk.solidTiles[y][x] = Map::isSolidType(chunk.tileTypes[y][x]);
+            }
+        }
+        chunk.rebuildResourceIndex();
+        chunk.rebuildMesh();
+        chunk.isLoaded = true;
+    }
+
+    template <int Size>
+    size_t chunkBytes(const BasicChunk<Size>& chunk) {
+        return sizeof(chunk) + sizeof(typename BasicChunk<Size>::Mesh) +
+            (chunk.treeTiles.capacity() + chunk.stoneTiles.capacity() + chunk.torchTiles.capacity()) * sizeof(std::uint16_t);
+    }
+
+    // Impostors drawn for a view of the given size centered on a tile, as in Simulation: the
+    // visible chunks that are loaded, plus the coarse layer for everything beyond them
+    template <int Size>
+    int impostorDrawCalls(sf::Vector2i centerTile, sf::Vector2f viewSize, int streamRadius) {
+        int startX, startY, endX, endY;
+        Map::getVisibleTileRange(tileCenter(centerTile.x, centerTile.y), viewSize, startX, startY, endX, endY);
+        int chunksX = floorDiv(endX - 1, Size) - floorDiv(startX, Size) + 1;
+        int chunksY = floorDiv(endY - 1, Size) - floorDiv(startY, Size) + 1;
+        int loadedSide = 2 * streamRadius + 1;
+        return std::min(chunksX, loadedSide) * std::min(chunksY, loadedSide) + 1;
+    }
+
+    template <int Size>
+    ConfigResult runConfig(std::uint32_t seed, int areaTiles, int viewTiles) {
+        ConfigResult result;
+        result.size = Size;
+
+        // A fresh generator per configuration, so none starts with a warm noise cache
+        WorldGenerator generator(seed);
+        int areaChunks = std::max(1, areaTiles / Size);
+        std::vector<std::unique_ptr<BasicChunk<Size>>> chunks;
+        chunks.reserve(static_cast<size_t>(areaChunks) * areaChunks);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int chunkY = 0; chunkY < areaChunks; chunkY++) {
+            for (int chunkX = 0; chunkX < areaChunks; chunkX++) {
+                auto loadStart = std::chrono::steady_clock::now();
+                auto chunk = std::make_unique<BasicChunk<Size>>(ChunkCoord{ chunkX, chunkY });
+                loadChunk(*chunk, generator);
+                result.maxLoadMilliseconds = std::max(result.maxLoadMilliseconds, millisecondsSince(loadStart));
+                chunks.push_back(std::move(chunk));
+            }
+        }
+        double totalMilliseconds = millisecondsSince(start);
+        result.chunks = static_cast<int>(chunks.size());
+        result.tilesPerMillisecond = static_cast<double>(result.chunks) * Size * Size / totalMilliseconds;
+        result.noisePerChunk = static_cast<double>(generator.noiseEvaluations) / result.chunks;
+
+        // One tile edit rebuilds the mesh of its whole chunk
+        const int rebuilds = 20000;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rebuilds; i++) {
+            BasicChunk<Size>& chunk = *chunks[i % chunks.size()];
+            chunk.tileTypes[i % Size][(i / Size) % Size] = TileType::DIRT;
+            chunk.rebuildMesh();
+        }
+        result.meshRebuildMicroseconds = millisecondsSince(start) * 1000.0 / rebuilds;
+
+        // The streamer keeps a square of (2r + 1)^2 chunks; r is chosen to see as far as the default
+        size_t averageBytes = 0;
+        for (const auto& chunk : chunks) {
+            averageBytes += chunkBytes(*chunk);
+        }
+        averageBytes /= chunks.size();
+        result.streamRadius = (viewTiles + Size - 1) / Size;
+        int streamed = (2 * result.streamRadius + 1) * (2 * result.streamRadius + 1);
+        result.residentMegabytes = static_cast<double>(streamed) * averageBytes / (1024.0 * 1024.0);
+
+        // At zoom 1 every tile is a sprite; zoomed out, every chunk is one impostor sprite
+        const sf::Vector2f baseView{ 2560, 1440 };
+        const float zooms[3] = { 1.0f, 4.0f, MAX_CAMERA_ZOOM };
+        sf::Vector2i centerTile{ areaTiles / 2, areaTiles / 2 };
+        int startX, startY, endX, endY;
+        Map::getVisibleTileRange(tileCenter(centerTile.x, centerTile.y), baseView, startX, startY, endX, endY);
+        result.drawCalls[0] = (endX - startX) * (endY - startY);
+        for (int level = 1; level < 3; level++) {
+            result.drawCalls[level] = impostorDrawCalls<Size>(centerTile, baseView * zooms[level], result.streamRadius);
+        }
+        return result;
+    }
+
+    void report(const ConfigResult& result) {
+        std::cout << std::setw(4) << result.size << "  "
+            << std::setw(6) << result.chunks << "  "
+            << std::setw(9) << std::fixed << std::setprecision(1) << result.tilesPerMillisecond << "  "
+            << std::setw(11) << result.noisePerChunk << "  "
+            << std::setw(8) << std::setprecision(3) << result.maxLoadMilliseconds << "  "
+            << std::setw(9) << std::setprecision(2) << result.meshRebuildMicroseconds << "  "
+            << std::setw(6) << result.streamRadius << "  "
+            << std::setw(8) << std::setprecision(1) << result.residentMegabytes << "  "
+            << std::setw(6) << result.drawCalls[0] << "  "
+            << std::setw(6) << result.drawCalls[1] << "  "
+            << std::setw(6) << result.drawCalls[2] << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int areaTiles = 512;
+    int viewTiles = RENDER_DISTANCE * CHUNK_SIZE; // What the default build streams around the player
+    std::uint32_t seed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--tiles" && hasValue) areaTiles = std::max(64, std::atoi(argv[++i]));
+        else if (arg == "--view-tiles" && hasValue) viewTiles = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else {
+            std::cout << "Usage: chunkbench [--tiles N] [--view-tiles N] [--seed N]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Generating " << areaTiles << "x" << areaTiles << " tiles per chunk size, streaming "
+        << viewTiles << " tiles each way (this build uses " << CHUNK_SIZE << "-tile chunks)" << std::endl;
+    std::cout << "size  chunks  tiles/ms  noise/chunk  max load  edit (us)  radius  resident  draws1  draws4  draws16" << std::endl;
+    report(runConfig<8>(seed, areaTiles, viewTiles));
+    report(runConfig<16>(seed, areaTiles, viewTiles));
+    report(runConfig<32>(seed, areaTiles, viewTiles));
+    report(runConfig<64>(seed, areaTiles, viewTiles));
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "chunkcache.h"
+#include <algorithm>
+
+size_t CompressedChunk::memoryBytes() const {
+    // Entry itself, its list node and hash bucket, plus the payload
+    return sizeof(CompressedChunk) + 4 * sizeof(void*) +
+        palette.capacity() * sizeof(TileType) +
+        runs.capacity() * sizeof(TileRun);
+}
+
+void compressChunk(const Chunk& chunk, CompressedChunk& compressed) {
+    compressed.coord = chunk.coord;
+    compressed.palette.clear();
+    compressed.runs.clear();
+
+    // Rows are contiguous, so the whole chunk can be scanned as one array
+    const TileType* tiles = &chunk.tileTypes[0][0];
+    const int tileCount = CHUNK_SIZE * CHUNK_SIZE;
+
+    int i = 0;
+    while (i < tileCount) {
+        TileType type = tiles[i];
+        int runLength = 1;
+        while (i + runLength < tileCount && tiles[i + runLength] == type && runLength < 0xFFFF) {
+            runLength++;
+        }
+
+        auto paletteIt = std::find(compressed.palette.begin(), compressed.palette.end(), type);
+        if (paletteIt == compressed.palette.end()) {
+            compressed.palette.push_back(type);
+            paletteIt = compressed.palette.end() - 1;
+        }
+
+        compressed.runs.push_back({
+            static_cast<std::uint8_t>(paletteIt - compressed.palette.begin()),
+            static_cast<std::uint16_t>(runLength)
+            });
+        i += runLength;
+    }
+}
+
+void decompressChunk(const CompressedChunk& compressed, TileType* tiles) {
+    int position = 0;
+    for (const TileRun& run : compressed.runs) {
+        std::fill(tiles + position, tiles + position + run.length, compressed.palette[run.paletteIndex]);
+        position += run.length;
+    }
+}
+
+ChunkCache::ChunkCache(size_t budgetBytes) : memoryBudget(budgetBytes) {
+}
+
+void ChunkCache::setMemoryBudget(size_t budgetBytes) {
+    memoryBudget = budgetBytes;
+    evictToBudget();
+}
+
+void ChunkCache::store(const Chunk& chunk) {
+    auto existing = entries.find(chunk.coord);
+    if (existing != entries.end()) {
+        erase(existing->second);
+    }
+
+    CompressedChunk compressed;
+    compressChunk(chunk, compressed);
+    compressed.palette.shrink_to_fit();
+    compressed.runs.shrink_to_fit();
+
+    stats.usedBytes += compressed.memoryBytes();
+    lru.push_front(std::move(compressed));
+    entries[chunk.coord] = lru.begin();
+    stats.entries = entries.size();
+
+    evictToBudget();
+}
+
+bool ChunkCache::restore(ChunkCoord coord, Chunk& chunk) {
+    auto it = entries.find(coord);
+    if (it == entries.end()) {
+        stats.misses++;
+        return false;
+    }
+
+    decompressChunk(*it->second, &chunk.tileTypes[0][0]);
+
+    stats.hits++;
+    erase(it->second);
+    return true;
+}
+
+void ChunkCache::clear() {
+    lru.clear();
+    entries.clear();
+    stats.usedBytes = 0;
+    stats.entries = 0;
+}
+
+void ChunkCache::erase(std::list<CompressedChunk>::iterator it) {
+    stats.usedBytes -= it->memoryBytes();
+    entries.erase(it->coord);
+    lru.erase(it);
+    stats.entries = entries.size();
+}
+
+void ChunkCache::evictToBudget() {
+    while (stats.usedBytes > memoryBudget && !lru.empty()) {
+        erase(std::prev(lru.end()));
+        stats.evictions++;
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef CHUNKCACHE_H
+#define CHUNKCACHE_H
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "chunk.h"
+#include "utils.h"
+
+// Run of identical tiles in row-major chunk order
+struct TileRun {
+    std::uint8_t paletteIndex;
+    std::uint16_t length;
+};
+
+// Compact form of an unloaded chunk: palette of distinct tile types plus RLE runs.
+// Tile types are captured after edits (felled trees, mined stone), so a hit restores
+// the edited state directly; Map::worldEdits stays the durable record across evictions.
+struct CompressedChunk {
+    ChunkCoord coord;
+    std::vector<TileType> palette;
+    std::vector<TileRun> runs;
+
+    size_t memoryBytes() const;
+};
+
+// Palette and runs of a chunk's current tiles, shared by the cache and the network stream
+void compressChunk(const Chunk& chunk, CompressedChunk& compressed);
+void decompressChunk(const CompressedChunk& compressed, TileType* tiles); // CHUNK_SIZE * CHUNK_SIZE, row-major
+
+struct ChunkCacheStats {
+    long long hits = 0;
+    long long misses = 0;
+    long long evictions = 0;
+    size_t usedBytes = 0;
+    size_t entries = 0;
+};
+
+// Second-tier LRU cache for recently unloaded chunks, bounded by a memory budget
+class ChunkCache {
+public:
+    explicit ChunkCache(size_t budgetBytes = CHUNK_CACHE_BUDGET_BYTES);
+
+    void setMemoryBudget(size_t budgetBytes);
+    size_t getMemoryBudget() const { return memoryBudget; }
+
+    void store(const Chunk& chunk);
+    bool restore(ChunkCoord coord, Chunk& chunk); // Fills chunk.tileTypes and drops the entry on a hit
+    void clear();
+
+    const ChunkCacheStats& getStats() const { return stats; }
+
+private:
+    std::list<CompressedChunk> lru; // Most recently stored at the front
+    std::unordered_map<ChunkCoord, std::list<CompressedChunk>::iterator, ChunkCoordHash> entries;
+    size_t memoryBudget;
+    ChunkCacheStats stats;
+
+    void erase(std::list<CompressedChunk>::iterator it);
+    void evictToBudget();
+};
+
+#endif
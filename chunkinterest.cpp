@@ -0,0 +1,197 @@
+#include "chunkinterest.h"
+#include "constants.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    int chunkDistance(ChunkCoord a, ChunkCoord b) {
+        return static_cast<int>(std::max(std::llabs(a.x - b.x), std::llabs(a.y - b.y)));
+    }
+
+    // Calls visit for every chunk within radius of center but not within skipRadius of
+    // skipCenter, inside the world if bounded; rows crossing the skipped square jump over it
+    template <typename Visit>
+    void forEachChunkOutside(bool bounded, ChunkCoord center, int radius, ChunkCoord skipCenter, int skipRadius, Visit visit) {
+        std::int64_t minY = center.y - radius;
+        std::int64_t maxY = center.y + radius;
+        std::int64_t minX = center.x - radius;
+        std::int64_t maxX = center.x + radius;
+        if (bounded) {
+            minY = std::max<std::int64_t>(minY, 0);
+            maxY = std::min<std::int64_t>(maxY, CHUNKS_Y - 1);
+            minX = std::max<std::int64_t>(minX, 0);
+            maxX = std::min<std::int64_t>(maxX, CHUNKS_X - 1);
+        }
+        for (std::int64_t y = minY; y <= maxY; y++) {
+            bool crossesSkip = skipRadius >= 0 && std::llabs(y - skipCenter.y) <= skipRadius;
+            for (std::int64_t x = minX; x <= maxX; x++) {
+                if (crossesSkip && std::llabs(x - skipCenter.x) <= skipRadius) {
+                    x = skipCenter.x + skipRadius;
+                    continue;
+                }
+                visit(ChunkCoord{ x, y });
+            }
+        }
+    }
+}
+
+ChunkInterest::ObserverId ChunkInterest::addObserver(ChunkCoord center, int loadRadius, int keepRadius) {
+    ObserverId id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    else {
+        id = static_cast<ObserverId>(observers.size());
+        observers.emplace_back();
+    }
+
+    // Keeping less than is wanted would unload chunks the observer is still asking for
+    keepRadius = std::max(keepRadius, loadRadius);
+    observers[id] = { center, loadRadius, keepRadius, true };
+    observerCount++;
+
+    adjustKept(center, keepRadius, 1, center, -1);
+    adjustWanted(center, loadRadius, 1, center, -1);
+    return id;
+}
+
+void ChunkInterest::removeObserver(ObserverId id) {
+    if (id < 0 || id >= static_cast<ObserverId>(observers.size()) || !observers[id].active) {
+        return;
+    }
+
+    Observer& observer = observers[id];
+    adjustWanted(observer.center, observer.loadRadius, -1, observer.center, -1);
+    adjustKept(observer.center, observer.keepRadius, -1, observer.center, -1);
+    observer.active = false;
+    observerCount--;
+    freeIds.push_back(id);
+}
+
+void ChunkInterest::moveObserver(ObserverId id, ChunkCoord center) {
+    Observer& observer = observers[id];
+    if (observer.center == center) {
+        return;
+    }
+
+    // Only the chunks in one square and not the other change; gains first, so a chunk in
+    // both squares never touches zero on the way
+    ChunkCoord previous = observer.center;
+    observer.center = center;
+    adjustKept(center, observer.keepRadius, 1, previous, observer.keepRadius);
+    adjustWanted(center, observer.loadRadius, 1, previous, observer.loadRadius);
+    adjustWanted(previous, observer.loadRadius, -1, center, observer.loadRadius);
+    adjustKept(previous, observer.keepRadius, -1, center, observer.keepRadius);
+}
+
+void ChunkInterest::setRadius(ObserverId id, int loadRadius, int keepRadius) {
+    Observer& observer = observers[id];
+    keepRadius = std::max(keepRadius, loadRadius);
+    if (observer.loadRadius == loadRadius && observer.keepRadius == keepRadius) {
+        return;
+    }
+
+    adjustKept(observer.center, keepRadius, 1, observer.center, -1);
+    adjustWanted(observer.center, loadRadius, 1, observer.center, -1);
+    adjustWanted(observer.center, observer.loadRadius, -1, observer.center, -1);
+    adjustKept(observer.center, observer.keepRadius, -1, observer.center, -1);
+    observer.loadRadius = loadRadius;
+    observer.keepRadius = keepRadius;
+}
+
+void ChunkInterest::onChunkLoaded(ChunkCoord chunk) {
+    ChunkCounts& chunkCounts = counts[chunk];
+    chunkCounts.loaded = true;
+    pendingLoads.erase(chunk);
+
+    // Loaded by someone else (a tool, a benchmark); unloading it is the caller's choice
+    if (chunkCounts.kept == 0) {
+        pendingUnloads.insert(chunk);
+    }
+}
+
+void ChunkInterest::onChunkUnloaded(ChunkCoord chunk) {
+    auto it = counts.find(chunk);
+    if (it == counts.end()) {
+        return;
+    }
+
+    it->second.loaded = false;
+    pendingUnloads.erase(chunk);
+    if (it->second.wanted > 0) {
+        pendingLoads[chunk] = 0;
+    }
+    release(chunk, it->second);
+}
+
+int ChunkInterest::getWantedCount(ChunkCoord chunk) const {
+    auto it = counts.find(chunk);
+    return (it != counts.end()) ? it->second.wanted : 0;
+}
+
+int ChunkInterest::getKeptCount(ChunkCoord chunk) const {
+    auto it = counts.find(chunk);
+    return (it != counts.end()) ? it->second.kept : 0;
+}
+
+void ChunkInterest::collectLoads(int budget, std::vector<ChunkCoord>& out) {
+    out.clear();
+    budget = std::min(budget, static_cast<int>(pendingLoads.size()));
+    if (budget <= 0) {
+        return;
+    }
+
+    loadScratch.clear();
+    for (const auto& entry : pendingLoads) {
+        loadScratch.push_back({ entry.second, entry.first });
+    }
+    std::partial_sort(loadScratch.begin(), loadScratch.begin() + budget, loadScratch.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (int i = 0; i < budget; i++) {
+        out.push_back(loadScratch[i].second);
+    }
+}
+
+void ChunkInterest::adjustWanted(ChunkCoord center, int radius, int delta, ChunkCoord skipCenter, int skipRadius) {
+    forEachChunkOutside(bounded, center, radius, skipCenter, skipRadius, [&](ChunkCoord chunk) {
+        ChunkCounts& chunkCounts = counts[chunk];
+        if (delta > 0) {
+            if (chunkCounts.wanted++ == 0 && !chunkCounts.loaded) {
+                pendingLoads[chunk] = chunkDistance(chunk, center);
+            }
+            else if (!chunkCounts.loaded) {
+                int& ring = pendingLoads[chunk];
+                ring = std::min(ring, chunkDistance(chunk, center));
+            }
+        }
+        else if (--chunkCounts.wanted == 0) {
+            pendingLoads.erase(chunk);
+            release(chunk, chunkCounts);
+        }
+    });
+}
+
+void ChunkInterest::adjustKept(ChunkCoord center, int radius, int delta, ChunkCoord skipCenter, int skipRadius) {
+    forEachChunkOutside(bounded, center, radius, skipCenter, skipRadius, [&](ChunkCoord chunk) {
+        ChunkCounts& chunkCounts = counts[chunk];
+        if (delta > 0) {
+            if (chunkCounts.kept++ == 0) {
+                pendingUnloads.erase(chunk);
+            }
+        }
+        else if (--chunkCounts.kept == 0) {
+            if (chunkCounts.loaded) {
+                pendingUnloads.insert(chunk);
+            }
+            release(chunk, chunkCounts);
+        }
+    });
+}
+
+void ChunkInterest::release(ChunkCoord chunk, const ChunkCounts& chunkCounts) {
+    // Entries for chunks nobody counts and that aren't loaded carry no information
+    if (chunkCounts.wanted == 0 && chunkCounts.kept == 0 && !chunkCounts.loaded) {
+        counts.erase(chunk);
+    }
+}
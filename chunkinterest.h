@@ -0,0 +1,78 @@
+#ifndef CHUNKINTEREST_H
+#define CHUNKINTEREST_H
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
+#include "chunk.h"
+#include "utils.h"
+
+// Which chunks should be resident, for any number of observers (the player, split-screen
+// views, spectator cameras, the players on a server). Each observer wants the square of
+// chunks within its load radius and keeps loaded ones out to its keep radius; every chunk
+// counts the observers wanting and keeping it. A chunk is loaded once however many observers
+// share it, and may be unloaded only when nothing keeps it.
+//
+// Counts change only when an observer crosses a chunk border, by the squares it left and
+// entered. Chunks waiting to load or unload are kept in sets, so nothing scans the map.
+class ChunkInterest {
+public:
+    using ObserverId = int;
+
+    bool bounded = true; // Squares stop at the CHUNKS_X x CHUNKS_Y world; Map clears it for an infinite world
+
+    ObserverId addObserver(ChunkCoord center, int loadRadius, int keepRadius);
+    void removeObserver(ObserverId id);
+    void moveObserver(ObserverId id, ChunkCoord center);
+    void setRadius(ObserverId id, int loadRadius, int keepRadius);
+    ChunkCoord getCenter(ObserverId id) const { return observers[id].center; }
+    int getObserverCount() const { return observerCount; }
+    size_t getTrackedChunks() const { return counts.size(); } // Chunks counted, loaded or pending
+
+    // Map reports residency so the pending sets stay exact whoever loads or unloads
+    void onChunkLoaded(ChunkCoord chunk);
+    void onChunkUnloaded(ChunkCoord chunk);
+
+    int getWantedCount(ChunkCoord chunk) const;
+    int getKeptCount(ChunkCoord chunk) const;
+
+    // Wanted but not loaded, with the ring (in chunks) from the nearest observer that asked;
+    // chunks unloaded while still wanted come back at ring 0
+    const std::unordered_map<ChunkCoord, int, ChunkCoordHash>& getPendingLoads() const { return pendingLoads; }
+    // Loaded but kept by nobody
+    const std::unordered_set<ChunkCoord, ChunkCoordHash>& getPendingUnloads() const { return pendingUnloads; }
+
+    // Up to budget pending loads, lowest ring first
+    void collectLoads(int budget, std::vector<ChunkCoord>& out);
+
+private:
+    struct Observer {
+        ChunkCoord center{ 0, 0 };
+        int loadRadius = 0;
+        int keepRadius = 0;
+        bool active = false;
+    };
+
+    struct ChunkCounts {
+        std::uint16_t wanted = 0;
+        std::uint16_t kept = 0;
+        bool loaded = false;
+    };
+
+    std::vector<Observer> observers;
+    std::vector<ObserverId> freeIds;
+    int observerCount = 0;
+
+    std::unordered_map<ChunkCoord, ChunkCounts, ChunkCoordHash> counts; // Only chunks with a count or loaded
+    std::unordered_map<ChunkCoord, int, ChunkCoordHash> pendingLoads;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> pendingUnloads;
+    std::vector<std::pair<int, ChunkCoord>> loadScratch;
+
+    // Adds delta to every chunk within radius of center, skipping those within skipRadius of skipCenter
+    void adjustWanted(ChunkCoord center, int radius, int delta, ChunkCoord skipCenter, int skipRadius);
+    void adjustKept(ChunkCoord center, int radius, int delta, ChunkCoord skipCenter, int skipRadius);
+    void release(ChunkCoord chunk, const ChunkCounts& chunkCounts);
+};
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
+#include <cstddef>
+#include <cstdint>
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -8,21 +11,97 @@
 // Map settings
 const int TILE_SIZE = 64;
 const int WORLD_WIDTH = 2000;
-const int WORLD_HEIGHT = 2000;
+const int WORLD_HEIGHT = 2000;             // Edges of the world, unless the map is infinite
+const int INFINITE_WORLD_LIMIT = 1 << 30;   // Tiles from 0 an infinite world reaches; tile math stays in int
+const int RENDER_ORIGIN_REBASE_CHUNKS = 64; // The render origin follows the player in steps this far apart
+
+// Chunk system. The chunk edge is chosen at build time with -DCHUNK_EDGE=8, 16, 32 or 64;
+// baked worlds, saves, recordings and the network protocol only accept their own edge.
+#ifndef CHUNK_EDGE
+#define CHUNK_EDGE 16
+#endif
+const int CHUNK_SIZE = CHUNK_EDGE;
+const int CHUNKS_X = (WORLD_WIDTH + CHUNK_SIZE - 1) / CHUNK_SIZE;
+const int CHUNKS_Y = (WORLD_HEIGHT + CHUNK_SIZE - 1) / CHUNK_SIZE;
+const int RENDER_DISTANCE = 8;              // Default streaming radius in chunks, see ChunkStreamer::setRenderDistance
+const int MAX_RENDER_DISTANCE = 32;
+const std::size_t CHUNK_CACHE_BUDGET_BYTES = 4 * 1024 * 1024; // Second-tier cache for unloaded chunks
+
+// Saving
+const float AUTOSAVE_INTERVAL = 60.0f; // Seconds between background autosaves
+
+// Camera zoom and level of detail
+const float MAX_CAMERA_ZOOM = 16.0f;
+const float LOD_SPRITE_MIN_TILE_PIXELS = 32.0f;   // Below this on-screen tile size, chunks draw as impostors
+const float LOD_FINE_IMPOSTOR_MIN_TILE_PIXELS = 8.0f;
+const int IMPOSTOR_LEVELS = 2;
+const int IMPOSTOR_TILE_RESOLUTIONS[IMPOSTOR_LEVELS] = { 16, 4 }; // Impostor pixels per tile, fine to coarse
+const int IMPOSTOR_BUILDS_PER_FRAME = 8;
+const int COARSE_LAYER_UPDATES_PER_FRAME = 64;
+const int COARSE_LAYER_CHUNKS = 256;        // Coarse layer window around the camera, one pixel per chunk
+const int TILEMAP_WINDOW_CHUNKS = 16;       // Ring of chunks in the tilemap shader's tile texture, each way
+const int TILEMAP_ATLAS_CELL = 64;          // Pixels per tile type in the tilemap atlas
+const int TILEMAP_MASK_CELL = 32;           // Pixels per autotile shape in the tilemap's edge masks
+const int AUTOTILE_SHAPES = 47;             // Distinct terrain edge shapes, see autotile.h
+
+// Entities
+const int ENTITY_HASH_BUCKETS = 4096;   // Spatial hash buckets (power of two), keyed on chunk coordinates
+const float ENTITY_SIZE = TILE_SIZE * 0.5f;
+const int ENTITY_ATLAS_CELL = 16;       // Pixels per sprite in the entity atlas
+const int MAX_MOBS = 500;
+const float MOB_SPEED = 48.0f;          // Pixels per second while wandering or chasing
+const float ITEM_MERGE_RADIUS = TILE_SIZE * 1.5f;  // Dropped stacks of one item closer than this merge
+const float ITEM_PICKUP_RADIUS = TILE_SIZE * 1.25f;
+const int MAX_ITEM_DROPS = 256;
+
+// Rivers: centerlines traced per region, see RiverDistanceField
+const float RIVER_HALF_WIDTH = 8.0f;        // Tiles from a centerline that are river
+const int RIVER_VERTEX_SPACING = 16;        // Tiles between centerline vertices along a river's course
+const int RIVER_REGION_TILES = 512;         // Each region's distance field is built on first use
+const int RIVER_FIELD_CELL = 4;             // Tiles per distance field cell
+const int RIVER_FIELD_MAX_DISTANCE = 32;    // Distances beyond this read as this
+
+// World ticking (in simulation ticks, 60 per second)
+const int TREE_REGROW_TICKS = 60 * 60 * 5;  // Felled trees grow back after about five minutes
+const int REGROW_RETRY_TICKS = 60 * 5;      // Delay when someone is standing on the tile
+const int RANDOM_TICKS_PER_CHUNK = 1;       // Random tile updates per loaded chunk per tick
+const float GRASS_SPREAD_CHANCE = 0.02f;    // Per random update of dirt next to grass
+
+// Water flow
+const int WATER_STEP_TICKS = 4;             // Simulation ticks per water step
+const int WATER_FLOOD_LEVEL = 192;          // Dirt filled this far (of 255) becomes a water tile
+
+// Pathfinding
+const int PATH_LONG_ENTRANCE = 6;           // Border openings this wide get an entrance at each end
+const int MAX_PATH_EXPANSIONS = 200000;     // Abstract nodes a query may expand before giving up
+const float PATH_ARRIVE_DISTANCE = TILE_SIZE * 0.25f; // Close enough to a path tile's center to take the next
+const int FLOW_FIELD_CHUNK_RADIUS = RENDER_DISTANCE; // Chunks the shared chase field spans around the player
+const int FLOW_FIELD_RANGE = 24;            // Walking distance in tiles at which mobs notice the player
+
+// Networking
+const unsigned short SERVER_PORT = 47300;
+const float SERVER_TICK_RATE = 30.0f;      // Authoritative simulation ticks per second
+const int SERVER_INTEREST_RADIUS = 3;       // Chunks each way a client is sent around its player
+const int SERVER_CHUNKS_PER_TICK = 6;       // Chunk payloads per client per tick, nearest first
+const int SERVER_LOADS_PER_TICK = 16;       // Chunks the server loads per tick for all players together
+const int SERVER_PLAYER_UPDATE_TICKS = 3;   // Other players' positions go out every this many ticks
+const int SERVER_MAX_VISIBLE_PLAYERS = 32;  // Nearest other players included in each update
+const int SERVER_SPAWN_RADIUS = 48;         // Tiles around the world spawn new players are spread over
 
-// Chunk system
-const int CHUNK_SIZE = 16;
-const int CHUNKS_X = WORLD_WIDTH / CHUNK_SIZE;
-const int CHUNKS_Y = WORLD_HEIGHT / CHUNK_SIZE;
-const int RENDER_DISTANCE = 8;
+// Lighting
+const int TORCH_LIGHT = 12;                 // Light level at a torch, one less per tile away
+const int LIGHT_REACH_CHUNKS = (TORCH_LIGHT - 1 + CHUNK_SIZE - 1) / CHUNK_SIZE; // Chunks away a torch can still light
+const int DAY_LENGTH_TICKS = 60 * 60 * 10;  // Ten minutes per day and night
+const float DAY_START_TIME = 0.3f;          // Time of day at the first tick (0 = midnight, 0.5 = noon)
 
 // Enums
-enum class TileType {
+enum class TileType : std::uint8_t {
     GRASS = 0,
     WATER = 1,
     STONE = 2,
     TREE = 3,
-    DIRT = 4  // New dirt tile type
+    DIRT = 4,  // New dirt tile type
+    TORCH = 5  // Placed torch, lights the tiles around it
 };
 
 enum class BiomeType {
@@ -0,0 +1,352 @@
+#include "entities.h"
+#include "map.h"
+#include "flowfield.h"
+#include <cmath>
+#include <iostream>
+#include <cstdint>
+#include <algorithm>
+
+namespace {
+    std::uint32_t nextRandom(std::uint32_t& state) {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    const float DIAGONAL = 0.70710678f;
+    const float WANDER_DIRECTIONS[8][2] = {
+        { 1.0f, 0.0f }, { DIAGONAL, DIAGONAL }, { 0.0f, 1.0f }, { -DIAGONAL, DIAGONAL },
+        { -1.0f, 0.0f }, { -DIAGONAL, -DIAGONAL }, { 0.0f, -1.0f }, { DIAGONAL, -DIAGONAL }
+    };
+
+    const double CHUNK_PIXELS = static_cast<double>(CHUNK_SIZE * TILE_SIZE);
+}
+
+int EntitySystem::spawn(double x, double y, EntitySprite entitySprite) {
+    positionX.push_back(x);
+    positionY.push_back(y);
+    velocityX.push_back(0.0f);
+    velocityY.push_back(0.0f);
+    sprite.push_back(static_cast<std::uint16_t>(entitySprite));
+    aiState.push_back(AIState::IDLE);
+    aiTimer.push_back(0.0f);
+
+    // Distinct, never-zero seed per entity
+    nextSeed += 0x9E3779B9u;
+    rngState.push_back(nextSeed | 1u);
+
+    spatialHashValid = false;
+    return size() - 1;
+}
+
+void EntitySystem::despawn(int index) {
+    int last = size() - 1;
+    if (index < 0 || index > last) {
+        return;
+    }
+
+    positionX[index] = positionX[last];
+    positionY[index] = positionY[last];
+    velocityX[index] = velocityX[last];
+    velocityY[index] = velocityY[last];
+    sprite[index] = sprite[last];
+    aiState[index] = aiState[last];
+    aiTimer[index] = aiTimer[last];
+    rngState[index] = rngState[last];
+
+    positionX.pop_back();
+    positionY.pop_back();
+    velocityX.pop_back();
+    velocityY.pop_back();
+    sprite.pop_back();
+    aiState.pop_back();
+    aiTimer.pop_back();
+    rngState.pop_back();
+
+    spatialHashValid = false;
+}
+
+void EntitySystem::clear() {
+    positionX.clear();
+    positionY.clear();
+    velocityX.clear();
+    velocityY.clear();
+    sprite.clear();
+    aiState.clear();
+    aiTimer.clear();
+    rngState.clear();
+    spatialHashValid = false;
+}
+
+ChunkCoord EntitySystem::chunkOf(double x, double y) {
+    return {
+        static_cast<std::int64_t>(std::floor(x / CHUNK_PIXELS)),
+        static_cast<std::int64_t>(std::floor(y / CHUNK_PIXELS))
+    };
+}
+
+int EntitySystem::bucketOf(ChunkCoord chunk) {
+    std::uint32_t hash = (static_cast<std::uint32_t>(chunk.x) * 73856093u) ^ (static_cast<std::uint32_t>(chunk.y) * 19349663u);
+    return static_cast<int>(hash & (ENTITY_HASH_BUCKETS - 1));
+}
+
+void EntitySystem::rebuildSpatialHash() {
+    int count = size();
+    bucketStart.assign(ENTITY_HASH_BUCKETS + 1, 0);
+    entityBucket.resize(count);
+    bucketEntities.resize(count);
+
+    for (int i = 0; i < count; i++) {
+        int bucket = bucketOf(chunkOf(positionX[i], positionY[i]));
+        entityBucket[i] = bucket;
+        bucketStart[bucket + 1]++;
+    }
+    for (int bucket = 0; bucket < ENTITY_HASH_BUCKETS; bucket++) {
+        bucketStart[bucket + 1] += bucketStart[bucket];
+    }
+
+    bucketCursor.assign(bucketStart.begin(), bucketStart.end() - 1);
+    for (int i = 0; i < count; i++) {
+        bucketEntities[bucketCursor[entityBucket[i]]++] = i;
+    }
+
+    spatialHashValid = true;
+}
+
+void EntitySystem::think(int index, float dt) {
+    aiTimer[index] -= dt;
+    if (aiTimer[index] > 0.0f) {
+        return;
+    }
+
+    // Pause a third of the time, otherwise walk one of eight directions for 1-4 seconds
+    std::uint32_t roll = nextRandom(rngState[index]);
+    if (roll % 3 == 0) {
+        aiState[index] = AIState::IDLE;
+        velocityX[index] = 0.0f;
+        velocityY[index] = 0.0f;
+    }
+    else {
+        const float* direction = WANDER_DIRECTIONS[(roll >> 8) & 7];
+        aiState[index] = AIState::WANDER;
+        velocityX[index] = direction[0] * MOB_SPEED;
+        velocityY[index] = direction[1] * MOB_SPEED;
+    }
+    aiTimer[index] = 1.0f + static_cast<float>((roll >> 16) % 3000) / 1000.0f;
+}
+
+void EntitySystem::update(float dt, const Map& gameMap, const FlowField* chaseField) {
+    if (!spatialHashValid) {
+        rebuildSpatialHash();
+    }
+
+    // Walking the hash order keeps entities of the same chunk together, so the
+    // chunk lookup below is usually a hit on the previous entity's chunk
+    ChunkCoord cachedCoord = { INT64_MIN, INT64_MIN };
+    const Chunk* cachedChunk = nullptr;
+    auto findChunk = [&](int tileX, int tileY) {
+        ChunkCoord coord = chunkOfTile(tileX, tileY);
+        if (!(coord == cachedCoord)) {
+            cachedCoord = coord;
+            cachedChunk = gameMap.findChunk(coord);
+        }
+        return cachedChunk;
+    };
+
+    // Outside the world and in unloaded chunks counts as solid
+    auto isBlocked = [&](double x, double y) {
+        sf::Vector2i tile = tileOf({ x, y });
+        if (!gameMap.isInWorld(tile.x, tile.y)) {
+            return true;
+        }
+        const Chunk* chunk = findChunk(tile.x, tile.y);
+        return !chunk || chunk->solidTiles[floorMod(tile.y, CHUNK_SIZE)][floorMod(tile.x, CHUNK_SIZE)];
+    };
+
+    for (int index : bucketEntities) {
+        double x = positionX[index];
+        double y = positionY[index];
+
+        // Frozen until its chunk is loaded again
+        sf::Vector2i tile = tileOf({ x, y });
+        if (!gameMap.isInWorld(tile.x, tile.y) || !findChunk(tile.x, tile.y)) {
+            continue;
+        }
+
+        // Head for the center of the next tile toward the target while in range, one lookup per entity
+        sf::Vector2i step;
+        if (chaseField && chaseField->getStep(tile.x, tile.y, step)) {
+            float toX = static_cast<float>((tile.x + step.x + 0.5) * TILE_SIZE - x);
+            float toY = static_cast<float>((tile.y + step.y + 0.5) * TILE_SIZE - y);
+            float length = std::sqrt(toX * toX + toY * toY);
+            aiState[index] = AIState::CHASE;
+            velocityX[index] = toX / length * MOB_SPEED;
+            velocityY[index] = toY / length * MOB_SPEED;
+        }
+        else {
+            if (aiState[index] == AIState::CHASE) {
+                aiState[index] = AIState::IDLE; // Lost the trail or arrived; decide again right away
+                aiTimer[index] = 0.0f;
+            }
+            think(index, dt);
+        }
+
+        // Move one axis at a time; turn around when walking into something solid
+        double newX = x + velocityX[index] * dt;
+        if (isBlocked(newX, y)) {
+            velocityX[index] = -velocityX[index];
+        }
+        else {
+            x = newX;
+        }
+
+        double newY = y + velocityY[index] * dt;
+        if (isBlocked(x, newY)) {
+            velocityY[index] = -velocityY[index];
+        }
+        else {
+            y = newY;
+        }
+
+        positionX[index] = x;
+        positionY[index] = y;
+    }
+
+    rebuildSpatialHash();
+}
+
+void EntitySystem::queryRadius(double x, double y, float radius, std::vector<int>& out) {
+    out.clear();
+    if (!spatialHashValid) {
+        rebuildSpatialHash();
+    }
+
+    ChunkCoord minChunk = chunkOf(x - radius, y - radius);
+    ChunkCoord maxChunk = chunkOf(x + radius, y + radius);
+    double radiusSquared = static_cast<double>(radius) * radius;
+
+    for (std::int64_t chunkY = minChunk.y; chunkY <= maxChunk.y; chunkY++) {
+        for (std::int64_t chunkX = minChunk.x; chunkX <= maxChunk.x; chunkX++) {
+            ChunkCoord chunk = { chunkX, chunkY };
+            int bucket = bucketOf(chunk);
+            for (int k = bucketStart[bucket]; k < bucketStart[bucket + 1]; k++) {
+                int index = bucketEntities[k];
+
+                // Other chunks can share the bucket; only take this chunk's entities so none is reported twice
+                if (!(chunkOf(positionX[index], positionY[index]) == chunk)) {
+                    continue;
+                }
+
+                double dx = positionX[index] - x;
+                double dy = positionY[index] - y;
+                if (dx * dx + dy * dy <= radiusSquared) {
+                    out.push_back(index);
+                }
+            }
+        }
+    }
+}
+
+void EntitySystem::collectVisible(WorldRect area, const RenderOrigin& origin, EntityView& out) const {
+    out.positions.clear();
+    out.sprites.clear();
+
+    double left = area.position.x - ENTITY_SIZE;
+    double top = area.position.y - ENTITY_SIZE;
+    double right = area.position.x + area.size.x + ENTITY_SIZE;
+    double bottom = area.position.y + area.size.y + ENTITY_SIZE;
+
+    for (int i = 0; i < size(); i++) {
+        if (positionX[i] >= left && positionX[i] <= right && positionY[i] >= top && positionY[i] <= bottom) {
+            out.positions.push_back(origin.toLocal({ positionX[i], positionY[i] }));
+            out.sprites.push_back(sprite[i]);
+        }
+    }
+}
+
+EntityRenderer::EntityRenderer() {
+    // Draw the atlas procedurally; one ENTITY_ATLAS_CELL square per EntitySprite
+    const unsigned cell = static_cast<unsigned>(ENTITY_ATLAS_CELL);
+    sf::Image image({ cell * static_cast<unsigned>(EntitySprite::SPRITE_COUNT), cell }, sf::Color::Transparent);
+
+    // Critter: round brown body with two eyes
+    float center = (cell - 1) / 2.0f;
+    for (unsigned y = 0; y < cell; y++) {
+        for (unsigned x = 0; x < cell; x++) {
+            float dx = x - center;
+            float dy = y - center;
+            float distance = std::sqrt(dx * dx + dy * dy);
+            if (distance <= center - 1.0f) {
+                image.setPixel({ x, y }, sf::Color{ 150, 100, 60 });
+            }
+            else if (distance <= center) {
+                image.setPixel({ x, y }, sf::Color{ 80, 50, 30 });
+            }
+        }
+    }
+    image.setPixel({ cell / 2 - 3, cell / 2 - 2 }, sf::Color::Black);
+    image.setPixel({ cell / 2 + 2, cell / 2 - 2 }, sf::Color::Black);
+
+    // Dropped items: a log, a rock and a plain bag
+    unsigned wood = static_cast<unsigned>(EntitySprite::ITEM_WOOD) * cell;
+    for (unsigned y = cell / 2 - 3; y <= cell / 2 + 2; y++) {
+        for (unsigned x = 2; x < cell - 2; x++) {
+            bool edge = (y == cell / 2 - 3 || y == cell / 2 + 2 || x == 2 || x == cell - 3);
+            image.setPixel({ wood + x, y }, edge ? sf::Color{ 90, 50, 20 } : sf::Color{ 139, 69, 19 });
+        }
+    }
+
+    unsigned stone = static_cast<unsigned>(EntitySprite::ITEM_STONE) * cell;
+    unsigned bag = static_cast<unsigned>(EntitySprite::ITEM_OTHER) * cell;
+    for (unsigned y = 0; y < cell; y++) {
+        for (unsigned x = 0; x < cell; x++) {
+            float dx = x - center;
+            float dy = (y - center) * 1.4f;
+            if (std::sqrt(dx * dx + dy * dy) <= center - 2.0f) {
+                image.setPixel({ stone + x, y }, sf::Color{ 128, 128, 128 });
+            }
+            if (x >= 3 && x < cell - 3 && y >= 4 && y < cell - 2) {
+                image.setPixel({ bag + x, y }, sf::Color{ 200, 170, 110 });
+            }
+        }
+    }
+
+    if (!atlas.loadFromImage(image)) {
+        std::cout << "Could not create entity atlas" << std::endl;
+    }
+}
+
+void EntityRenderer::buildVertices(const EntityView& entities) {
+    const float half = ENTITY_SIZE / 2.0f;
+    const float cell = static_cast<float>(ENTITY_ATLAS_CELL);
+
+    vertices.resize(entities.positions.size() * 6);
+    for (size_t i = 0; i < entities.positions.size(); i++) {
+        sf::Vector2f position = entities.positions[i];
+        float u = entities.sprites[i] * cell;
+
+        sf::Vertex* quad = &vertices[i * 6];
+        quad[0].position = { position.x - half, position.y - half };
+        quad[1].position = { position.x + half, position.y - half };
+        quad[2].position = { position.x + half, position.y + half };
+        quad[3].position = quad[0].position;
+        quad[4].position = quad[2].position;
+        quad[5].position = { position.x - half, position.y + half };
+
+        quad[0].texCoords = { u, 0.0f };
+        quad[1].texCoords = { u + cell, 0.0f };
+        quad[2].texCoords = { u + cell, cell };
+        quad[3].texCoords = quad[0].texCoords;
+        quad[4].texCoords = quad[2].texCoords;
+        quad[5].texCoords = { u, cell };
+    }
+}
+
+void EntityRenderer::draw(sf::RenderWindow& window, const EntityView& entities) {
+    buildVertices(entities);
+    if (!entities.positions.empty()) {
+        window.draw(vertices, &atlas);
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+#include "constants.h"
+#include "chunk.h"
+
+class Map; // Forward declaration
+class FlowField;
+
+// Sprites in the entity atlas
+enum class EntitySprite : std::uint16_t {
+    CRITTER = 0,
+    ITEM_WOOD,
+    ITEM_STONE,
+    ITEM_OTHER,
+    SPRITE_COUNT
+};
+
+enum class AIState : std::uint8_t {
+    IDLE,
+    WANDER,
+    CHASE   // Following a flow field toward the player
+};
+
+// Visible entities handed to the render thread, positioned relative to the frame's RenderOrigin
+struct EntityView {
+    std::vector<sf::Vector2f> positions;
+    std::vector<std::uint16_t> sprites;
+};
+
+// Dynamic objects other than the player, stored as a struct of arrays: entity i is index i
+// in every component vector. Despawning swaps the last entity into the hole, so indices are
+// only stable until the next despawn. Entities in unloaded chunks are frozen.
+class EntitySystem {
+public:
+    // Components
+    std::vector<double> positionX;  // Pixels, entity center
+    std::vector<double> positionY;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<std::uint16_t> sprite;
+    std::vector<AIState> aiState;
+    std::vector<float> aiTimer;     // Seconds until the next AI decision
+    std::vector<std::uint32_t> rngState;
+
+    int spawn(double x, double y, EntitySprite entitySprite);
+    void despawn(int index);
+    void clear();
+    int size() const { return static_cast<int>(positionX.size()); }
+
+    // AI, movement against the map's solid tiles, then a spatial hash rebuild. Entities
+    // within reach of chaseField follow it instead of wandering.
+    void update(float dt, const Map& gameMap, const FlowField* chaseField = nullptr);
+
+    // Broadphase: entities whose center is within radius pixels of (x, y)
+    void queryRadius(double x, double y, float radius, std::vector<int>& out);
+
+    // Entities whose center is inside the pixel rectangle, relative to origin
+    void collectVisible(WorldRect area, const RenderOrigin& origin, EntityView& out) const;
+
+private:
+    // Uniform spatial hash on chunk coordinates, rebuilt every update with a counting sort:
+    // bucketEntities[bucketStart[b] .. bucketStart[b + 1]) are the entities hashed to bucket b.
+    std::vector<int> bucketStart;
+    std::vector<int> bucketEntities;
+    std::vector<int> entityBucket;
+    std::vector<int> bucketCursor;
+    bool spatialHashValid = false; // Spawning or despawning invalidates it until the next rebuild
+    std::uint32_t nextSeed = 0x9E3779B9u;
+
+    static ChunkCoord chunkOf(double x, double y);
+    static int bucketOf(ChunkCoord chunk);
+    void rebuildSpatialHash();
+    void think(int index, float dt);
+};
+
+// Draws every visible entity with one batched vertex array over a small sprite atlas
+class EntityRenderer {
+public:
+    sf::Texture atlas;
+    sf::VertexArray vertices{ sf::PrimitiveType::Triangles };
+
+    EntityRenderer();
+    void buildVertices(const EntityView& entities); // Two triangles per entity
+    void draw(sf::RenderWindow& window, const EntityView& entities);
+};
+
+#endif
@@ -0,0 +1,97 @@
+// Entity benchmark: wanders a crowd of entities over a loaded region of the world and times
+// one frame of entity work (AI and movement, visibility, vertex building) on a single core.
+//
+// Usage: entitybench [ENTITIES] [--frames N] [--chunks N] [--world PATH]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+
+#include "constants.h"
+#include "map.h"
+#include "entities.h"
+#include "benchutil.h"
+
+int main(int argc, char* argv[]) {
+    int entityCount = 50000;
+    int frames = 600;
+    int regionChunks = 16;
+    std::string worldPath = "world.bake";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--chunks" && hasValue) regionChunks = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--world" && hasValue) worldPath = argv[++i];
+        else if (!arg.empty() && arg[0] != '-') entityCount = std::max(0, std::atoi(arg.c_str()));
+        else {
+            std::cout << "Usage: entitybench [ENTITIES] [--frames N] [--chunks N] [--world PATH]" << std::endl;
+            return 1;
+        }
+    }
+
+    Map gameMap;
+    gameMap.openBakedWorld(worldPath);
+
+    // A square region of loaded chunks in the middle of the world
+    regionChunks = std::min({ regionChunks, CHUNKS_X, CHUNKS_Y });
+    int firstChunkX = (CHUNKS_X - regionChunks) / 2;
+    int firstChunkY = (CHUNKS_Y - regionChunks) / 2;
+    std::vector<ChunkCoord> region;
+    for (int y = 0; y < regionChunks; y++) {
+        for (int x = 0; x < regionChunks; x++) {
+            region.push_back({ firstChunkX + x, firstChunkY + y });
+        }
+    }
+    gameMap.loadChunks(region);
+
+    // Spawn on open tiles only
+    EntitySystem entities;
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> tileX(firstChunkX * CHUNK_SIZE, (firstChunkX + regionChunks) * CHUNK_SIZE - 1);
+    std::uniform_int_distribution<int> tileY(firstChunkY * CHUNK_SIZE, (firstChunkY + regionChunks) * CHUNK_SIZE - 1);
+    for (int attempts = 0; entities.size() < entityCount && attempts < entityCount * 20; attempts++) {
+        int x = tileX(rng);
+        int y = tileY(rng);
+        if (!gameMap.isTileSolid(x, y)) {
+            entities.spawn(static_cast<float>(x * TILE_SIZE + TILE_SIZE / 2), static_cast<float>(y * TILE_SIZE + TILE_SIZE / 2), EntitySprite::CRITTER);
+        }
+    }
+
+    std::cout << "Entities: " << entities.size() << " over " << regionChunks << "x" << regionChunks
+        << " chunks, " << frames << " frames" << std::endl;
+
+    // The view covers the whole region, so every entity is also drawn
+    const double regionPixels = static_cast<double>(regionChunks * CHUNK_SIZE * TILE_SIZE);
+    WorldRect view({ static_cast<double>(firstChunkX * CHUNK_SIZE * TILE_SIZE), static_cast<double>(firstChunkY * CHUNK_SIZE * TILE_SIZE) }, { regionPixels, regionPixels });
+    RenderOrigin origin{ { firstChunkX, firstChunkY } };
+    EntityView visible;
+    EntityRenderer renderer;
+
+    const float dt = 1.0f / 60.0f;
+    std::vector<double> updateTimes, renderTimes, frameTimes;
+    for (int frame = 0; frame < frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        entities.update(dt, gameMap);
+        double updateMilliseconds = millisecondsSince(start);
+
+        auto renderStart = std::chrono::steady_clock::now();
+        entities.collectVisible(view, origin, visible);
+        renderer.buildVertices(visible);
+        double renderMilliseconds = millisecondsSince(renderStart);
+
+        updateTimes.push_back(updateMilliseconds);
+        renderTimes.push_back(renderMilliseconds);
+        frameTimes.push_back(updateMilliseconds + renderMilliseconds);
+    }
+
+    reportTimes("Update", updateTimes);
+    reportTimes("Visibility + vertices", renderTimes);
+    reportTimes("Frame", frameTimes);
+    return reportFrameBudget(frameTimes) ? 0 : 1;
+}
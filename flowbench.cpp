@@ -0,0 +1,197 @@
+// Flow field benchmark: a crowd of entities chases a target that wanders the loaded window
+// while tiles near it are walled up and opened again. Times field recomputes, single-tile
+// repairs and entity updates per frame on a single core, checks every repair against a
+// fresh recompute, and compares with planning one path per agent.
+//
+// Usage: flowbench [AGENTS] [--frames N] [--range TILES] [--world PATH]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+
+#include "constants.h"
+#include "map.h"
+#include "entities.h"
+#include "flowfield.h"
+#include "benchutil.h"
+
+namespace {
+    const int STEP_COSTS[3][3] = { { 14, 10, 14 }, { 10, 0, 10 }, { 14, 10, 14 } };
+}
+
+int main(int argc, char* argv[]) {
+    int agentCount = 10000;
+    int frames = 600;
+    int range = FlowField::WINDOW_TILES * 2; // Whole window unless limited
+    std::string worldPath = "world.bake";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--range" && hasValue) range = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--world" && hasValue) worldPath = argv[++i];
+        else if (!arg.empty() && arg[0] != '-') agentCount = std::max(0, std::atoi(arg.c_str()));
+        else {
+            std::cout << "Usage: flowbench [AGENTS] [--frames N] [--range TILES] [--world PATH]" << std::endl;
+            return 1;
+        }
+    }
+
+    Map gameMap;
+    gameMap.openBakedWorld(worldPath);
+
+    // The field's window around the middle of the world, plus a chunk of margin for the target to wander into
+    int centerChunkX = CHUNKS_X / 2;
+    int centerChunkY = CHUNKS_Y / 2;
+    int loadRadius = FLOW_FIELD_CHUNK_RADIUS + 1;
+    std::vector<ChunkCoord> region;
+    for (int y = -loadRadius; y <= loadRadius; y++) {
+        for (int x = -loadRadius; x <= loadRadius; x++) {
+            region.push_back({ centerChunkX + x, centerChunkY + y });
+        }
+    }
+    gameMap.loadChunks(region);
+
+    std::mt19937 rng(12345);
+    sf::Vector2i target = { centerChunkX * CHUNK_SIZE + CHUNK_SIZE / 2, centerChunkY * CHUNK_SIZE + CHUNK_SIZE / 2 };
+    for (int attempts = 0; gameMap.isTileSolid(target.x, target.y) && attempts < 1000; attempts++) {
+        target.x += static_cast<int>(rng() % 3) - 1;
+        target.y += static_cast<int>(rng() % 3) - 1;
+    }
+
+    FlowField& field = gameMap.flowField;
+    field.range = range;
+    field.update(gameMap, target);
+
+    // Agents on open tiles of the window that can reach the target
+    EntitySystem entities;
+    int windowStart = -FLOW_FIELD_CHUNK_RADIUS * CHUNK_SIZE;
+    std::uniform_int_distribution<int> offset(windowStart, windowStart + FlowField::WINDOW_TILES - 1);
+    for (int attempts = 0; entities.size() < agentCount && attempts < agentCount * 50; attempts++) {
+        int x = centerChunkX * CHUNK_SIZE + offset(rng);
+        int y = centerChunkY * CHUNK_SIZE + offset(rng);
+        if (field.getDistance(x, y) > 0) {
+            entities.spawn(static_cast<float>(x * TILE_SIZE + TILE_SIZE / 2), static_cast<float>(y * TILE_SIZE + TILE_SIZE / 2), EntitySprite::CRITTER);
+        }
+    }
+
+    std::cout << "Agents: " << entities.size() << ", window " << FlowField::WINDOW_TILES << "x" << FlowField::WINDOW_TILES
+        << " tiles, range " << range << " tiles, " << frames << " frames" << std::endl;
+    std::cout << "Initial field: " << field.getLastRecomputeMilliseconds() << " ms, " << field.getLastSettledTiles() << " tiles reached" << std::endl;
+
+    // Every repaired field must match a recompute from scratch, and each step must lead one move closer
+    FlowField reference;
+    reference.range = range;
+    int mismatches = 0;
+    auto verify = [&]() {
+        reference.clear();
+        reference.update(gameMap, target);
+        for (int y = target.y - FlowField::WINDOW_TILES; y <= target.y + FlowField::WINDOW_TILES; y++) {
+            for (int x = target.x - FlowField::WINDOW_TILES; x <= target.x + FlowField::WINDOW_TILES; x++) {
+                int distance = field.getDistance(x, y);
+                if (distance != reference.getDistance(x, y)) {
+                    mismatches++;
+                    continue;
+                }
+                sf::Vector2i step;
+                if (distance > 0 && (!field.getStep(x, y, step) ||
+                    field.getDistance(x + step.x, y + step.y) + STEP_COSTS[step.y + 1][step.x + 1] != distance)) {
+                    mismatches++;
+                }
+            }
+        }
+    };
+
+    const float dt = 1.0f / 60.0f;
+    std::vector<double> fieldTimes, recomputeTimes, repairTimes, updateTimes, frameTimes;
+    std::vector<sf::Vector2i> walled;
+    int chasing = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        // The target steps to an open neighbor every few frames, like a walking player
+        bool targetMoved = false;
+        if (frame % 8 == 0) {
+            sf::Vector2i next = { target.x + static_cast<int>(rng() % 3) - 1, target.y + static_cast<int>(rng() % 3) - 1 };
+            int chunkDistanceX = std::abs(next.x / CHUNK_SIZE - centerChunkX);
+            int chunkDistanceY = std::abs(next.y / CHUNK_SIZE - centerChunkY);
+            if (!gameMap.isTileSolid(next.x, next.y) && chunkDistanceX <= 1 && chunkDistanceY <= 1) {
+                target = next;
+                targetMoved = true;
+            }
+        }
+
+        // Every few frames a tile near the target is walled up, or an earlier wall opened again
+        double repairMilliseconds = 0.0;
+        if (frame % 5 == 2) {
+            sf::Vector2i tile;
+            bool open = !walled.empty() && rng() % 2 == 0;
+            if (open) {
+                tile = walled.back();
+                walled.pop_back();
+            }
+            else {
+                tile = { target.x + static_cast<int>(rng() % 17) - 8, target.y + static_cast<int>(rng() % 17) - 8 };
+            }
+            auto chunkIt = gameMap.loadedChunks.find({ tile.x / CHUNK_SIZE, tile.y / CHUNK_SIZE });
+            bool& solid = chunkIt->second->solidTiles[tile.y % CHUNK_SIZE][tile.x % CHUNK_SIZE];
+            if (open || (!solid && tile != target)) {
+                solid = !open;
+                if (!open) {
+                    walled.push_back(tile);
+                }
+                field.onTileChanged(gameMap, tile.x, tile.y);
+                repairMilliseconds = field.getLastRepairMilliseconds();
+                repairTimes.push_back(repairMilliseconds);
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        field.update(gameMap, target);
+        double fieldMilliseconds = millisecondsSince(start);
+        if (targetMoved) {
+            recomputeTimes.push_back(field.getLastRecomputeMilliseconds());
+        }
+
+        auto updateStart = std::chrono::steady_clock::now();
+        entities.update(dt, gameMap, &field);
+        double updateMilliseconds = millisecondsSince(updateStart);
+
+        fieldTimes.push_back(fieldMilliseconds);
+        updateTimes.push_back(updateMilliseconds);
+        frameTimes.push_back(repairMilliseconds + fieldMilliseconds + updateMilliseconds);
+
+        if (frame % 5 == 2) {
+            verify();
+        }
+    }
+    for (AIState state : entities.aiState) {
+        chasing += (state == AIState::CHASE) ? 1 : 0;
+    }
+
+    // For comparison: one path per agent, which is what each mob would need without the field
+    const int pathQueries = std::min(200, entities.size());
+    std::vector<sf::Vector2i> path;
+    int pathsFound = 0;
+    auto pathStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < pathQueries; i++) {
+        sf::Vector2i from = { static_cast<int>(entities.positionX[i]) / TILE_SIZE, static_cast<int>(entities.positionY[i]) / TILE_SIZE };
+        pathsFound += gameMap.pathFinder.findPath(gameMap, from, target, path) ? 1 : 0;
+    }
+    double pathMilliseconds = pathQueries > 0 ? millisecondsSince(pathStart) / pathQueries : 0.0;
+
+    reportTimes("Full recompute", recomputeTimes);
+    reportTimes("Tile repair", repairTimes);
+    reportTimes("Field update per frame", fieldTimes);
+    reportTimes("Entity update", updateTimes);
+    reportTimes("Frame", frameTimes);
+    std::cout << "Chasing at the end: " << chasing << " of " << entities.size() << std::endl;
+    std::cout << "Per-agent path instead: " << pathMilliseconds << " ms per query (" << pathsFound << " of " << pathQueries
+        << " found), about " << pathMilliseconds * entities.size() << " ms to plan for every agent" << std::endl;
+    std::cout << "Repairs matching a full recompute: " << (mismatches == 0 ? "yes" : "NO, " + std::to_string(mismatches) + " tiles differ") << std::endl;
+
+    return reportFrameBudget(frameTimes, mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,320 @@
+#include "flowfield.h"
+#include "map.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <chrono>
+
+namespace {
+    const std::int32_t UNREACHED = std::numeric_limits<std::int32_t>::max();
+    const int STRAIGHT_COST = 10;
+    const int DIAGONAL_COST = 14;
+    const int BUCKET_COUNT = DIAGONAL_COST + 1; // Pending costs never span more than one diagonal move
+
+    // Straight moves first; a direction's opposite is direction ^ 1
+    const int MOVES[8][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 }, { -1, -1 }, { 1, 1 }, { 1, -1 }, { -1, 1 } };
+
+    int moveCost(int direction) {
+        return (direction < 4) ? STRAIGHT_COST : DIAGONAL_COST;
+    }
+}
+
+bool FlowField::toLocal(int worldX, int worldY, int& index) const {
+    int x = worldX - origin.x;
+    int y = worldY - origin.y;
+    if (!hasTarget || x < 0 || x >= WINDOW_TILES || y < 0 || y >= WINDOW_TILES) {
+        return false;
+    }
+    index = y * WINDOW_TILES + x;
+    return true;
+}
+
+bool FlowField::canMove(int index, int direction) const {
+    int x = index % WINDOW_TILES + MOVES[direction][0];
+    int y = index / WINDOW_TILES + MOVES[direction][1];
+    if (x < 0 || x >= WINDOW_TILES || y < 0 || y >= WINDOW_TILES || solid[y * WINDOW_TILES + x]) {
+        return false;
+    }
+    if (direction >= 4) {
+        // Both tiles beside a diagonal must be open
+        int fromX = index % WINDOW_TILES;
+        int fromY = index / WINDOW_TILES;
+        return !solid[fromY * WINDOW_TILES + x] && !solid[y * WINDOW_TILES + fromX];
+    }
+    return true;
+}
+
+void FlowField::copySolidity(const Map& gameMap) {
+    solid.assign(WINDOW_TILES * WINDOW_TILES, 1); // Unloaded chunks are walls
+    int originChunkX = floorDiv(origin.x, CHUNK_SIZE);
+    int originChunkY = floorDiv(origin.y, CHUNK_SIZE);
+    for (int chunkY = 0; chunkY < 2 * FLOW_FIELD_CHUNK_RADIUS + 1; chunkY++) {
+        for (int chunkX = 0; chunkX < 2 * FLOW_FIELD_CHUNK_RADIUS + 1; chunkX++) {
+            const Chunk* chunk = gameMap.findChunk({ originChunkX + chunkX, originChunkY + chunkY });
+            if (!chunk) {
+                continue;
+            }
+            for (int y = 0; y < CHUNK_SIZE; y++) {
+                std::uint8_t* row = &solid[(chunkY * CHUNK_SIZE + y) * WINDOW_TILES + chunkX * CHUNK_SIZE];
+                for (int x = 0; x < CHUNK_SIZE; x++) {
+                    row[x] = chunk->solidTiles[y][x];
+                }
+            }
+        }
+    }
+}
+
+void FlowField::recompute() {
+    auto start = std::chrono::steady_clock::now();
+    cost.assign(WINDOW_TILES * WINDOW_TILES, UNREACHED);
+    stepDirection.assign(WINDOW_TILES * WINDOW_TILES, NO_STEP);
+    buckets.resize(BUCKET_COUNT);
+    for (auto& bucket : buckets) {
+        bucket.clear();
+    }
+
+    // Dial's algorithm: costs are small integers, so a ring of buckets replaces the heap
+    int maxCost = range * STRAIGHT_COST;
+    int targetIndex = (target.y - origin.y) * WINDOW_TILES + (target.x - origin.x);
+    cost[targetIndex] = 0;
+    buckets[0].push_back(targetIndex);
+    int pending = 1;
+    int settled = 0;
+
+    for (std::int32_t current = 0; pending > 0; current++) {
+        std::vector<int>& bucket = buckets[current % BUCKET_COUNT];
+        // Moves cost 10 or 14, so nothing lands back in the bucket being drained
+        for (size_t i = 0; i < bucket.size(); i++) {
+            int index = bucket[i];
+            pending--;
+            if (cost[index] != current) {
+                continue; // Reached more cheaply since
+            }
+            settled++;
+            for (int direction = 0; direction < 8; direction++) {
+                std::int32_t nextCost = current + moveCost(direction);
+                if (nextCost > maxCost || !canMove(index, direction)) {
+                    continue;
+                }
+                int next = index + MOVES[direction][1] * WINDOW_TILES + MOVES[direction][0];
+                if (nextCost < cost[next]) {
+                    cost[next] = nextCost;
+                    stepDirection[next] = static_cast<std::uint8_t>(direction ^ 1);
+                    buckets[nextCost % BUCKET_COUNT].push_back(next);
+                    pending++;
+                }
+            }
+        }
+        bucket.clear();
+    }
+
+    lastSettledTiles = settled;
+    lastRecomputeMilliseconds = millisecondsSince(start);
+}
+
+void FlowField::propagate() {
+    int maxCost = range * STRAIGHT_COST;
+    auto byCost = std::greater<std::pair<std::int32_t, int>>();
+    std::make_heap(heap.begin(), heap.end(), byCost);
+    int settled = 0;
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), byCost);
+        std::int32_t current = heap.back().first;
+        int index = heap.back().second;
+        heap.pop_back();
+        if (current != cost[index]) {
+            continue;
+        }
+        settled++;
+        for (int direction = 0; direction < 8; direction++) {
+            std::int32_t nextCost = current + moveCost(direction);
+            if (nextCost > maxCost || !canMove(index, direction)) {
+                continue;
+            }
+            int next = index + MOVES[direction][1] * WINDOW_TILES + MOVES[direction][0];
+            if (nextCost < cost[next]) {
+                cost[next] = nextCost;
+                stepDirection[next] = static_cast<std::uint8_t>(direction ^ 1);
+                heap.push_back({ nextCost, next });
+                std::push_heap(heap.begin(), heap.end(), byCost);
+            }
+        }
+    }
+    lastSettledTiles = settled;
+}
+
+void FlowField::update(const Map& gameMap, sf::Vector2i newTarget) {
+    ChunkCoord targetChunk = chunkOfTile(newTarget.x, newTarget.y);
+    sf::Vector2i newOrigin = {
+        static_cast<int>((targetChunk.x - FLOW_FIELD_CHUNK_RADIUS) * CHUNK_SIZE),
+        static_cast<int>((targetChunk.y - FLOW_FIELD_CHUNK_RADIUS) * CHUNK_SIZE)
+    };
+
+    if (!hasTarget || newOrigin != origin) {
+        origin = newOrigin;
+        windowDirty = true;
+    }
+    if (hasTarget && !windowDirty && newTarget == target) {
+        return;
+    }
+
+    hasTarget = true;
+    target = newTarget;
+    if (windowDirty) {
+        copySolidity(gameMap);
+        windowDirty = false;
+    }
+    recompute();
+}
+
+void FlowField::onTileChanged(const Map& gameMap, int worldX, int worldY) {
+    int changed;
+    if (windowDirty || !toLocal(worldX, worldY, changed)) {
+        return; // Picked up by the next full recompute, or doesn't matter
+    }
+    std::uint8_t nowSolid = gameMap.isTileSolid(worldX, worldY) ? 1 : 0;
+    if (solid[changed] == nowSolid) {
+        return;
+    }
+    solid[changed] = nowSolid;
+
+    auto start = std::chrono::steady_clock::now();
+    if (worldX == target.x && worldY == target.y) {
+        recompute();
+        lastRepairMilliseconds = millisecondsSince(start);
+        return;
+    }
+
+    int changedX = changed % WINDOW_TILES;
+    int changedY = changed / WINDOW_TILES;
+    heap.clear();
+
+    if (!nowSolid) {
+        // Opened: only distances that get shorter through it, or through the diagonals it stopped blocking.
+        // Restarting from the settled tiles around it finds all of them.
+        for (int y = std::max(0, changedY - 1); y <= std::min(WINDOW_TILES - 1, changedY + 1); y++) {
+            for (int x = std::max(0, changedX - 1); x <= std::min(WINDOW_TILES - 1, changedX + 1); x++) {
+                int index = y * WINDOW_TILES + x;
+                if (cost[index] != UNREACHED) {
+                    heap.push_back({ cost[index], index });
+                }
+            }
+        }
+        propagate();
+        lastRepairMilliseconds = millisecondsSince(start);
+        return;
+    }
+
+    // Blocked: every tile whose step chain ran through it, or diagonally past its corner, lost its route
+    affectedMark.resize(WINDOW_TILES * WINDOW_TILES, 0);
+    affected.clear();
+    auto markAffected = [this](int index) {
+        if (!affectedMark[index] && cost[index] != UNREACHED) {
+            affectedMark[index] = 1;
+            affected.push_back(index);
+        }
+    };
+    markAffected(changed);
+    for (int direction = 4; direction < 8; direction++) {
+        // Diagonal steps of the tiles beside it that squeeze past this corner
+        for (int side = 0; side < 2; side++) {
+            int fromX = changedX - (side == 0 ? MOVES[direction][0] : 0);
+            int fromY = changedY - (side == 1 ? MOVES[direction][1] : 0);
+            if (fromX < 0 || fromX >= WINDOW_TILES || fromY < 0 || fromY >= WINDOW_TILES) {
+                continue;
+            }
+            int from = fromY * WINDOW_TILES + fromX;
+            if (stepDirection[from] == direction) {
+                markAffected(from);
+            }
+        }
+    }
+
+    // Then everything stepping into an affected tile, breadth first
+    for (size_t head = 0; head < affected.size(); head++) {
+        int index = affected[head];
+        int x = index % WINDOW_TILES;
+        int y = index / WINDOW_TILES;
+        for (int direction = 0; direction < 8; direction++) {
+            int neighborX = x + MOVES[direction][0];
+            int neighborY = y + MOVES[direction][1];
+            if (neighborX < 0 || neighborX >= WINDOW_TILES || neighborY < 0 || neighborY >= WINDOW_TILES) {
+                continue;
+            }
+            int neighbor = neighborY * WINDOW_TILES + neighborX;
+            if (stepDirection[neighbor] == (direction ^ 1)) {
+                markAffected(neighbor);
+            }
+        }
+    }
+
+    for (int index : affected) {
+        cost[index] = UNREACHED;
+        stepDirection[index] = NO_STEP;
+    }
+
+    // Reseed each affected tile from its best unaffected neighbor, then let Dijkstra fill the rest
+    int maxCost = range * STRAIGHT_COST;
+    for (int index : affected) {
+        affectedMark[index] = 0;
+        if (solid[index]) {
+            continue;
+        }
+        for (int direction = 0; direction < 8; direction++) {
+            if (!canMove(index, direction)) {
+                continue;
+            }
+            int neighbor = index + MOVES[direction][1] * WINDOW_TILES + MOVES[direction][0];
+            if (cost[neighbor] == UNREACHED) {
+                continue;
+            }
+            std::int32_t throughNeighbor = cost[neighbor] + moveCost(direction);
+            if (throughNeighbor <= maxCost && throughNeighbor < cost[index]) {
+                cost[index] = throughNeighbor;
+                stepDirection[index] = static_cast<std::uint8_t>(direction);
+            }
+        }
+        if (cost[index] != UNREACHED) {
+            heap.push_back({ cost[index], index });
+        }
+    }
+    propagate();
+    lastRepairMilliseconds = millisecondsSince(start);
+}
+
+void FlowField::onChunkChanged(ChunkCoord chunk) {
+    if (!hasTarget) {
+        return;
+    }
+    std::int64_t chunkX = chunk.x - floorDiv(origin.x, CHUNK_SIZE);
+    std::int64_t chunkY = chunk.y - floorDiv(origin.y, CHUNK_SIZE);
+    if (chunkX >= 0 && chunkX <= 2 * FLOW_FIELD_CHUNK_RADIUS && chunkY >= 0 && chunkY <= 2 * FLOW_FIELD_CHUNK_RADIUS) {
+        windowDirty = true;
+    }
+}
+
+void FlowField::clear() {
+    hasTarget = false;
+    windowDirty = true;
+    solid.clear();
+    cost.clear();
+    stepDirection.clear();
+}
+
+bool FlowField::getStep(int worldX, int worldY, sf::Vector2i& step) const {
+    int index;
+    if (windowDirty || !toLocal(worldX, worldY, index) || stepDirection[index] == NO_STEP) {
+        return false;
+    }
+    step = { MOVES[stepDirection[index]][0], MOVES[stepDirection[index]][1] };
+    return true;
+}
+
+int FlowField::getDistance(int worldX, int worldY) const {
+    int index;
+    if (windowDirty || !toLocal(worldX, worldY, index) || cost[index] == UNREACHED) {
+        return -1;
+    }
+    return cost[index];
+}
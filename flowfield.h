@@ -0,0 +1,69 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+#include "constants.h"
+#include "chunk.h"
+
+class Map; // Forward declaration
+
+// Shared navigation toward one target (the player) for any number of agents: a Dijkstra
+// integration field over the window of chunks around the target, where every tile stores
+// which neighbor is one step closer. Agents read their next step in O(1) instead of each
+// running a path search.
+//
+// Moves and costs match PathFinder (8 directions, 10 straight, 14 diagonal, no cutting
+// corners). The field is recomputed when the target changes tile or chunks in the window
+// load or unload; a single tile edit only repairs the tiles whose distance it changes.
+class FlowField {
+public:
+    static constexpr int WINDOW_TILES = (2 * FLOW_FIELD_CHUNK_RADIUS + 1) * CHUNK_SIZE;
+
+    int range = FLOW_FIELD_RANGE; // Walking distance in tiles the field reaches; no steps beyond it
+
+    // Recomputes if the target changed tile or the window's chunks changed since the last call
+    void update(const Map& gameMap, sf::Vector2i target);
+    void onTileChanged(const Map& gameMap, int worldX, int worldY); // Solidity of a tile changed
+    void onChunkChanged(ChunkCoord chunk);                          // Loaded or unloaded
+    void clear();
+
+    // Next tile offset toward the target; false at the target, out of range or outside the window
+    bool getStep(int worldX, int worldY, sf::Vector2i& step) const;
+    int getDistance(int worldX, int worldY) const; // In move costs (10 per straight tile), -1 if out of range
+
+    float getLastRecomputeMilliseconds() const { return lastRecomputeMilliseconds; }
+    float getLastRepairMilliseconds() const { return lastRepairMilliseconds; }
+    int getLastSettledTiles() const { return lastSettledTiles; }
+
+private:
+    static constexpr std::uint8_t NO_STEP = 8;
+
+    bool hasTarget = false;
+    bool windowDirty = true;
+    sf::Vector2i target;
+    sf::Vector2i origin; // World tile at the window's top left
+
+    std::vector<std::uint8_t> solid;
+    std::vector<std::int32_t> cost;
+    std::vector<std::uint8_t> stepDirection; // Index into the move table, NO_STEP if none
+
+    // Scratch: buckets for the full pass (costs pending within one diagonal of each other), a heap for repairs
+    std::vector<std::vector<int>> buckets;
+    std::vector<std::pair<std::int32_t, int>> heap;
+    std::vector<int> affected;
+    std::vector<std::uint8_t> affectedMark;
+
+    float lastRecomputeMilliseconds = 0.0f;
+    float lastRepairMilliseconds = 0.0f;
+    int lastSettledTiles = 0;
+
+    bool toLocal(int worldX, int worldY, int& index) const;
+    bool canMove(int index, int direction) const; // Onto an open tile without cutting a corner
+    void copySolidity(const Map& gameMap);
+    void recompute();
+    void propagate(); // Dijkstra from everything in the heap
+};
+
+#endif
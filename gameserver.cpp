@@ -0,0 +1,439 @@
+#include "gameserver.h"
+#include "map.h"
+#include "netprotocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+namespace {
+    const int MAX_PACKETS_PER_TICK = 64;     // Read from one client per tick; the rest waits
+    const size_t MAX_QUEUED_PACKETS = 4096;  // A client this far behind is dropped
+
+    int chunkDistance(ChunkCoord a, ChunkCoord b) {
+        return static_cast<int>(std::max(std::llabs(a.x - b.x), std::llabs(a.y - b.y)));
+    }
+
+    // The protocol carries positions as floats; the server's world is bounded, so they stay exact
+    sf::Vector2f toWire(WorldVector position) {
+        return { static_cast<float>(position.x), static_cast<float>(position.y) };
+    }
+}
+
+GameServer::GameServer(Map& gameMap, unsigned short port, std::string savePath)
+    : gameMap(gameMap), port(port), autoSaver(savePath) {
+    gameMap.recordTileDeltas = true;
+
+    // The world's edits come back from the last save; its player is just the spawn point
+    spawnPlayer.findSafeSpawnPosition(gameMap);
+    if (loadGame(savePath, gameMap, spawnPlayer, noExploredChunks)) {
+        std::cout << "Server resumed the world from " << savePath << std::endl;
+    }
+}
+
+bool GameServer::listen() {
+    if (listener.listen(port) != sf::Socket::Status::Done) {
+        std::cout << "Server could not listen on port " << port << std::endl;
+        return false;
+    }
+    listener.setBlocking(false);
+    std::cout << "Server listening on port " << port << " at " << tickRate << " ticks per second" << std::endl;
+    return true;
+}
+
+void GameServer::run() {
+    using clock = std::chrono::steady_clock;
+    const clock::duration tickLength = std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(1.0f / tickRate));
+
+    clock::time_point lastTick = clock::now();
+    clock::time_point nextTick = lastTick + tickLength;
+
+    while (running) {
+        clock::time_point now = clock::now();
+        float dt = std::chrono::duration<float>(now - lastTick).count();
+        lastTick = now;
+
+        step(dt);
+
+        nextTick += tickLength;
+        if (nextTick < clock::now()) {
+            nextTick = clock::now() + tickLength;
+        }
+        std::this_thread::sleep_until(nextTick);
+    }
+
+    autoSaver.submit(captureSnapshot(gameMap, spawnPlayer, noExploredChunks));
+}
+
+void GameServer::step(float dt) {
+    auto start = std::chrono::steady_clock::now();
+
+    acceptClients();
+    for (auto& client : clients) {
+        receive(*client);
+    }
+
+    updateResidency();
+
+    // Players move and harvest exactly as in single player; harvested items go straight to the inventory
+    occupiedScratch.clear();
+    WorldVector tileSize{ static_cast<double>(TILE_SIZE), static_cast<double>(TILE_SIZE) };
+    for (auto& client : clients) {
+        if (!client->greeted) {
+            continue;
+        }
+        Player& player = client->player;
+        player.update(dt, gameMap);
+        for (const ItemDrop& drop : player.harvestDrops) {
+            player.addItemUpTo(drop.itemId, drop.quantity);
+        }
+        player.harvestDrops.clear();
+        occupiedScratch.push_back(WorldRect(player.getPosition() - tileSize / 2.0, tileSize));
+    }
+
+    gameMap.tickWorld(tick, occupiedScratch);
+    if (tick % WATER_STEP_TICKS == 0) {
+        gameMap.stepWater();
+    }
+    gameMap.updateLighting();
+
+    sendTileDeltas();
+    for (auto& client : clients) {
+        if (client->greeted) {
+            streamChunks(*client);
+            sendPlayers(*client);
+        }
+    }
+
+    // Once a second every client hears how long ticks are taking
+    if (tick % static_cast<long long>(tickRate) == 0) {
+        if (intervalTicks > 0) {
+            stats.averageTickMilliseconds = intervalTickMilliseconds / intervalTicks;
+            stats.maxTickMilliseconds = intervalMaxMilliseconds;
+        }
+        intervalTickMilliseconds = 0.0f;
+        intervalMaxMilliseconds = 0.0f;
+        intervalTicks = 0;
+
+        for (auto& client : clients) {
+            if (client->greeted) {
+                sf::Packet packet;
+                packet << static_cast<std::uint8_t>(NetMessage::SERVER_STATS) << stats.averageTickMilliseconds
+                    << stats.maxTickMilliseconds << static_cast<std::uint16_t>(clients.size());
+                queue(*client, std::move(packet));
+            }
+        }
+    }
+
+    for (auto& client : clients) {
+        flush(*client);
+    }
+    size_t before = clients.size();
+    clients.erase(std::remove_if(clients.begin(), clients.end(), [this](const std::unique_ptr<ClientConnection>& client) {
+        if (client->disconnected) {
+            gameMap.interest.removeObserver(client->observer);
+        }
+        return client->disconnected;
+    }), clients.end());
+    if (clients.size() != before) {
+        std::cout << "Server: " << (before - clients.size()) << " client(s) left, " << clients.size() << " connected" << std::endl;
+    }
+    stats.clients = static_cast<int>(clients.size());
+
+    autosaveElapsed += dt;
+    if (autosaveElapsed >= AUTOSAVE_INTERVAL && !autoSaver.isBusy()) {
+        autoSaver.submit(captureSnapshot(gameMap, spawnPlayer, noExploredChunks));
+        autosaveElapsed = 0.0f;
+    }
+
+    float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats.lastTickMilliseconds = milliseconds;
+    intervalTickMilliseconds += milliseconds;
+    intervalMaxMilliseconds = std::max(intervalMaxMilliseconds, milliseconds);
+    intervalTicks++;
+    stats.ticks++;
+    tick++;
+}
+
+void GameServer::acceptClients() {
+    while (true) {
+        auto client = std::make_unique<ClientConnection>();
+        if (listener.accept(client->socket) != sf::Socket::Status::Done) {
+            return;
+        }
+        client->socket.setBlocking(false);
+        client->id = nextClientId++;
+        clients.push_back(std::move(client));
+    }
+}
+
+void GameServer::receive(ClientConnection& client) {
+    for (int i = 0; i < MAX_PACKETS_PER_TICK && !client.disconnected; i++) {
+        sf::Packet packet;
+        sf::Socket::Status status = client.socket.receive(packet);
+        if (status == sf::Socket::Status::NotReady || status == sf::Socket::Status::Partial) {
+            return;
+        }
+        if (status != sf::Socket::Status::Done) {
+            client.disconnected = true;
+            return;
+        }
+        stats.bytesReceived += static_cast<long long>(wireBytes(packet));
+
+        std::uint8_t type;
+        if (!(packet >> type)) {
+            continue;
+        }
+        if (static_cast<NetMessage>(type) == NetMessage::HELLO) {
+            std::uint32_t version, chunkSize;
+            if (!(packet >> version) || version != NET_PROTOCOL_VERSION) {
+                std::cout << "Server: client " << client.id << " speaks another protocol version" << std::endl;
+                client.disconnected = true;
+                return;
+            }
+            if (!(packet >> chunkSize) || chunkSize != static_cast<std::uint32_t>(CHUNK_SIZE)) {
+                std::cout << "Server: client " << client.id << " was built with another chunk size" << std::endl;
+                client.disconnected = true;
+                return;
+            }
+            if (!client.greeted) {
+                greet(client);
+            }
+        }
+        else if (static_cast<NetMessage>(type) == NetMessage::INPUT && client.greeted) {
+            InputCommand command;
+            if (readCommand(packet, command)) {
+                applyCommand(client, command);
+            }
+        }
+    }
+}
+
+void GameServer::greet(ClientConnection& client) {
+    // Spread newcomers over open tiles around the spawn point, the same spot for the same id
+    sf::Vector2i spawn = spawnPlayer.getTilePosition();
+    client.player.setPosition(spawnPlayer.getPosition());
+    std::uint32_t hash = client.id * 2654435761u;
+    for (int attempt = 0; attempt < 32; attempt++) {
+        hash ^= hash << 13;
+        hash ^= hash >> 17;
+        hash ^= hash << 5;
+        int offsetX = static_cast<int>(hash % (2 * SERVER_SPAWN_RADIUS + 1)) - SERVER_SPAWN_RADIUS;
+        int offsetY = static_cast<int>((hash >> 16) % (2 * SERVER_SPAWN_RADIUS + 1)) - SERVER_SPAWN_RADIUS;
+        int tileX = spawn.x + offsetX;
+        int tileY = spawn.y + offsetY;
+        if (gameMap.isInWorld(tileX, tileY) && !Map::isSolidType(gameMap.getTile(tileX, tileY))) {
+            client.player.setPosition(tileCenter(tileX, tileY));
+            break;
+        }
+    }
+    client.greeted = true;
+    client.observer = gameMap.interest.addObserver(chunkOf(client.player.getPosition()),
+        SERVER_INTEREST_RADIUS, SERVER_INTEREST_RADIUS + 1);
+
+    sf::Packet packet;
+    packet << static_cast<std::uint8_t>(NetMessage::WELCOME) << client.id << tickRate;
+    queue(client, std::move(packet));
+    std::cout << "Server: client " << client.id << " joined, " << clients.size() << " connected" << std::endl;
+}
+
+void GameServer::applyCommand(ClientConnection& client, const InputCommand& command) {
+    // The subset of Simulation::applyCommand that makes sense remotely; anything else is ignored
+    Player& player = client.player;
+    switch (command.type) {
+    case InputCommandType::MOVEMENT: {
+        bool left = (command.flags & INPUT_LEFT) != 0;
+        bool right = (command.flags & INPUT_RIGHT) != 0;
+        bool up = (command.flags & INPUT_UP) != 0;
+        bool down = (command.flags & INPUT_DOWN) != 0;
+        if ((left || right || up || down) && player.getIsHarvesting()) {
+            player.stopHarvesting();
+        }
+        player.setMovement(left, right, up, down);
+        player.setSprinting((command.flags & INPUT_SPRINT) != 0);
+        break;
+    }
+    case InputCommandType::HARVEST_TILE:
+        if (gameMap.isInWorld(command.a, command.b) && !player.getIsHarvesting()) {
+            TileType tileType = gameMap.getTile(command.a, command.b);
+            if (player.canHarvestTile(tileType) && player.isWithinHarvestRange(command.a, command.b)) {
+                player.startHarvesting(command.a, command.b, tileCenter(command.a, command.b), tileType);
+            }
+        }
+        break;
+    case InputCommandType::HARVEST_NEAREST:
+        player.startHarvestingNearest(gameMap);
+        break;
+    case InputCommandType::PLACE_TORCH:
+        if (player.getItemCount(7) > 0 && player.isWithinHarvestRange(command.a, command.b) && // Torch
+            gameMap.placeTorch(command.a, command.b)) {
+            player.removeItem(7, 1);
+        }
+        break;
+    case InputCommandType::CRAFT: {
+        const auto& recipes = player.getCraftingRecipes();
+        if (command.a >= 0 && command.a < static_cast<int>(recipes.size())) {
+            player.craft(recipes[command.a]);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void GameServer::updateResidency() {
+    // Each player is an observer of the chunks within the interest radius, keeping one chunk
+    // further so walking back and forth over a border doesn't reload anything
+    for (const auto& client : clients) {
+        if (client->greeted) {
+            gameMap.interest.moveObserver(client->observer, chunkOf(client->player.getPosition()));
+        }
+    }
+    gameMap.unloadUnobservedChunks();
+
+    // A budget per tick, nearest to some player first, generated as one batch on the job system
+    gameMap.interest.collectLoads(SERVER_LOADS_PER_TICK, loadBatch);
+    if (!loadBatch.empty()) {
+        gameMap.loadChunks(loadBatch);
+    }
+}
+
+void GameServer::sendTileDeltas() {
+    if (gameMap.tileDeltas.empty()) {
+        return;
+    }
+
+    for (auto& client : clients) {
+        if (!client->greeted) {
+            continue;
+        }
+        // A tick's deltas all go in one packet, and a busy tick can have more than 16 bits count
+        std::uint32_t count = 0;
+        for (const TileChange& change : gameMap.tileDeltas) {
+            count += client->sentChunks.count(chunkOfTile(change.worldX, change.worldY)) ? 1 : 0;
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        sf::Packet packet;
+        packet << static_cast<std::uint8_t>(NetMessage::TILE_DELTAS) << count;
+        for (const TileChange& change : gameMap.tileDeltas) {
+            if (client->sentChunks.count(chunkOfTile(change.worldX, change.worldY))) {
+                packet << static_cast<std::int32_t>(change.worldX) << static_cast<std::int32_t>(change.worldY)
+                    << static_cast<std::uint8_t>(change.replacement);
+            }
+        }
+        stats.tileDeltasSent += count;
+        queue(*client, std::move(packet));
+    }
+    gameMap.tileDeltas.clear();
+}
+
+void GameServer::streamChunks(ClientConnection& client) {
+    ChunkCoord center = chunkOf(client.player.getPosition());
+
+    // Same one-chunk margin as residency before a chunk is dropped
+    for (auto it = client.sentChunks.begin(); it != client.sentChunks.end();) {
+        if (chunkDistance(*it, center) > SERVER_INTEREST_RADIUS + 1) {
+            sf::Packet packet;
+            packet << static_cast<std::uint8_t>(NetMessage::CHUNK_DROP) << static_cast<std::int32_t>(it->x) << static_cast<std::int32_t>(it->y);
+            queue(client, std::move(packet));
+            it = client.sentChunks.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // Nearest rings first, a few chunks per tick
+    int sent = 0;
+    for (int ring = 0; ring <= SERVER_INTEREST_RADIUS && sent < SERVER_CHUNKS_PER_TICK; ring++) {
+        for (int y = -ring; y <= ring && sent < SERVER_CHUNKS_PER_TICK; y++) {
+            for (int x = -ring; x <= ring && sent < SERVER_CHUNKS_PER_TICK; x++) {
+                if (std::max(std::abs(x), std::abs(y)) != ring) {
+                    continue;
+                }
+                ChunkCoord coord = { center.x + x, center.y + y };
+                const Chunk* chunk = gameMap.findChunk(coord);
+                if (!chunk || client.sentChunks.count(coord)) {
+                    continue;
+                }
+
+                compressChunk(*chunk, chunkScratch);
+                sf::Packet packet;
+                packet << static_cast<std::uint8_t>(NetMessage::CHUNK);
+                writeChunk(packet, chunkScratch);
+                stats.chunksSent++;
+                stats.chunkBytes += static_cast<long long>(wireBytes(packet));
+                queue(client, std::move(packet));
+                client.sentChunks.insert(coord);
+                sent++;
+            }
+        }
+    }
+}
+
+void GameServer::sendPlayers(ClientConnection& client) {
+    const Player& player = client.player;
+    sf::Packet state;
+    sf::Vector2f position = toWire(player.getPosition());
+    state << static_cast<std::uint8_t>(NetMessage::PLAYER_STATE) << static_cast<std::uint32_t>(tick)
+        << position.x << position.y << player.getIsHarvesting() << player.getHarvestProgress();
+    queue(client, std::move(state));
+
+    if (tick % SERVER_PLAYER_UPDATE_TICKS != 0) {
+        return;
+    }
+
+    // The nearest others inside the interest area
+    ChunkCoord center = chunkOf(player.getPosition());
+    std::vector<std::pair<float, const ClientConnection*>> nearby;
+    for (const auto& other : clients) {
+        if (other.get() == &client || !other->greeted || chunkDistance(chunkOf(other->player.getPosition()), center) > SERVER_INTEREST_RADIUS) {
+            continue;
+        }
+        sf::Vector2f offset = toWire(other->player.getPosition() - player.getPosition());
+        nearby.push_back({ offset.x * offset.x + offset.y * offset.y, other.get() });
+    }
+    size_t count = std::min(nearby.size(), static_cast<size_t>(SERVER_MAX_VISIBLE_PLAYERS));
+    std::partial_sort(nearby.begin(), nearby.begin() + count, nearby.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    sf::Packet others;
+    others << static_cast<std::uint8_t>(NetMessage::OTHER_PLAYERS) << static_cast<std::uint16_t>(count);
+    for (size_t i = 0; i < count; i++) {
+        sf::Vector2f otherPosition = toWire(nearby[i].second->player.getPosition());
+        others << nearby[i].second->id << otherPosition.x << otherPosition.y;
+    }
+    queue(client, std::move(others));
+}
+
+void GameServer::queue(ClientConnection& client, sf::Packet&& packet) {
+    if (client.outgoing.size() >= MAX_QUEUED_PACKETS) {
+        if (!client.disconnected) {
+            std::cout << "Server: client " << client.id << " is not keeping up, dropping it" << std::endl;
+        }
+        client.disconnected = true;
+        return;
+    }
+    client.outgoing.push_back(std::move(packet));
+}
+
+void GameServer::flush(ClientConnection& client) {
+    while (!client.outgoing.empty() && !client.disconnected) {
+        sf::Socket::Status status = client.socket.send(client.outgoing.front());
+        if (status == sf::Socket::Status::Done) {
+            stats.bytesSent += static_cast<long long>(wireBytes(client.outgoing.front()));
+            client.outgoing.pop_front();
+        }
+        else if (status == sf::Socket::Status::Partial || status == sf::Socket::Status::NotReady) {
+            return; // The socket's buffer is full; the packet remembers how far it got
+        }
+        else {
+            client.disconnected = true;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include <SFML/Network.hpp>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
+#include "constants.h"
+#include "utils.h"
+#include "player.h"
+#include "chunkcache.h"
+#include "chunkinterest.h"
+#include "savegame.h"
+#include "input.h"
+
+class Map;
+
+struct ServerStats {
+    long long ticks = 0;
+    int clients = 0;
+    float lastTickMilliseconds = 0.0f;
+    float averageTickMilliseconds = 0.0f; // Over the last full second
+    float maxTickMilliseconds = 0.0f;     // Likewise
+    long long bytesSent = 0;
+    long long bytesReceived = 0;
+    long long chunksSent = 0;
+    long long chunkBytes = 0;             // Chunk packets only
+    long long tileDeltasSent = 0;
+};
+
+// Headless authoritative server. It owns the world (Map and its edits) and one Player per
+// client, applies the clients' InputCommands on its own fixed tick, and streams to each
+// client the chunks around its player plus the tile changes in chunks it already has.
+// Every player is an observer in the map's ChunkInterest, so chunks stay loaded while any
+// player is near them.
+class GameServer {
+public:
+    GameServer(Map& gameMap, unsigned short port, std::string savePath);
+
+    bool listen();
+    void run(); // Until running is cleared
+    void step(float dt);
+
+    std::atomic<bool> running{ false };
+    float tickRate = SERVER_TICK_RATE;
+    ServerStats stats;
+
+private:
+    struct ClientConnection {
+        std::uint16_t id = 0;
+        sf::TcpSocket socket;
+        Player player{ true };
+        bool greeted = false;      // Sent a HELLO with our protocol version
+        bool disconnected = false;
+        ChunkInterest::ObserverId observer = -1; // Once greeted
+        std::unordered_set<ChunkCoord, ChunkCoordHash> sentChunks;
+        std::deque<sf::Packet> outgoing; // The front one may be partly sent
+    };
+
+    Map& gameMap;
+    unsigned short port;
+    sf::TcpListener listener;
+    std::vector<std::unique_ptr<ClientConnection>> clients;
+    std::uint16_t nextClientId = 1;
+    long long tick = 0;
+
+    // Where new players are spread around, and whose save holds the world edits
+    Player spawnPlayer{ true };
+    ExploredChunks noExploredChunks;
+    AutoSaver autoSaver;
+    float autosaveElapsed = 0.0f;
+
+    CompressedChunk chunkScratch;
+    std::vector<ChunkCoord> loadBatch;
+    std::vector<WorldRect> occupiedScratch;
+
+    float intervalTickMilliseconds = 0.0f;
+    float intervalMaxMilliseconds = 0.0f;
+    int intervalTicks = 0;
+
+    void acceptClients();
+    void receive(ClientConnection& client);
+    void greet(ClientConnection& client);
+    void applyCommand(ClientConnection& client, const InputCommand& command);
+    void updateResidency();
+    void sendTileDeltas();
+    void streamChunks(ClientConnection& client);
+    void sendPlayers(ClientConnection& client);
+    void queue(ClientConnection& client, sf::Packet&& packet);
+    void flush(ClientConnection& client);
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+
+// Commands sent from the render thread (which owns the window and its events) to the simulation
+enum class InputCommandType : std::uint8_t {
+    MOVEMENT,            // flags: INPUT_* bits
+    HARVEST_TILE,        // a, b: tile coordinates
+    HARVEST_NEAREST,
+    PLACE_TORCH,         // a, b: tile coordinates
+    MOVE_TO,             // a, b: tile coordinates
+    MOVE_ITEM,           // a: from inventory slot, b: to inventory slot
+    MOVE_ITEM_TO_TOOL,   // a: inventory slot, b: tool slot
+    MOVE_ITEM_FROM_TOOL, // a: tool slot, b: inventory slot
+    CRAFT,               // a: recipe index
+    SET_VIEW,            // viewSize: camera size in pixels, a, b: explored map half extent in chunks
+    SAVE,
+    LOAD
+};
+
+const std::uint8_t INPUT_LEFT = 1 << 0;
+const std::uint8_t INPUT_RIGHT = 1 << 1;
+const std::uint8_t INPUT_UP = 1 << 2;
+const std::uint8_t INPUT_DOWN = 1 << 3;
+const std::uint8_t INPUT_SPRINT = 1 << 4;
+const std::uint8_t INPUT_MENU_OPEN = 1 << 5; // Map, inventory or crafting is open; the player is paused
+
+struct InputCommand {
+    InputCommandType type = InputCommandType::MOVEMENT;
+    std::uint8_t flags = 0;
+    int a = 0;
+    int b = 0;
+    sf::Vector2f viewSize;
+};
+
+#endif
@@ -0,0 +1,463 @@
+#include "inputrecord.h"
+#include "map.h"
+#include "player.h"
+#include "entities.h"
+#include "itemdrops.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+namespace {
+    enum class RecordTag : std::uint8_t {
+        TICK = 1,  // dt, command count, commands
+        LOAD,      // Size and bytes of the save file a LOAD read; size 0 if there was none
+        CHECKSUM,  // Tick and state hash after its step
+        END        // Ticks recorded and the final state hash
+    };
+
+    void putBytes(std::string& out, const void* bytes, size_t size) {
+        out.append(static_cast<const char*>(bytes), size);
+    }
+
+    template <typename T>
+    void put(std::string& out, T value) {
+        putBytes(out, &value, sizeof(T));
+    }
+
+    void putVarint(std::string& out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    // Zigzag, so small negative numbers stay short too
+    void putSigned(std::string& out, std::int64_t value) {
+        putVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    bool readFile(const std::string& path, std::string& out) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    struct RecordReader {
+        const std::vector<char>& data;
+        size_t& position;
+
+        bool readBytes(void* out, size_t size) {
+            if (data.size() - position < size) {
+                return false;
+            }
+            std::memcpy(out, data.data() + position, size);
+            position += size;
+            return true;
+        }
+
+        template <typename T>
+        bool read(T& value) {
+            return readBytes(&value, sizeof(T));
+        }
+
+        bool readVarint(std::uint64_t& value) {
+            value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                std::uint8_t byte;
+                if (!read(byte)) {
+                    return false;
+                }
+                value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool readSigned(std::int64_t& value) {
+            std::uint64_t encoded;
+            if (!readVarint(encoded)) {
+                return false;
+            }
+            value = static_cast<std::int64_t>(encoded >> 1) ^ -static_cast<std::int64_t>(encoded & 1);
+            return true;
+        }
+
+        bool readString(std::string& out) {
+            std::uint32_t size;
+            if (!read(size) || data.size() - position < size) {
+                return false;
+            }
+            out.assign(data.data() + position, size);
+            position += size;
+            return true;
+        }
+    };
+
+    // FNV-1a, for sequences whose order is part of the state
+    struct StateHasher {
+        std::uint64_t hash = 14695981039346656037ull;
+
+        void add(const void* bytes, size_t size) {
+            const unsigned char* data = static_cast<const unsigned char*>(bytes);
+            for (size_t i = 0; i < size; i++) {
+                hash = (hash ^ data[i]) * 1099511628211ull;
+            }
+        }
+
+        template <typename T>
+        void add(const std::vector<T>& values) {
+            std::uint64_t count = values.size();
+            add(&count, sizeof(count));
+            if (!values.empty()) {
+                add(values.data(), values.size() * sizeof(T));
+            }
+        }
+    };
+
+    // Finalizer for elements of unordered containers, which are summed so their order doesn't matter
+    std::uint64_t mix(std::uint64_t value) {
+        value ^= value >> 30;
+        value *= 0xBF58476D1CE4E5B9ull;
+        value ^= value >> 27;
+        value *= 0x94D049BB133111EBull;
+        value ^= value >> 31;
+        return value;
+    }
+
+    std::uint64_t packCoord(ChunkCoord coord) {
+        return mix(static_cast<std::uint64_t>(coord.x)) ^ static_cast<std::uint64_t>(coord.y);
+    }
+}
+
+std::uint64_t hashGameState(const Map& gameMap, const Player& player, const EntitySystem& entities, const ItemDrops& itemDrops) {
+    StateHasher hasher;
+    hasher.add(&gameMap.worldTick, sizeof(gameMap.worldTick));
+
+    WorldVector position = player.getPosition();
+    bool harvesting = player.getIsHarvesting();
+    hasher.add(&position, sizeof(position));
+    hasher.add(&harvesting, sizeof(harvesting));
+    for (const auto* slots : { &player.getInventory(), &player.getToolSlots() }) {
+        for (const InventorySlot& slot : *slots) {
+            hasher.add(&slot.itemId, sizeof(slot.itemId));
+            hasher.add(&slot.quantity, sizeof(slot.quantity));
+        }
+    }
+
+    std::uint64_t chunks = 0;
+    for (const auto& entry : gameMap.loadedChunks) {
+        StateHasher chunkHasher;
+        std::uint64_t coord = packCoord(entry.first);
+        chunkHasher.add(&coord, sizeof(coord));
+        chunkHasher.add(&entry.second->tileTypes[0][0], sizeof(entry.second->tileTypes));
+        chunks += mix(chunkHasher.hash);
+    }
+    hasher.add(&chunks, sizeof(chunks));
+
+    std::uint64_t edits = 0;
+    for (const auto& chunkEntry : gameMap.worldEdits->chunks) {
+        std::uint64_t coord = mix(packCoord(chunkEntry.first));
+        for (const auto& edit : *chunkEntry.second) {
+            edits += mix(coord ^ (static_cast<std::uint64_t>(edit.first) << 8) ^ static_cast<std::uint64_t>(edit.second));
+        }
+    }
+    hasher.add(&edits, sizeof(edits));
+
+    // Both keep their own order deterministically, so it is hashed too
+    hasher.add(entities.positionX);
+    hasher.add(entities.positionY);
+    hasher.add(entities.velocityX);
+    hasher.add(entities.velocityY);
+    hasher.add(entities.aiState);
+    hasher.add(entities.rngState);
+    hasher.add(itemDrops.positionX);
+    hasher.add(itemDrops.positionY);
+    hasher.add(itemDrops.itemId);
+    hasher.add(itemDrops.quantity);
+    return hasher.hash;
+}
+
+bool InputRecorder::open(const std::string& path, const Map& gameMap, float tickRate, const std::string& startSavePath) {
+    std::string startSave;
+    if (!startSavePath.empty() && !readFile(startSavePath, startSave)) {
+        std::cout << "Could not read " << startSavePath << " to start a recording from" << std::endl;
+        return false;
+    }
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Could not create recording " << path << std::endl;
+        return false;
+    }
+
+    buffer.clear();
+    putBytes(buffer, RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    put(buffer, RECORDING_VERSION);
+    put(buffer, gameMap.generator.getSeed());
+    put(buffer, static_cast<std::uint8_t>(gameMap.bakedWorld.isOpen()));
+    put(buffer, static_cast<std::uint8_t>(gameMap.infinite));
+    put(buffer, static_cast<std::uint8_t>(CHUNK_SIZE));
+    put(buffer, static_cast<std::uint8_t>(gameMap.streamer.getRenderDistance()));
+    put(buffer, tickRate);
+    put(buffer, static_cast<std::uint32_t>(startSave.size()));
+    buffer += startSave;
+    flush();
+
+    std::cout << "Recording input to " << path << std::endl;
+    return true;
+}
+
+void InputRecorder::recordTick(float dt, const std::vector<InputCommand>& commands) {
+    if (!isOpen()) {
+        return;
+    }
+
+    put(buffer, RecordTag::TICK);
+    put(buffer, dt);
+    putVarint(buffer, commands.size());
+    for (const InputCommand& command : commands) {
+        put(buffer, command.type);
+        put(buffer, command.flags);
+        putSigned(buffer, command.a);
+        putSigned(buffer, command.b);
+        if (command.type == InputCommandType::SET_VIEW) {
+            put(buffer, command.viewSize.x);
+            put(buffer, command.viewSize.y);
+        }
+    }
+}
+
+void InputRecorder::recordLoad(const std::string& savePath) {
+    if (!isOpen()) {
+        return;
+    }
+
+    std::string save;
+    readFile(savePath, save); // Missing stays empty, which replays as a failed load
+    put(buffer, RecordTag::LOAD);
+    put(buffer, static_cast<std::uint32_t>(save.size()));
+    buffer += save;
+}
+
+void InputRecorder::recordChecksum(long long tick, std::uint64_t hash) {
+    if (!isOpen()) {
+        return;
+    }
+
+    put(buffer, RecordTag::CHECKSUM);
+    putVarint(buffer, static_cast<std::uint64_t>(tick));
+    put(buffer, hash);
+
+    // Once a second is often enough to lose little if the game crashes
+    flush();
+}
+
+void InputRecorder::close(long long ticks, std::uint64_t hash) {
+    if (!isOpen()) {
+        return;
+    }
+
+    put(buffer, RecordTag::END);
+    putVarint(buffer, static_cast<std::uint64_t>(ticks));
+    put(buffer, hash);
+    flush();
+    file.close();
+    std::cout << "Recorded " << ticks << " ticks in " << bytesWritten / 1024 << " KB" << std::endl;
+}
+
+void InputRecorder::flush() {
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    file.flush();
+    bytesWritten += static_cast<long long>(buffer.size());
+    buffer.clear();
+}
+
+bool InputReplay::open(const std::string& path, const Map& gameMap) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cout << "Could not open recording " << path << std::endl;
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    position = 0;
+
+    RecordReader reader{ data, position };
+    char magic[4];
+    std::uint32_t version, seed;
+    std::uint8_t baked, infinite, chunkSize, recordedRenderDistance;
+    if (!reader.readBytes(magic, sizeof(magic)) || std::memcmp(magic, RECORDING_MAGIC, sizeof(magic)) != 0 ||
+        !reader.read(version) || version != RECORDING_VERSION) {
+        std::cout << path << " is not a recording this version can replay" << std::endl;
+        return false;
+    }
+    if (!reader.read(seed) || !reader.read(baked) || !reader.read(infinite) ||
+        !reader.read(chunkSize) || !reader.read(recordedRenderDistance) || !reader.read(tickRate) || !reader.readString(startSave)) {
+        std::cout << "Recording " << path << " is truncated" << std::endl;
+        return false;
+    }
+
+    // Anything else generates different tiles, and the first step already diverges
+    if (seed != gameMap.generator.getSeed() || (baked != 0) != gameMap.bakedWorld.isOpen()) {
+        std::cout << "Recording " << path << " was made in world " << seed << (baked ? " (baked)" : "")
+            << ", this is world " << gameMap.generator.getSeed() << (gameMap.bakedWorld.isOpen() ? " (baked)" : "") << std::endl;
+        return false;
+    }
+    if ((infinite != 0) != gameMap.infinite) {
+        std::cout << "Recording " << path << " was made in " << (infinite ? "an infinite" : "a bounded")
+            << " world; run with" << (infinite ? "" : "out") << " --infinite to replay it" << std::endl;
+        return false;
+    }
+    if (chunkSize != CHUNK_SIZE) {
+        std::cout << "Recording " << path << " was made with " << static_cast<int>(chunkSize) << "-tile chunks, this build uses "
+            << CHUNK_SIZE << std::endl;
+        return false;
+    }
+    renderDistance = recordedRenderDistance;
+
+    savePath = path + ".replay.dat";
+    std::remove(savePath.c_str());
+    finished = false;
+    firstMismatchTick = -1;
+    recordedTicks = 0;
+    stepMilliseconds.clear();
+    return true;
+}
+
+bool InputReplay::prepareStartSave() {
+    if (startSave.empty()) {
+        return false;
+    }
+    std::ofstream out(savePath, std::ios::binary | std::ios::trunc);
+    out.write(startSave.data(), static_cast<std::streamsize>(startSave.size()));
+    return static_cast<bool>(out);
+}
+
+bool InputReplay::readTick(float& dt, std::vector<InputCommand>& commands) {
+    commands.clear();
+    if (finished) {
+        return false;
+    }
+
+    RecordReader reader{ data, position };
+    std::uint8_t tag;
+    while (reader.read(tag)) {
+        switch (static_cast<RecordTag>(tag)) {
+        case RecordTag::TICK: {
+            std::uint64_t count;
+            if (!reader.read(dt) || !reader.readVarint(count)) {
+                break;
+            }
+            bool valid = true;
+            for (std::uint64_t i = 0; i < count && valid; i++) {
+                InputCommand command;
+                std::int64_t a, b;
+                valid = reader.read(command.type) && reader.read(command.flags) && reader.readSigned(a) && reader.readSigned(b);
+                if (valid && command.type == InputCommandType::SET_VIEW) {
+                    valid = reader.read(command.viewSize.x) && reader.read(command.viewSize.y);
+                }
+                command.a = static_cast<int>(a);
+                command.b = static_cast<int>(b);
+                commands.push_back(command);
+            }
+            if (!valid) {
+                break;
+            }
+            return true;
+        }
+        case RecordTag::LOAD: {
+            // Put the save where the simulation's LOAD will look for it
+            std::string save;
+            if (!reader.readString(save)) {
+                break;
+            }
+            std::remove(savePath.c_str());
+            if (!save.empty()) {
+                std::ofstream out(savePath, std::ios::binary | std::ios::trunc);
+                out.write(save.data(), static_cast<std::streamsize>(save.size()));
+            }
+            continue;
+        }
+        case RecordTag::CHECKSUM: {
+            // Only when verify() wasn't called for it
+            std::uint64_t tick, hash;
+            if (!reader.readVarint(tick) || !reader.read(hash)) {
+                break;
+            }
+            continue;
+        }
+        case RecordTag::END: {
+            std::uint64_t ticks;
+            if (!reader.readVarint(ticks) || !reader.read(recordedFinalHash)) {
+                break;
+            }
+            recordedTicks = static_cast<long long>(ticks);
+            finished = true;
+            return false;
+        }
+        }
+        break;
+    }
+
+    // A recording cut short (the game crashed) replays up to where it stops, which is often the point
+    if (!finished) {
+        std::cout << "Recording ends without a closing record after " << stepMilliseconds.size() << " ticks" << std::endl;
+        finished = true;
+    }
+    return false;
+}
+
+void InputReplay::verify(long long tick, std::uint64_t hash) {
+    size_t start = position;
+    RecordReader reader{ data, position };
+    std::uint8_t tag;
+    std::uint64_t recordedTick, recordedHash;
+    if (!reader.read(tag) || static_cast<RecordTag>(tag) != RecordTag::CHECKSUM ||
+        !reader.readVarint(recordedTick) || !reader.read(recordedHash)) {
+        position = start;
+        return;
+    }
+
+    if ((static_cast<long long>(recordedTick) != tick || recordedHash != hash) && firstMismatchTick < 0) {
+        firstMismatchTick = tick;
+        std::cout << "Replay diverged from the recording by tick " << tick << std::endl;
+    }
+}
+
+void InputReplay::verifyEnd(long long ticks, std::uint64_t hash) {
+    if (recordedTicks == 0) { // No closing record to compare with
+        return;
+    }
+    if ((ticks != recordedTicks || hash != recordedFinalHash) && firstMismatchTick < 0) {
+        firstMismatchTick = ticks;
+        std::cout << "Replay ended in a different state than the recording" << std::endl;
+    }
+}
+
+void printFrameTimes(const std::string& label, std::vector<float> milliseconds, float budgetMilliseconds) {
+    if (milliseconds.empty()) {
+        std::cout << label << ": no samples" << std::endl;
+        return;
+    }
+
+    std::sort(milliseconds.begin(), milliseconds.end());
+    double total = 0.0;
+    for (float value : milliseconds) {
+        total += value;
+    }
+    auto percentile = [&milliseconds](double fraction) {
+        return milliseconds[std::min(milliseconds.size() - 1, static_cast<size_t>(fraction * milliseconds.size()))];
+    };
+    long long overBudget = milliseconds.end() - std::upper_bound(milliseconds.begin(), milliseconds.end(), budgetMilliseconds);
+
+    std::cout << label << ": " << milliseconds.size() << " samples, mean " << total / milliseconds.size()
+        << " ms, p50 " << percentile(0.50) << ", p90 " << percentile(0.90) << ", p99 " << percentile(0.99)
+        << ", max " << milliseconds.back() << " ms, " << overBudget << " over " << budgetMilliseconds << " ms" << std::endl;
+}
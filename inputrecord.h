@@ -0,0 +1,87 @@
+#ifndef INPUTRECORD_H
+#define INPUTRECORD_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "input.h"
+#include "constants.h"
+
+class Map;
+class Player;
+class EntitySystem;
+class ItemDrops;
+
+const char RECORDING_MAGIC[4] = { 'S', 'A', 'E', 'R' };
+const std::uint32_t RECORDING_VERSION = 4; // 2: records whether the world is infinite; 3: chunk size and render distance; 4: traced rivers
+const int RECORDING_CHECK_TICKS = 60; // A state hash is recorded this often
+
+// Hash of everything the simulation decides: the player, inventory, loaded tiles, world
+// edits, mobs and item drops. Equal hashes mean a replay is still on the recorded track.
+std::uint64_t hashGameState(const Map& gameMap, const Player& player, const EntitySystem& entities, const ItemDrops& itemDrops);
+
+// Writes what a simulation consumed: the save it started from, then every tick's dt and
+// input commands, the save files it loaded, and a state hash every RECORDING_CHECK_TICKS.
+// Commands are a few bytes each (variable-length integers), so an idle tick costs five.
+class InputRecorder {
+public:
+    // startSavePath: the save the session was resumed from, or empty for a fresh world
+    bool open(const std::string& path, const Map& gameMap, float tickRate, const std::string& startSavePath);
+    bool isOpen() const { return file.is_open(); }
+
+    void recordTick(float dt, const std::vector<InputCommand>& commands);
+    void recordLoad(const std::string& savePath); // The file a LOAD command in the next tick reads
+    void recordChecksum(long long tick, std::uint64_t hash);
+    void close(long long ticks, std::uint64_t hash);
+
+    long long getBytesWritten() const { return bytesWritten; }
+
+private:
+    std::ofstream file;
+    std::string buffer;
+    long long bytesWritten = 0;
+
+    void flush();
+};
+
+// Plays a recording back into a Simulation: ticks come from the file instead of the clock
+// and the input queue, and every recorded state hash is checked. Saves the recording loads
+// are written to a scratch file next to it, so a replay never touches the real save.
+class InputReplay {
+public:
+    bool open(const std::string& path, const Map& gameMap); // False if unreadable or made in another world
+    float getTickRate() const { return tickRate; }
+    int getRenderDistance() const { return renderDistance; } // Streams what the recording streamed
+    const std::string& getSavePath() const { return savePath; }
+    bool prepareStartSave(); // Writes the save the recording started from; false if it started fresh
+
+    bool readTick(float& dt, std::vector<InputCommand>& commands); // False once the recording ends
+    void verify(long long tick, std::uint64_t hash);                // After the step of tick
+    void verifyEnd(long long ticks, std::uint64_t hash);            // After the last recorded step
+
+    bool isFinished() const { return finished; }
+    bool matched() const { return firstMismatchTick < 0; }
+    long long getFirstMismatchTick() const { return firstMismatchTick; }
+    long long getRecordedTicks() const { return recordedTicks; }
+
+    // Simulation step time of every replayed tick, for the report
+    std::vector<float> stepMilliseconds;
+
+private:
+    std::vector<char> data;
+    size_t position = 0;
+    float tickRate = 60.0f;
+    int renderDistance = RENDER_DISTANCE;
+    std::string savePath;
+    std::string startSave;
+    bool finished = false;
+    long long firstMismatchTick = -1;
+    long long recordedTicks = 0;
+    std::uint64_t recordedFinalHash = 0;
+};
+
+// Mean, percentiles and hitches over the budget, one line, for comparing runs
+void printFrameTimes(const std::string& label, std::vector<float> milliseconds, float budgetMilliseconds);
+
+#endif
@@ -0,0 +1,170 @@
+#include "itemdrops.h"
+#include "player.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace {
+    int cellCoord(double pixels) {
+        return static_cast<int>(std::floor(pixels / ITEM_MERGE_RADIUS));
+    }
+
+    std::int64_t cellKey(int cellX, int cellY) {
+        return static_cast<std::int64_t>((static_cast<std::uint64_t>(static_cast<std::uint32_t>(cellX)) << 32) | static_cast<std::uint32_t>(cellY));
+    }
+
+    EntitySprite spriteFor(int itemId) {
+        switch (itemId) {
+        case 2: return EntitySprite::ITEM_STONE;
+        case 4: return EntitySprite::ITEM_WOOD;
+        default: return EntitySprite::ITEM_OTHER;
+        }
+    }
+}
+
+std::int64_t ItemDrops::cellOf(double x, double y) {
+    return cellKey(cellCoord(x), cellCoord(y));
+}
+
+int ItemDrops::findNearest(int item, double x, double y, double radius) const {
+    int nearest = -1;
+    double nearestDistance = radius * radius;
+    auto consider = [&](int index) {
+        if (itemId[index] != item) {
+            return;
+        }
+        double dx = positionX[index] - x;
+        double dy = positionY[index] - y;
+        double distance = dx * dx + dy * dy;
+        if (distance <= nearestDistance) {
+            nearest = index;
+            nearestDistance = distance;
+        }
+    };
+
+    // Cells are as wide as the merge radius, so the 3x3 around the point covers it
+    if (radius <= ITEM_MERGE_RADIUS) {
+        int centerX = cellCoord(x);
+        int centerY = cellCoord(y);
+        for (int cellY = centerY - 1; cellY <= centerY + 1; cellY++) {
+            for (int cellX = centerX - 1; cellX <= centerX + 1; cellX++) {
+                auto cellIt = cells.find(cellKey(cellX, cellY));
+                if (cellIt != cells.end()) {
+                    for (int index : cellIt->second) {
+                        consider(index);
+                    }
+                }
+            }
+        }
+    }
+    else {
+        for (int index = 0; index < size(); index++) {
+            consider(index);
+        }
+    }
+    return nearest;
+}
+
+void ItemDrops::drop(int item, int amount, WorldVector position) {
+    if (amount <= 0) {
+        return;
+    }
+
+    int target = findNearest(item, position.x, position.y, ITEM_MERGE_RADIUS);
+    if (target < 0 && size() >= MAX_ITEM_DROPS) {
+        target = findNearest(item, position.x, position.y, std::numeric_limits<double>::max());
+    }
+    if (target >= 0) {
+        quantity[target] += amount;
+        return;
+    }
+
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    itemId.push_back(item);
+    quantity.push_back(amount);
+    cells[cellOf(position.x, position.y)].push_back(size() - 1);
+}
+
+void ItemDrops::remove(int index) {
+    int last = size() - 1;
+
+    std::vector<int>& cell = cells[cellOf(positionX[index], positionY[index])];
+    cell.erase(std::find(cell.begin(), cell.end(), index));
+    if (cell.empty()) {
+        cells.erase(cellOf(positionX[index], positionY[index]));
+    }
+
+    // Swap the last stack into the hole and fix its cell entry
+    if (index != last) {
+        std::vector<int>& lastCell = cells[cellOf(positionX[last], positionY[last])];
+        *std::find(lastCell.begin(), lastCell.end(), last) = index;
+
+        positionX[index] = positionX[last];
+        positionY[index] = positionY[last];
+        itemId[index] = itemId[last];
+        quantity[index] = quantity[last];
+    }
+
+    positionX.pop_back();
+    positionY.pop_back();
+    itemId.pop_back();
+    quantity.pop_back();
+}
+
+void ItemDrops::pickUp(Player& player) {
+    WorldVector playerPos = player.getPosition();
+    double radiusSquared = ITEM_PICKUP_RADIUS * ITEM_PICKUP_RADIUS;
+
+    std::vector<int> emptied;
+    for (int cellY = cellCoord(playerPos.y - ITEM_PICKUP_RADIUS); cellY <= cellCoord(playerPos.y + ITEM_PICKUP_RADIUS); cellY++) {
+        for (int cellX = cellCoord(playerPos.x - ITEM_PICKUP_RADIUS); cellX <= cellCoord(playerPos.x + ITEM_PICKUP_RADIUS); cellX++) {
+            auto cellIt = cells.find(cellKey(cellX, cellY));
+            if (cellIt == cells.end()) {
+                continue;
+            }
+
+            for (int index : cellIt->second) {
+                double dx = positionX[index] - playerPos.x;
+                double dy = positionY[index] - playerPos.y;
+                if (dx * dx + dy * dy > radiusSquared) {
+                    continue;
+                }
+
+                // Whatever doesn't fit stays on the ground
+                quantity[index] -= player.addItemUpTo(itemId[index], quantity[index]);
+                if (quantity[index] <= 0) {
+                    emptied.push_back(index);
+                }
+            }
+        }
+    }
+
+    // Highest index first, so swapping the last stack in never moves one still to be removed
+    std::sort(emptied.begin(), emptied.end(), std::greater<int>());
+    for (int index : emptied) {
+        remove(index);
+    }
+}
+
+void ItemDrops::clear() {
+    positionX.clear();
+    positionY.clear();
+    itemId.clear();
+    quantity.clear();
+    cells.clear();
+}
+
+void ItemDrops::collectVisible(WorldRect area, const RenderOrigin& origin, EntityView& out) const {
+    double left = area.position.x - ENTITY_SIZE;
+    double top = area.position.y - ENTITY_SIZE;
+    double right = area.position.x + area.size.x + ENTITY_SIZE;
+    double bottom = area.position.y + area.size.y + ENTITY_SIZE;
+
+    for (int i = 0; i < size(); i++) {
+        if (positionX[i] >= left && positionX[i] <= right && positionY[i] >= top && positionY[i] <= bottom) {
+            out.positions.push_back(origin.toLocal({ positionX[i], positionY[i] }));
+            out.sprites.push_back(static_cast<std::uint16_t>(spriteFor(itemId[i])));
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef ITEMDROPS_H
+#define ITEMDROPS_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "constants.h"
+#include "entities.h"
+
+class Player; // Forward declaration
+
+// Item stacks lying in the world. Stored as a struct of arrays like EntitySystem, and
+// bucketed in a grid of ITEM_MERGE_RADIUS cells so a new drop only has to look at the
+// 3x3 cells around it to find a stack of the same item to merge into. Two stacks of
+// the same item therefore never lie within ITEM_MERGE_RADIUS of each other, and past
+// MAX_ITEM_DROPS a drop merges into the closest stack of its item wherever it is.
+class ItemDrops {
+public:
+    std::vector<double> positionX; // Pixels
+    std::vector<double> positionY;
+    std::vector<int> itemId;
+    std::vector<int> quantity;
+
+    void drop(int item, int amount, WorldVector position);
+    void pickUp(Player& player); // Moves stacks within ITEM_PICKUP_RADIUS into the inventory
+    void clear();
+    int size() const { return static_cast<int>(positionX.size()); }
+
+    // Appends the visible stacks to out, relative to origin
+    void collectVisible(WorldRect area, const RenderOrigin& origin, EntityView& out) const;
+
+private:
+    std::unordered_map<std::int64_t, std::vector<int>> cells;
+
+    static std::int64_t cellOf(double x, double y);
+    int findNearest(int item, double x, double y, double radius) const; // -1 if none
+    void remove(int index);
+};
+
+#endif
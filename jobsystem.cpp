@@ -0,0 +1,196 @@
+#include "jobsystem.h"
+#include <algorithm>
+
+namespace {
+    thread_local JobSystem* currentSystem = nullptr;
+    thread_local int currentIndex = -1;
+}
+
+JobSystem::JobSystem(unsigned workerCount) {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < workerCount; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    // Start threads only once every deque exists, since workers steal from each other
+    for (unsigned i = 0; i < workerCount; i++) {
+        workers[i]->thread = std::thread(&JobSystem::run, this, static_cast<int>(i));
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+int JobSystem::currentWorkerIndex() {
+    return currentIndex;
+}
+
+JobHandle JobSystem::submit(std::function<void()> work, const std::vector<JobHandle>& dependencies) {
+    JobHandle job = std::make_shared<Job>();
+    job->work = std::move(work);
+
+    // One extra count so the job can't start while dependencies are still being registered
+    job->unfinishedDependencies = static_cast<int>(dependencies.size()) + 1;
+    for (const JobHandle& dependency : dependencies) {
+        std::lock_guard<std::mutex> lock(dependency->continuationMutex);
+        if (dependency->done) {
+            job->unfinishedDependencies--;
+        }
+        else {
+            dependency->continuations.push_back(job);
+        }
+    }
+
+    if (--job->unfinishedDependencies == 0) {
+        schedule(job);
+    }
+    return job;
+}
+
+void JobSystem::schedule(JobHandle job) {
+    if (currentSystem == this) {
+        Worker& worker = *workers[currentIndex];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_back(std::move(job));
+    }
+    else {
+        std::lock_guard<std::mutex> lock(injectionMutex);
+        injectionQueue.push_back(std::move(job));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedJobs++;
+    }
+    wakeUp.notify_one();
+}
+
+JobHandle JobSystem::findJob(int workerIndex) {
+    JobHandle job;
+
+    // Own deque first, newest job (its data is most likely still in cache)
+    {
+        Worker& worker = *workers[workerIndex];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.jobs.empty()) {
+            job = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+        }
+    }
+
+    if (!job) {
+        std::lock_guard<std::mutex> lock(injectionMutex);
+        if (!injectionQueue.empty()) {
+            job = std::move(injectionQueue.front());
+            injectionQueue.pop_front();
+        }
+    }
+
+    // Steal the oldest job from another worker
+    int workerCount = static_cast<int>(workers.size());
+    for (int offset = 1; !job && offset < workerCount; offset++) {
+        Worker& victim = *workers[(workerIndex + offset) % workerCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            jobsStolen++;
+        }
+    }
+
+    if (job) {
+        queuedJobs--;
+    }
+    return job;
+}
+
+void JobSystem::execute(const JobHandle& job) {
+    job->work();
+    jobsExecuted++;
+
+    std::vector<JobHandle> ready;
+    {
+        std::lock_guard<std::mutex> lock(job->continuationMutex);
+        job->done = true;
+        ready.swap(job->continuations);
+    }
+    for (JobHandle& continuation : ready) {
+        if (--continuation->unfinishedDependencies == 0) {
+            schedule(std::move(continuation));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    jobFinished.notify_all();
+}
+
+void JobSystem::wait(const JobHandle& job) {
+    if (currentSystem == this) {
+        // Keep this worker busy instead of blocking it
+        while (!job->done) {
+            if (JobHandle other = findJob(currentIndex)) {
+                execute(other);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    jobFinished.wait(lock, [&job] { return job->done.load(); });
+}
+
+void JobSystem::waitAll(const std::vector<JobHandle>& jobs) {
+    for (const JobHandle& job : jobs) {
+        wait(job);
+    }
+}
+
+void JobSystem::parallelFor(int first, int last, int grainSize, const std::function<void(int, int)>& body) {
+    grainSize = std::max(1, grainSize);
+
+    std::vector<JobHandle> jobs;
+    jobs.reserve((std::max(0, last - first) + grainSize - 1) / grainSize);
+    for (int begin = first; begin < last; begin += grainSize) {
+        int end = std::min(last, begin + grainSize);
+        jobs.push_back(submit([&body, begin, end]() { body(begin, end); }));
+    }
+    waitAll(jobs);
+}
+
+void JobSystem::run(int workerIndex) {
+    currentSystem = this;
+    currentIndex = workerIndex;
+
+    while (true) {
+        if (JobHandle job = findJob(workerIndex)) {
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        if (stopping && queuedJobs == 0) {
+            return;
+        }
+        wakeUp.wait(lock, [this] { return queuedJobs > 0 || stopping; });
+    }
+}
+
+JobSystem& getJobSystem() {
+    static JobSystem jobSystem;
+    return jobSystem;
+}
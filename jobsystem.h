@@ -0,0 +1,80 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// A unit of work. Handles are shared so a job can be waited on or depended on after submission.
+struct Job {
+    std::function<void()> work;
+    std::atomic<int> unfinishedDependencies{ 0 };
+    std::atomic<bool> done{ false };
+
+    std::mutex continuationMutex;
+    std::vector<std::shared_ptr<Job>> continuations; // Jobs waiting on this one
+};
+
+using JobHandle = std::shared_ptr<Job>;
+
+// Work-stealing scheduler. Each worker pushes and pops jobs at the back of its own deque
+// and steals from the front of the others' when it runs dry; jobs submitted from outside
+// the pool go through a shared queue. Workers waiting on a job keep running other jobs,
+// threads outside the pool just block.
+class JobSystem {
+public:
+    explicit JobSystem(unsigned workerCount = 0); // 0 = one worker per hardware thread
+    ~JobSystem(); // Finishes all queued jobs first
+
+    // Runs once every dependency has finished
+    JobHandle submit(std::function<void()> work, const std::vector<JobHandle>& dependencies = {});
+    void wait(const JobHandle& job);
+    void waitAll(const std::vector<JobHandle>& jobs);
+
+    // Calls body(begin, end) over [first, last) split into ranges of at most grainSize, and waits
+    void parallelFor(int first, int last, int grainSize, const std::function<void(int, int)>& body);
+
+    unsigned getWorkerCount() const { return static_cast<unsigned>(workers.size()); }
+
+    // Index of the calling worker thread in its pool, or -1 outside any pool. Lets jobs use
+    // per-worker state such as a WorldGenerator without locking.
+    static int currentWorkerIndex();
+
+    long long getJobsExecuted() const { return jobsExecuted; }
+    long long getJobsStolen() const { return jobsStolen; }
+
+private:
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::deque<JobHandle> jobs;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex injectionMutex;
+    std::deque<JobHandle> injectionQueue;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::condition_variable jobFinished;
+    std::atomic<int> queuedJobs{ 0 };
+    std::atomic<bool> stopping{ false };
+
+    std::atomic<long long> jobsExecuted{ 0 };
+    std::atomic<long long> jobsStolen{ 0 };
+
+    void schedule(JobHandle job);
+    JobHandle findJob(int workerIndex);
+    void execute(const JobHandle& job);
+    void run(int workerIndex);
+};
+
+// Process-wide pool shared by terrain generation, asset loading, map updates and saving
+JobSystem& getJobSystem();
+
+#endif
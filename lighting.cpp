@@ -0,0 +1,192 @@
+#include "lighting.h"
+#include "map.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    const int LIGHT_AREA_CHUNKS = 2 * LIGHT_REACH_CHUNKS + 1; // The chunk and every chunk a torch can light it from
+    const int LIGHT_AREA = CHUNK_SIZE * LIGHT_AREA_CHUNKS;
+    static_assert(LIGHT_AREA * LIGHT_AREA <= 65536, "Light queue entries are 16-bit tile indices");
+
+    bool isOpaque(TileType tileType) {
+        return tileType == TileType::TREE || tileType == TileType::STONE;
+    }
+
+    // Multiplied over the frame: the brighter of daylight and the torch color scaled by the lightmap
+    const char* LIGHT_SHADER =
+        "uniform sampler2D texture;\n"
+        "uniform vec3 ambient;\n"
+        "uniform vec3 torchColor;\n"
+        "void main() {\n"
+        "    float torch = texture2D(texture, gl_TexCoord[0].xy).r;\n"
+        "    gl_FragColor = vec4(max(ambient, torchColor * torch), 1.0);\n"
+        "}\n";
+
+    const sf::Vector3f NIGHT_LIGHT = { 0.12f, 0.14f, 0.28f };
+    const sf::Vector3f TORCH_COLOR = { 1.0f, 0.85f, 0.6f };
+}
+
+void computeChunkLight(const LoadedChunks& chunks, Chunk& chunk) {
+    const Chunk* area[LIGHT_AREA_CHUNKS][LIGHT_AREA_CHUNKS];
+    bool hasTorch = false;
+    for (int offsetY = -LIGHT_REACH_CHUNKS; offsetY <= LIGHT_REACH_CHUNKS; offsetY++) {
+        for (int offsetX = -LIGHT_REACH_CHUNKS; offsetX <= LIGHT_REACH_CHUNKS; offsetX++) {
+            auto chunkIt = chunks.find({ chunk.coord.x + offsetX, chunk.coord.y + offsetY });
+            const Chunk* neighbor = (chunkIt != chunks.end()) ? chunkIt->second.get() : nullptr;
+            area[offsetY + LIGHT_REACH_CHUNKS][offsetX + LIGHT_REACH_CHUNKS] = neighbor;
+            hasTorch = hasTorch || (neighbor && !neighbor->torchTiles.empty());
+        }
+    }
+
+    if (!hasTorch) {
+        std::memset(chunk.light, 0, sizeof(chunk.light));
+        return;
+    }
+
+    std::uint8_t opaque[LIGHT_AREA][LIGHT_AREA];
+    std::uint8_t light[LIGHT_AREA][LIGHT_AREA];
+    std::memset(light, 0, sizeof(light));
+    std::vector<std::uint16_t> queue;
+
+    for (int areaY = 0; areaY < LIGHT_AREA_CHUNKS; areaY++) {
+        for (int areaX = 0; areaX < LIGHT_AREA_CHUNKS; areaX++) {
+            const Chunk* source = area[areaY][areaX];
+            for (int y = 0; y < CHUNK_SIZE; y++) {
+                for (int x = 0; x < CHUNK_SIZE; x++) {
+                    opaque[areaY * CHUNK_SIZE + y][areaX * CHUNK_SIZE + x] = !source || isOpaque(source->tileTypes[y][x]);
+                }
+            }
+            if (!source) {
+                continue;
+            }
+            for (std::uint16_t tileIndex : source->torchTiles) {
+                int x = areaX * CHUNK_SIZE + tileIndex % CHUNK_SIZE;
+                int y = areaY * CHUNK_SIZE + tileIndex / CHUNK_SIZE;
+                light[y][x] = TORCH_LIGHT;
+                queue.push_back(static_cast<std::uint16_t>(y * LIGHT_AREA + x));
+            }
+        }
+    }
+
+    // Every torch starts at the same level, so plain breadth-first order visits each tile at its brightest first.
+    // Opaque tiles are lit on their face but pass nothing on.
+    static const int OFFSETS[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+    for (size_t head = 0; head < queue.size(); head++) {
+        int x = queue[head] % LIGHT_AREA;
+        int y = queue[head] / LIGHT_AREA;
+        int level = light[y][x];
+        if (level <= 1 || opaque[y][x]) {
+            continue;
+        }
+
+        for (const auto& offset : OFFSETS) {
+            int neighborX = x + offset[0];
+            int neighborY = y + offset[1];
+            if (neighborX < 0 || neighborX >= LIGHT_AREA || neighborY < 0 || neighborY >= LIGHT_AREA) {
+                continue;
+            }
+            if (light[neighborY][neighborX] < level - 1) {
+                light[neighborY][neighborX] = static_cast<std::uint8_t>(level - 1);
+                queue.push_back(static_cast<std::uint16_t>(neighborY * LIGHT_AREA + neighborX));
+            }
+        }
+    }
+
+    for (int y = 0; y < CHUNK_SIZE; y++) {
+        std::memcpy(chunk.light[y], &light[LIGHT_REACH_CHUNKS * CHUNK_SIZE + y][LIGHT_REACH_CHUNKS * CHUNK_SIZE], CHUNK_SIZE);
+    }
+}
+
+LightRenderer::LightRenderer() {
+    if (sf::Shader::isAvailable() && shader.loadFromMemory(LIGHT_SHADER, sf::Shader::Type::Fragment)) {
+        shader.setUniform("texture", sf::Shader::CurrentTexture);
+        shader.setUniform("torchColor", sf::Glsl::Vec3(TORCH_COLOR));
+        shaderLoaded = true;
+    }
+    else {
+        std::cout << "Lighting shader unavailable, drawing daylight only" << std::endl;
+    }
+}
+
+sf::Vector3f LightRenderer::getAmbientLight(float timeOfDay) {
+    // Sun height from 0 at midnight to 1 at noon, sharpened so days and nights are long and dusk is short
+    float sun = 0.5f - 0.5f * std::cos(timeOfDay * 2.0f * 3.14159265f);
+    float daylight = std::max(0.0f, std::min(1.0f, (sun - 0.3f) * 2.5f));
+    return NIGHT_LIGHT + (sf::Vector3f(1.0f, 1.0f, 1.0f) - NIGHT_LIGHT) * daylight;
+}
+
+void LightRenderer::draw(sf::RenderWindow& window, const sf::View& camera, const RenderOrigin& origin, const std::vector<std::shared_ptr<const ChunkMesh>>& chunks, float timeOfDay) {
+    sf::Vector3f ambient = getAmbientLight(timeOfDay);
+    if (ambient.x >= 1.0f && ambient.y >= 1.0f && ambient.z >= 1.0f) {
+        return; // Full daylight outshines every torch
+    }
+
+    int startX, startY, endX, endY;
+    Map::getVisibleTileRange(origin.toWorld(camera.getCenter()), camera.getSize(), startX, startY, endX, endY);
+    startX -= floorMod(startX, CHUNK_SIZE);
+    startY -= floorMod(startY, CHUNK_SIZE);
+    sf::Vector2u size = { static_cast<unsigned>(std::max(1, endX - startX)), static_cast<unsigned>(std::max(1, endY - startY)) };
+
+    sf::Vector2f topLeft = origin.tileToLocal(startX, startY);
+    sf::Vector2f bottomRight = topLeft + sf::Vector2f(static_cast<float>(size.x * TILE_SIZE), static_cast<float>(size.y * TILE_SIZE));
+    quad[0].position = topLeft;
+    quad[1].position = { bottomRight.x, topLeft.y };
+    quad[2].position = { topLeft.x, bottomRight.y };
+    quad[3].position = bottomRight;
+
+    sf::RenderStates states;
+    states.blendMode = sf::BlendMultiply;
+
+    if (!shaderLoaded) {
+        sf::Color color(static_cast<std::uint8_t>(ambient.x * 255), static_cast<std::uint8_t>(ambient.y * 255), static_cast<std::uint8_t>(ambient.z * 255));
+        for (int i = 0; i < 4; i++) {
+            quad[i].color = color;
+        }
+        window.draw(quad, states);
+        return;
+    }
+
+    // One lightmap pixel per tile, smoothed between tile centers by the texture filter
+    if (size != lightmapSize) {
+        if (!lightmap.resize(size)) {
+            return;
+        }
+        lightmap.setSmooth(true);
+        lightmapSize = size;
+    }
+    lightmapPixels.assign(static_cast<size_t>(size.x) * size.y * 4, 0);
+
+    for (const auto& mesh : chunks) {
+        int chunkStartX = static_cast<int>(mesh->coord.x * CHUNK_SIZE - startX);
+        int chunkStartY = static_cast<int>(mesh->coord.y * CHUNK_SIZE - startY);
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            int pixelY = chunkStartY + y;
+            if (pixelY < 0 || pixelY >= static_cast<int>(size.y)) {
+                continue;
+            }
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                int pixelX = chunkStartX + x;
+                if (pixelX < 0 || pixelX >= static_cast<int>(size.x) || mesh->light[y][x] == 0) {
+                    continue;
+                }
+                lightmapPixels[(static_cast<size_t>(pixelY) * size.x + pixelX) * 4] = static_cast<std::uint8_t>(mesh->light[y][x] * 255 / TORCH_LIGHT);
+            }
+        }
+    }
+    lightmap.update(lightmapPixels.data(), size, { 0, 0 });
+
+    quad[0].texCoords = { 0.0f, 0.0f };
+    quad[1].texCoords = { static_cast<float>(size.x), 0.0f };
+    quad[2].texCoords = { 0.0f, static_cast<float>(size.y) };
+    quad[3].texCoords = { static_cast<float>(size.x), static_cast<float>(size.y) };
+    for (int i = 0; i < 4; i++) {
+        quad[i].color = sf::Color::White;
+    }
+
+    shader.setUniform("ambient", sf::Glsl::Vec3(ambient));
+    states.texture = &lightmap;
+    states.shader = &shader;
+    window.draw(quad, states);
+}
@@ -0,0 +1,40 @@
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "constants.h"
+#include "chunk.h"
+#include "water.h"
+
+// Recomputes a chunk's torch light: breadth-first from every torch in it and the chunks
+// within LIGHT_REACH_CHUNKS of it, one level less per tile, stopped by trees and stone. No
+// torch further out can reach it. Unloaded neighbors are dark and opaque; loading one marks
+// its surroundings for another pass.
+void computeChunkLight(const LoadedChunks& chunks, Chunk& chunk);
+
+// Draws the day/night cycle and torch light over everything drawn so far in one fragment
+// shader pass. The visible chunks' light levels go into a small lightmap texture, and the
+// shader multiplies the frame by max(ambient daylight, torch light). Without shader
+// support only the ambient light is applied.
+class LightRenderer {
+public:
+    LightRenderer();
+
+    void draw(sf::RenderWindow& window, const sf::View& camera, const RenderOrigin& origin, const std::vector<std::shared_ptr<const ChunkMesh>>& chunks, float timeOfDay);
+
+    static sf::Vector3f getAmbientLight(float timeOfDay); // timeOfDay: 0 = midnight, 0.5 = noon
+
+private:
+    sf::Shader shader;
+    bool shaderLoaded = false;
+
+    sf::Texture lightmap;
+    sf::Vector2u lightmapSize;
+    std::vector<std::uint8_t> lightmapPixels; // RGBA, light level in red
+    sf::VertexArray quad{ sf::PrimitiveType::TriangleStrip, 4 };
+};
+
+#endif
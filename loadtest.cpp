@@ -0,0 +1,208 @@
+// Load test client: connects a crowd of bots to a server. Each bot wanders and fells the trees
+// it finds in the chunks it was sent. Reports bandwidth each second and at the end, with the
+// tick times the server reports about itself.
+//
+// Usage: loadtest [BOTS] [--seconds N] [--host ADDRESS] [--port N]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+
+#include "constants.h"
+#include "input.h"
+#include "netclient.h"
+
+namespace {
+    struct Bot {
+        std::unique_ptr<NetClient> client;
+        std::uint32_t rngState = 0;
+        float decisionTimer = 0.0f;
+        float harvestTimer = 0.0f; // Standing still while the server harvests
+    };
+
+    std::uint32_t nextRandom(std::uint32_t& state) {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Movement flags for each of the eight directions
+    const std::uint8_t DIRECTIONS[8] = {
+        INPUT_RIGHT, INPUT_RIGHT | INPUT_DOWN, INPUT_DOWN, INPUT_LEFT | INPUT_DOWN,
+        INPUT_LEFT, INPUT_LEFT | INPUT_UP, INPUT_UP, INPUT_RIGHT | INPUT_UP
+    };
+
+    void sendCommand(NetClient& client, InputCommandType type, std::uint8_t flags = 0, int a = 0, int b = 0) {
+        InputCommand command;
+        command.type = type;
+        command.flags = flags;
+        command.a = a;
+        command.b = b;
+        client.sendCommand(command);
+    }
+
+    // Harvest a tree in reach if the bot knows of one, otherwise walk somewhere for a while
+    void think(Bot& bot, float dt, long long& harvestsStarted) {
+        NetClient& client = *bot.client;
+        if (bot.harvestTimer > 0.0f) {
+            bot.harvestTimer -= dt;
+            return;
+        }
+        bot.decisionTimer -= dt;
+        if (bot.decisionTimer > 0.0f) {
+            return;
+        }
+
+        std::uint32_t roll = nextRandom(bot.rngState);
+        int tileX = static_cast<int>(client.position.x) / TILE_SIZE;
+        int tileY = static_cast<int>(client.position.y) / TILE_SIZE;
+        if (roll % 2 == 0) {
+            for (int y = tileY - 3; y <= tileY + 3; y++) {
+                for (int x = tileX - 3; x <= tileX + 3; x++) {
+                    TileType tileType;
+                    if (client.getTile(x, y, tileType) && tileType == TileType::TREE) {
+                        sendCommand(client, InputCommandType::MOVEMENT);
+                        sendCommand(client, InputCommandType::HARVEST_TILE, 0, x, y);
+                        bot.harvestTimer = 6.0f; // Base harvest time plus a little
+                        harvestsStarted++;
+                        return;
+                    }
+                }
+            }
+        }
+
+        // One of eight directions, or standing still now and then
+        std::uint8_t flags = ((roll >> 8) % 5 == 0) ? 0 : DIRECTIONS[(roll >> 12) & 7];
+        sendCommand(client, InputCommandType::MOVEMENT, flags);
+        bot.decisionTimer = 1.0f + static_cast<float>((roll >> 16) % 2000) / 1000.0f;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int botCount = 200;
+    int seconds = 30;
+    std::string host = "127.0.0.1";
+    unsigned short port = SERVER_PORT;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seconds" && hasValue) seconds = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--host" && hasValue) host = argv[++i];
+        else if (arg == "--port" && hasValue) port = static_cast<unsigned short>(std::atoi(argv[++i]));
+        else if (!arg.empty() && arg[0] != '-') botCount = std::max(1, std::atoi(arg.c_str()));
+        else {
+            std::cout << "Usage: loadtest [BOTS] [--seconds N] [--host ADDRESS] [--port N]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Bot> bots(botCount);
+    for (int i = 0; i < botCount; i++) {
+        bots[i].client = std::make_unique<NetClient>();
+        bots[i].rngState = 0x9E3779B9u * static_cast<std::uint32_t>(i + 1);
+        if (!bots[i].client->connect(host, port)) {
+            std::cout << "Bot " << i << " could not connect to " << host << ":" << port << std::endl;
+            return 1;
+        }
+    }
+    std::cout << botCount << " bots connected to " << host << ":" << port << ", running for " << seconds << " seconds" << std::endl;
+
+    using clock = std::chrono::steady_clock;
+    const float dt = 1.0f / 60.0f;
+    const clock::duration frameLength = std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(dt));
+    clock::time_point start = clock::now();
+    clock::time_point nextFrame = start + frameLength;
+    clock::time_point nextReport = start + std::chrono::seconds(1);
+
+    long long harvestsStarted = 0;
+    NetClientStats lastTotals;
+    std::vector<float> serverAverages, serverMaxima;
+    int secondsElapsed = 0;
+
+    auto totals = [&bots]() {
+        NetClientStats sum;
+        for (const Bot& bot : bots) {
+            const NetClientStats& stats = bot.client->stats;
+            sum.bytesReceived += stats.bytesReceived;
+            sum.bytesSent += stats.bytesSent;
+            sum.chunksReceived += stats.chunksReceived;
+            sum.chunkBytes += stats.chunkBytes;
+            sum.chunksDropped += stats.chunksDropped;
+            sum.tileDeltas += stats.tileDeltas;
+        }
+        return sum;
+    };
+
+    while (secondsElapsed < seconds) {
+        int connected = 0;
+        for (Bot& bot : bots) {
+            if (!bot.client->poll()) {
+                continue;
+            }
+            connected++;
+            if (bot.client->welcomed) {
+                think(bot, dt, harvestsStarted);
+            }
+        }
+        if (connected == 0) {
+            std::cout << "Every bot lost its connection" << std::endl;
+            return 1;
+        }
+
+        if (clock::now() >= nextReport) {
+            nextReport += std::chrono::seconds(1);
+            secondsElapsed++;
+
+            NetClientStats now = totals();
+            const NetClient& reporter = *bots.front().client;
+            if (reporter.serverClients > 0) {
+                serverAverages.push_back(reporter.serverTickMilliseconds);
+                serverMaxima.push_back(reporter.serverMaxTickMilliseconds);
+            }
+            std::cout << secondsElapsed << "s: " << connected << " bots | down " << (now.bytesReceived - lastTotals.bytesReceived) / 1024
+                << " KB/s (" << (now.bytesReceived - lastTotals.bytesReceived) / connected << " B/s per bot) | up "
+                << (now.bytesSent - lastTotals.bytesSent) / 1024 << " KB/s | chunks " << now.chunksReceived - lastTotals.chunksReceived
+                << " | deltas " << now.tileDeltas - lastTotals.tileDeltas << " | server tick " << reporter.serverTickMilliseconds
+                << " ms avg, " << reporter.serverMaxTickMilliseconds << " ms max" << std::endl;
+            lastTotals = now;
+        }
+
+        nextFrame += frameLength;
+        if (nextFrame < clock::now()) {
+            nextFrame = clock::now() + frameLength;
+        }
+        std::this_thread::sleep_until(nextFrame);
+    }
+
+    NetClientStats sum = totals();
+    double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    std::cout << "Received " << sum.bytesReceived / 1024 << " KB (" << sum.bytesReceived / elapsed / botCount / 1024.0
+        << " KB/s per bot), sent " << sum.bytesSent / 1024 << " KB (" << sum.bytesSent / elapsed / botCount << " B/s per bot)" << std::endl;
+    if (sum.chunksReceived > 0) {
+        double averageChunk = static_cast<double>(sum.chunkBytes) / sum.chunksReceived;
+        std::cout << "Chunks: " << sum.chunksReceived << " received, " << sum.chunksDropped << " dropped, " << averageChunk
+            << " bytes each against " << CHUNK_SIZE * CHUNK_SIZE << " raw (" << (CHUNK_SIZE * CHUNK_SIZE) / averageChunk << "x)" << std::endl;
+    }
+    std::cout << "Harvests started: " << harvestsStarted << ", tile deltas received: " << sum.tileDeltas << std::endl;
+
+    if (serverAverages.empty()) {
+        std::cout << "The server never reported its tick time" << std::endl;
+        return 1;
+    }
+    double averageTotal = 0.0;
+    for (float average : serverAverages) averageTotal += average;
+    float worstAverage = *std::max_element(serverAverages.begin(), serverAverages.end());
+    float worstTick = *std::max_element(serverMaxima.begin(), serverMaxima.end());
+    const float budget = 1000.0f / bots.front().client->serverTickRate;
+    std::cout << "Server tick: avg " << averageTotal / serverAverages.size() << " ms, worst second " << worstAverage
+        << " ms, longest " << worstTick << " ms against a " << budget << " ms tick: " << (worstAverage <= budget ? "PASS" : "FAIL") << std::endl;
+    return worstAverage <= budget ? 0 : 1;
+}
@@ -1,23 +1,118 @@
 ﻿#include <SFML/Graphics.hpp>
 #include <iostream>
 #include <optional>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <cstdlib>
 #include "constants.h"
 #include "map.h"
 #include "player.h"
 #include "ui.h"
+#include "savegame.h"
+#include "simulation.h"
+#include "lighting.h"
+#include "inputrecord.h"
+
+int main(int argc, char* argv[]) {
+    // --record PATH writes the session's input to a file; --replay PATH plays one back
+    // instead of live input, with --fast as quickly as it can step and draw. --infinite drops
+    // the world's edges and generates terrain as far as the player walks. --render-distance N
+    // keeps N chunks loaded each way around the player. --terrain sprites draws terrain a
+    // sprite per tile instead of with the tilemap shader, e.g. to compare a replay's frame times.
+    std::string recordPath;
+    std::string replayPath;
+    bool fastReplay = false;
+    bool infinite = false;
+    int renderDistance = RENDER_DISTANCE;
+    bool tilemapShader = true;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--record" && hasValue) recordPath = argv[++i];
+        else if (arg == "--replay" && hasValue) replayPath = argv[++i];
+        else if (arg == "--fast") fastReplay = true;
+        else if (arg == "--infinite") infinite = true;
+        else if (arg == "--render-distance" && hasValue) renderDistance = std::atoi(argv[++i]);
+        else if (arg == "--terrain" && hasValue && (std::string(argv[i + 1]) == "sprites" || std::string(argv[i + 1]) == "shader")) {
+            tilemapShader = std::string(argv[++i]) == "shader";
+        }
+        else {
+            std::cout << "Usage: game [--infinite] [--render-distance CHUNKS] [--terrain sprites|shader] [--record PATH | --replay PATH [--fast]]" << std::endl;
+            return 1;
+        }
+    }
 
-int main() {
     // 2560x1440 fullscreen
     sf::RenderWindow window(sf::VideoMode::getDesktopMode(), "Biome Explorer - Crafting & Tools System", sf::State::Fullscreen);
     window.setFramerateLimit(60);
 
-    sf::View camera({ 1280, 720 }, { 2560, 1440 });
+    const sf::Vector2f baseCameraSize{ 2560, 1440 };
+    sf::View camera({ 1280, 720 }, baseCameraSize);
+    float cameraZoom = 1.0f;
 
     Map gameMap;
     Player player;
     UI ui;
+    EntityRenderer entityRenderer;
+    LightRenderer lightRenderer;
+
+    // Use a prebuilt world from the baker when one is present
+    gameMap.openBakedWorld("world.bake");
+    gameMap.setInfinite(infinite);
+    gameMap.streamer.setRenderDistance(renderDistance);
+    gameMap.useTilemapShader = tilemapShader;
+
+    player.findSafeSpawnPosition(gameMap);
+
+    // A replay starts from the save its recording started from, in a scratch file of its own
+    InputReplay replay;
+    std::string savePath = "savegame.dat";
+    if (!replayPath.empty()) {
+        if (!replay.open(replayPath, gameMap)) {
+            return 1;
+        }
+        savePath = replay.getSavePath();
+        replay.prepareStartSave();
+    }
+
+    // Resume the last session if there is one; saving happens on a background thread
+    Simulation simulation(gameMap, player, savePath);
+    bool resumed = loadGame(savePath, gameMap, player, simulation.exploredChunks);
 
-    sf::Clock clock;
+    InputRecorder recorder;
+    std::vector<float> frameMilliseconds;
+    if (!replayPath.empty()) {
+        simulation.replay = &replay;
+        simulation.tickRate = replay.getTickRate();
+        simulation.unthrottled = fastReplay;
+        gameMap.streamer.setRenderDistance(replay.getRenderDistance());
+        if (fastReplay) {
+            window.setFramerateLimit(0);
+            window.setVerticalSyncEnabled(false);
+        }
+    }
+    else if (!recordPath.empty() && recorder.open(recordPath, gameMap, simulation.tickRate, resumed ? savePath : "")) {
+        simulation.recorder = &recorder;
+    }
+
+    // This thread renders and handles window events; the game runs on the simulation thread
+    auto sendCommand = [&simulation](InputCommandType type, int a = 0, int b = 0) {
+        InputCommand command;
+        command.type = type;
+        command.a = a;
+        command.b = b;
+        simulation.input.push(command);
+    };
+    auto sendView = [&]() {
+        InputCommand command;
+        command.type = InputCommandType::SET_VIEW;
+        command.viewSize = camera.getSize();
+        ui.getExploredMapExtent(command.a, command.b);
+        simulation.input.push(command);
+    };
+    sendView();
+    simulation.start();
 
     std::cout << "Biome Explorer with Crafting System loaded!" << std::endl;
     std::cout << "New Features:" << std::endl;
@@ -25,19 +120,43 @@ int main() {
     std::cout << "- Tool slots for pickaxe and axe" << std::endl;
     std::cout << "- Stone harvesting with pickaxe" << std::endl;
     std::cout << "- Faster tree harvesting with axe" << std::endl;
+    std::cout << "- Day and night, torches crafted from wood" << std::endl;
     std::cout << "Controls:" << std::endl;
     std::cout << "- WASD to move" << std::endl;
     std::cout << "- SHIFT to sprint (3x speed)" << std::endl;
     std::cout << "- Right-click trees to harvest (within 3 tiles)" << std::endl;
     std::cout << "- Right-click stone to harvest (requires pickaxe)" << std::endl;
+    std::cout << "- F to harvest the nearest tree or stone in range" << std::endl;
+    std::cout << "- Left-click to walk there" << std::endl;
+    std::cout << "- T to place a torch on the grass or dirt under the mouse (within 3 tiles)" << std::endl;
+    std::cout << "- Mouse wheel to zoom (up to 16x out)" << std::endl;
+    std::cout << "- G to switch terrain between the tilemap shader and sprites" << std::endl;
     std::cout << "- M for map" << std::endl;
     std::cout << "- E for inventory" << std::endl;
     std::cout << "- C for crafting" << std::endl;
+    std::cout << "- F5 to save, F9 to load (autosaves every " << static_cast<int>(AUTOSAVE_INTERVAL) << "s)" << std::endl;
     std::cout << "- Left-click in inventory to move items" << std::endl;
     std::cout << "- ESC to quit" << std::endl;
 
+    auto lastFrame = std::chrono::steady_clock::now();
     while (window.isOpen()) {
-        float dt = clock.restart().asSeconds();
+        if (simulation.replay) {
+            auto now = std::chrono::steady_clock::now();
+            frameMilliseconds.push_back(std::chrono::duration<float, std::milli>(now - lastFrame).count());
+            lastFrame = now;
+            if (simulation.replayFinished) {
+                window.close();
+            }
+        }
+
+        // Newest frame from the simulation; keeps the previous one if no tick finished since
+        simulation.frames.acquire();
+        const FrameSnapshot& frame = simulation.frames.readSlot();
+
+        // The camera follows the player in the frame's render origin, before any mouse
+        // position is mapped through it
+        sf::Vector2f playerLocal = frame.origin.toLocal(frame.player.position);
+        camera.setCenter(playerLocal);
 
         while (std::optional<sf::Event> event = window.pollEvent()) {
             if (event->is<sf::Event::Closed>()) {
@@ -49,6 +168,7 @@ int main() {
                 if (key == sf::Keyboard::Key::M) {
                     if (!ui.isInventoryOpen() && !ui.isCraftingOpen()) {
                         ui.toggleMap();
+                        sendView();
                     }
                 }
                 else if (key == sf::Keyboard::Key::E) {
@@ -61,9 +181,31 @@ int main() {
                         ui.toggleCrafting();
                     }
                 }
+                else if (key == sf::Keyboard::Key::F) {
+                    if (!ui.isMapOpen() && !ui.isInventoryOpen() && !ui.isCraftingOpen()) {
+                        sendCommand(InputCommandType::HARVEST_NEAREST);
+                    }
+                }
+                else if (key == sf::Keyboard::Key::T) {
+                    if (!ui.isMapOpen() && !ui.isInventoryOpen() && !ui.isCraftingOpen()) {
+                        sf::Vector2i tile = frame.origin.localToTile(window.mapPixelToCoords(sf::Mouse::getPosition(window), camera));
+                        sendCommand(InputCommandType::PLACE_TORCH, tile.x, tile.y);
+                    }
+                }
+                else if (key == sf::Keyboard::Key::G) {
+                    gameMap.useTilemapShader = !gameMap.useTilemapShader;
+                    std::cout << "Terrain: " << (gameMap.useTilemapShader ? "tilemap shader" : "sprites") << std::endl;
+                }
+                else if (key == sf::Keyboard::Key::F5) {
+                    sendCommand(InputCommandType::SAVE);
+                }
+                else if (key == sf::Keyboard::Key::F9) {
+                    sendCommand(InputCommandType::LOAD);
+                }
                 else if (key == sf::Keyboard::Key::Escape) {
                     if (ui.isMapOpen()) {
                         ui.closeMap();
+                        sendView();
                     }
                     else if (ui.isInventoryOpen()) {
                         ui.closeInventory();
@@ -82,28 +224,29 @@ int main() {
 
                 if (button == sf::Mouse::Button::Left && (ui.isInventoryOpen() || ui.isCraftingOpen())) {
                     // Handle inventory/crafting clicks - mouse pressed
-                    ui.handleInventoryClick({ static_cast<float>(mousePos.x), static_cast<float>(mousePos.y) }, player, true);
+                    ui.handleInventoryClick({ static_cast<float>(mousePos.x), static_cast<float>(mousePos.y) }, frame.player, true, simulation.input);
                 }
                 else if (button == sf::Mouse::Button::Right && !ui.isMapOpen() && !ui.isInventoryOpen() && !ui.isCraftingOpen()) {
-                    // Get mouse position in world coordinates
-                    sf::Vector2f worldMousePos = window.mapPixelToCoords(mousePos, camera);
-
-                    // Convert to tile coordinates
-                    int tileX = static_cast<int>(worldMousePos.x / TILE_SIZE);
-                    int tileY = static_cast<int>(worldMousePos.y / TILE_SIZE);
-
-                    // Check if it's a harvestable tile and within range
-                    if (tileX >= 0 && tileX < WORLD_WIDTH && tileY >= 0 && tileY < WORLD_HEIGHT) {
-                        TileType tileType = gameMap.generateTileType(tileX, tileY);
-                        if (player.canHarvestTile(tileType) && player.isWithinHarvestRange(tileX, tileY)) {
-                            if (!player.getIsHarvesting()) {
-                                player.startHarvesting(tileX, tileY, {
-                                    static_cast<float>(tileX * TILE_SIZE + TILE_SIZE / 2),
-                                    static_cast<float>(tileY * TILE_SIZE + TILE_SIZE / 2)
-                                    }, tileType);
-                            }
-                        }
-                    }
+                    // The camera works relative to the frame's render origin; back to world tiles
+                    sf::Vector2i tile = frame.origin.localToTile(window.mapPixelToCoords(mousePos, camera));
+
+                    // The simulation checks whether it's harvestable and within range
+                    sendCommand(InputCommandType::HARVEST_TILE, tile.x, tile.y);
+                }
+                else if (button == sf::Mouse::Button::Left && !ui.isMapOpen()) {
+                    // Walk there along a path around obstacles
+                    sf::Vector2i tile = frame.origin.localToTile(window.mapPixelToCoords(mousePos, camera));
+                    sendCommand(InputCommandType::MOVE_TO, tile.x, tile.y);
+                }
+            }
+            if (event->is<sf::Event::MouseWheelScrolled>()) {
+                const auto* scrolled = event->getIf<sf::Event::MouseWheelScrolled>();
+                if (scrolled->wheel == sf::Mouse::Wheel::Vertical && !ui.isMapOpen() && !ui.isInventoryOpen() && !ui.isCraftingOpen()) {
+                    // Wheel up zooms in, wheel down zooms out
+                    cameraZoom *= (scrolled->delta > 0) ? 0.8f : 1.25f;
+                    cameraZoom = std::max(1.0f, std::min(cameraZoom, MAX_CAMERA_ZOOM));
+                    camera.setSize(baseCameraSize * cameraZoom);
+                    sendView();
                 }
             }
             if (event->is<sf::Event::MouseButtonReleased>()) {
@@ -112,64 +255,59 @@ int main() {
 
                 if (button == sf::Mouse::Button::Left && (ui.isInventoryOpen() || ui.isCraftingOpen())) {
                     // Handle inventory/crafting clicks - mouse released
-                    ui.handleInventoryClick({ static_cast<float>(mousePos.x), static_cast<float>(mousePos.y) }, player, false);
+                    ui.handleInventoryClick({ static_cast<float>(mousePos.x), static_cast<float>(mousePos.y) }, frame.player, false, simulation.input);
                 }
             }
         }
 
-        // Input (only if map, inventory, and crafting are not open)
+        // Movement keys are sampled every frame; the simulation applies the latest state
+        std::uint8_t movement = 0;
         if (!ui.isMapOpen() && !ui.isInventoryOpen() && !ui.isCraftingOpen()) {
-            bool left = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A);
-            bool right = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D);
-            bool up = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::W);
-            bool down = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S);
-            bool sprint = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LShift) ||
-                sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RShift);
-
-            // Stop harvesting if player tries to move
-            if ((left || right || up || down) && player.getIsHarvesting()) {
-                player.stopHarvesting();
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A)) movement |= INPUT_LEFT;
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D)) movement |= INPUT_RIGHT;
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::W)) movement |= INPUT_UP;
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S)) movement |= INPUT_DOWN;
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LShift) ||
+                sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RShift)) {
+                movement |= INPUT_SPRINT;
             }
-
-            player.setMovement(left, right, up, down);
-            player.setSprinting(sprint);
-
-            // Update
-            player.update(dt, gameMap);
-
-            // Chunk management (limited per frame)
-            gameMap.loadChunksAroundPlayer(player.getPosition());
-            gameMap.unloadDistantChunks(player.getPosition());
         }
         else {
             // Stop movement when UI is open
-            player.setMovement(false, false, false, false);
-            player.setSprinting(false);
+            movement = INPUT_MENU_OPEN;
         }
 
-        ui.update(player, gameMap.loadedChunks.size());
+        InputCommand movementCommand;
+        movementCommand.type = InputCommandType::MOVEMENT;
+        movementCommand.flags = movement;
+        simulation.input.push(movementCommand);
+
+        ui.update(frame.player, frame.loadedChunks);
+        ui.setRenderStats(cameraZoom, gameMap.lastDrawCalls, frame.stepMilliseconds, frame.entityCount, frame.flowFieldMilliseconds);
+        ui.setStreamingStats(frame.streamingStats, frame.cacheStats);
 
         // Camera
-        sf::Vector2f playerPos = player.getPosition();
-        camera.setCenter(playerPos);
         window.setView(camera);
 
         // Draw
         window.clear(sf::Color::Black);
-        gameMap.draw(window, camera);
-
-        // Draw player (either sprite or fallback rectangle)
-        if (player.useSimpleGraphics) {
-            window.draw(player.fallbackRect);
-        }
-        else {
-            window.draw(player.sprite);
-        }
-
-        ui.draw(window, player, gameMap);
+        gameMap.draw(window, camera, frame.origin, frame.visibleChunks);
+        entityRenderer.draw(window, frame.entities);
+        player.draw(window, playerLocal);
+        lightRenderer.draw(window, camera, frame.origin, frame.visibleChunks, frame.timeOfDay);
+        ui.draw(window, frame);
 
         window.display();
     }
 
+    // Stops the simulation and writes a final save; AutoSaver waits for it to reach disk
+    simulation.stop();
+
+    if (simulation.replay) {
+        printFrameTimes("Simulation step", replay.stepMilliseconds, 1000.0f / simulation.tickRate);
+        printFrameTimes("Render frame", frameMilliseconds, 1000.0f / 60.0f);
+        std::cout << "Replay " << (replay.matched() ? "matched the recording" : "diverged from the recording") << std::endl;
+        return replay.matched() ? 0 : 1;
+    }
     return 0;
 }
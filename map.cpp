@@ -7,10 +7,15 @@
 #include <random>
 #include <cmath>
 #include <algorithm>
+#include <iterator>
 
 #include <SFML/Graphics.hpp>
 
 #include "map.h"
+#include "jobsystem.h"
+#include "assets.h"
+#include "lighting.h"
+#include "autotile.h"
 
 // Remove all these constant redefinitions - they're already in constants.h
 // const int CHUNK_SIZE = 16;
@@ -21,19 +26,20 @@
 // const int CHUNKS_X = WORLD_WIDTH / CHUNK_SIZE;
 // const int CHUNKS_Y = WORLD_HEIGHT / CHUNK_SIZE;
 
-// Helper function to convert world coordinates to chunk coordinates
-ChunkCoord worldToChunk(int worldX, int worldY) {
-    return { worldX / CHUNK_SIZE, worldY / CHUNK_SIZE };
-}
+Map::Map(bool headless) {
+    workerGenerators.resize(getJobSystem().getWorkerCount());
+    if (headless) {
+        return;
+    }
 
-Map::Map() {
     // Try to load textures, fallback to simple rectangles
-    if (!grassTexture.loadFromFile("textures/grass.png") ||
-        !waterTexture.loadFromFile("textures/water.png") ||
-        !stoneTexture.loadFromFile("textures/stone.png") ||
-        !treeTexture.loadFromFile("textures/tree.png") ||
-        !woodTexture.loadFromFile("textures/wood.png") ||
-        !dirtTexture.loadFromFile("textures/dirt.png")) {
+    if (!loadTextures({
+        { &grassTexture, "textures/grass.png" },
+        { &waterTexture, "textures/water.png" },
+        { &stoneTexture, "textures/stone.png" },
+        { &treeTexture, "textures/tree.png" },
+        { &woodTexture, "textures/wood.png" },
+        { &dirtTexture, "textures/dirt.png" } })) {
 
         std::cout << "Using simple graphics for better performance..." << std::endl;
         useSimpleGraphics = true;
@@ -56,424 +62,810 @@ Map::Map() {
 
         dirtTile.setSize({ static_cast<float>(TILE_SIZE), static_cast<float>(TILE_SIZE) });
         dirtTile.setFillColor({ 139, 90, 43 });  // Brown color for dirt
+
+        torchTile.setSize({ static_cast<float>(TILE_SIZE), static_cast<float>(TILE_SIZE) });
+        torchTile.setFillColor({ 255, 140, 20 });  // Orange for torches
+    }
+    else {
+        // Torches are drawn over the grass texture rather than shipped as another file
+        sf::Image torchImage = grassTexture.copyToImage();
+        drawTorch(torchImage);
+        if (!torchTexture.loadFromImage(torchImage)) {
+            std::cout << "Failed to build torch texture" << std::endl;
+        }
+
+        // Indexed by TileType
+        const TileType spriteTypes[] = { TileType::GRASS, TileType::WATER, TileType::STONE, TileType::TREE, TileType::DIRT, TileType::TORCH };
+        for (TileType tileType : spriteTypes) {
+            sf::Texture& texture = getTileTexture(tileType);
+            sf::Sprite sprite(texture);
+            sf::Vector2u textureSize = texture.getSize();
+            if (textureSize.x > 0 && textureSize.y > 0) {
+                sprite.setScale({
+                    static_cast<float>(TILE_SIZE) / textureSize.x,
+                    static_cast<float>(TILE_SIZE) / textureSize.y
+                    });
+            }
+            tileSprites.push_back(sprite);
+        }
+    }
+
+    // Coarse biome layer starts fully transparent and is filled in as chunks come into view
+    coarseLayerImage.resize({ static_cast<unsigned>(COARSE_LAYER_CHUNKS), static_cast<unsigned>(COARSE_LAYER_CHUNKS) }, sf::Color::Transparent);
+    if (!coarseLayerTexture.loadFromImage(coarseLayerImage)) {
+        std::cout << "Could not create coarse biome layer texture" << std::endl;
     }
 }
 
-float Map::noise(int x, int y, int scale) {
-    auto key = std::make_pair(x / scale, y / scale);
-    auto it = noiseCache.find(key);
-    if (it != noiseCache.end()) {
-        return it->second;
+bool Map::openBakedWorld(const std::string& path) {
+    if (!bakedWorld.open(path)) {
+        return false;
     }
 
-    // Simple multi-octave noise simulation
-    float result = 0.0f;
-    float amplitude = 1.0f;
-    float frequency = 1.0f;
-    float maxValue = 0.0f;
+    const BakedWorldHeader& header = bakedWorld.getHeader();
+    if (header.worldWidth != static_cast<std::uint32_t>(WORLD_WIDTH) || header.worldHeight != static_cast<std::uint32_t>(WORLD_HEIGHT)) {
+        std::cout << "Baked world " << path << " is " << header.worldWidth << "x" << header.worldHeight
+            << ", expected " << WORLD_WIDTH << "x" << WORLD_HEIGHT << "; generating instead" << std::endl;
+        bakedWorld.close();
+        return false;
+    }
 
-    for (int i = 0; i < 3; i++) {
-        std::mt19937 rng((x / scale) * frequency * 1000 + (y / scale) * frequency + i * 10000);
-        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-        result += dist(rng) * amplitude;
-        maxValue += amplitude;
-        amplitude *= 0.5f;
-        frequency *= 2.0f;
+    // Anything still generated (biomes for the map, tiles outside the bake) must match the baked seed
+    generator.setSeed(header.seed);
+    for (WorldGenerator& workerGenerator : workerGenerators) {
+        workerGenerator.setSeed(header.seed);
     }
+    generatedTileCache.clear();
+    chunkCache.clear();
 
-    result /= maxValue;
-    noiseCache[key] = result;
-    return result;
+    std::cout << "Using baked world " << path << " (seed " << header.seed << ")" << std::endl;
+    return true;
 }
 
-float Map::getDistanceToRiver(int worldX, int worldY) {
-    // Create multiple river paths
-    float minDistance = 1000.0f;
-
-    // River 1: Diagonal flow
-    float riverX1 = worldX + worldY * 0.3f;
-    float riverY1 = worldY - worldX * 0.2f;
-    float riverNoise1 = noise(static_cast<int>(riverX1), static_cast<int>(riverY1), 50) * 30.0f;
-    float distToRiver1 = std::abs(std::sin(riverX1 * 0.01f) * 50.0f + riverNoise1);
+void Map::setInfinite(bool enabled) {
+    infinite = enabled;
+    interest.bounded = !enabled;
+}
 
-    // River 2: Horizontal meandering
-    float riverNoise2 = noise(worldX, worldY, 80) * 40.0f;
-    float distToRiver2 = std::abs((worldY % 300) - 150 + std::sin(worldX * 0.02f) * 30.0f + riverNoise2);
+bool Map::isInWorld(int worldX, int worldY) const {
+    if (infinite) {
+        return std::abs(worldX) < INFINITE_WORLD_LIMIT && std::abs(worldY) < INFINITE_WORLD_LIMIT;
+    }
+    return worldX >= 0 && worldX < WORLD_WIDTH && worldY >= 0 && worldY < WORLD_HEIGHT;
+}
 
-    // River 3: Vertical meandering
-    float riverNoise3 = noise(worldX, worldY, 90) * 35.0f;
-    float distToRiver3 = std::abs((worldX % 400) - 200 + std::sin(worldY * 0.015f) * 25.0f + riverNoise3);
+bool Map::isChunkInWorld(ChunkCoord chunkCoord) const {
+    if (infinite) {
+        const std::int64_t limit = INFINITE_WORLD_LIMIT / CHUNK_SIZE;
+        return std::llabs(chunkCoord.x) < limit && std::llabs(chunkCoord.y) < limit;
+    }
+    return chunkCoord.x >= 0 && chunkCoord.x < CHUNKS_X && chunkCoord.y >= 0 && chunkCoord.y < CHUNKS_Y;
+}
 
-    minDistance = std::min({ distToRiver1, distToRiver2, distToRiver3 });
-    return minDistance;
+BiomeType Map::determineBiome(int worldX, int worldY) const {
+    return const_cast<WorldGenerator&>(generator).determineBiome(worldX, worldY);
 }
 
-float Map::getMountainHeight(int worldX, int worldY) {
-    // Create multiple mountain ranges with different characteristics
-    float height = 0.0f;
+TileType Map::generateTileType(int worldX, int worldY) {
+    return generator.generateTileType(worldX, worldY);
+}
 
-    // Primary mountain range - large scale ridges
-    float ridge1 = std::abs(std::sin((worldX + worldY) * 0.003f)) * 0.8f;
-    float ridge1Noise = noise(worldX, worldY, 200) * 0.3f;
-    height = std::max(height, ridge1 + ridge1Noise);
+sf::RectangleShape& Map::getTileShape(TileType tileType) {
+    switch (tileType) {
+    case TileType::WATER: return waterTile;
+    case TileType::STONE: return stoneTile;
+    case TileType::TREE: return treeTile;
+    case TileType::DIRT: return dirtTile;
+    case TileType::TORCH: return torchTile;
+    default: return grassTile;
+    }
+}
 
-    // Secondary mountain range - perpendicular ridges
-    float ridge2 = std::abs(std::sin((worldX - worldY) * 0.004f)) * 0.7f;
-    float ridge2Noise = noise(worldX + 500, worldY + 500, 150) * 0.25f;
-    height = std::max(height, ridge2 + ridge2Noise);
+sf::Texture& Map::getTileTexture(TileType tileType) {
+    switch (tileType) {
+    case TileType::WATER: return waterTexture;
+    case TileType::STONE: return stoneTexture;
+    case TileType::TREE: return treeTexture;
+    case TileType::DIRT: return dirtTexture;
+    case TileType::TORCH: return torchTexture;
+    default: return grassTexture;
+    }
+}
 
-    // Tertiary peaks - isolated mountains
-    float peaks = noise(worldX, worldY, 100) * noise(worldX + 1000, worldY + 1000, 120);
-    if (peaks > 0.6f) {
-        height = std::max(height, peaks);
+sf::Image Map::buildTileAtlas() {
+    // One TILEMAP_ATLAS_CELL square per tile type, in TileType order, from the same textures
+    // (or fallback colors) the sprites use
+    const TileType atlasTypes[] = { TileType::GRASS, TileType::WATER, TileType::STONE, TileType::TREE, TileType::DIRT, TileType::TORCH };
+    const unsigned cell = static_cast<unsigned>(TILEMAP_ATLAS_CELL);
+    sf::Image atlas({ cell * static_cast<unsigned>(std::size(atlasTypes)), cell }, sf::Color::Transparent);
+
+    for (TileType tileType : atlasTypes) {
+        unsigned cellX = static_cast<unsigned>(tileType) * cell;
+        sf::Image source;
+        sf::Vector2u sourceSize;
+        if (!useSimpleGraphics) {
+            source = getTileTexture(tileType).copyToImage();
+            sourceSize = source.getSize();
+        }
+        for (unsigned y = 0; y < cell; y++) {
+            for (unsigned x = 0; x < cell; x++) {
+                sf::Color color = (sourceSize.x > 0 && sourceSize.y > 0)
+                    ? source.getPixel({ x * sourceSize.x / cell, y * sourceSize.y / cell })
+                    : getTileShape(tileType).getFillColor();
+                atlas.setPixel({ cellX + x, y }, color);
+            }
+        }
     }
+    return atlas;
+}
+
+WorldGenerator& Map::getWorkerGenerator() {
+    return workerGenerators[JobSystem::currentWorkerIndex()];
+}
 
-    // Add fine detail noise
-    float detail = noise(worldX, worldY, 50) * 0.15f;
-    height += detail;
+void Map::generateChunkTiles(Chunk& chunk, WorldGenerator& chunkGenerator) const {
+    // A baked world already has the tiles; copy them straight out of the mapping
+    if (const TileType* baked = bakedWorld.getChunkTiles(chunk.coord.x, chunk.coord.y)) {
+        std::copy(baked, baked + CHUNK_SIZE * CHUNK_SIZE, &chunk.tileTypes[0][0]);
+    }
+    else {
+        // Tiles generated for queries while the chunk was unloaded come out the same, so the
+        // whole chunk is generated at once rather than looked up tile by tile
+        chunkGenerator.generateChunk(chunk.coord.x, chunk.coord.y, &chunk.tileTypes[0][0]);
+    }
 
-    return std::min(height, 1.0f);
+    // Reapply edits made before the chunk was last unloaded
+    if (const ChunkEdits* edits = worldEdits->find(chunk.coord)) {
+        for (const auto& edit : *edits) {
+            chunk.tileTypes[edit.first / CHUNK_SIZE][edit.first % CHUNK_SIZE] = edit.second;
+        }
+    }
 }
 
-bool Map::isInMountainRange(int worldX, int worldY) {
-    float mountainHeight = getMountainHeight(worldX, worldY);
-    return mountainHeight > 0.4f; // Threshold for mountain areas
+void Map::loadChunk(ChunkCoord chunkCoord) {
+    loadChunks({ chunkCoord });
 }
 
-TileType Map::generateMountainTileType(int worldX, int worldY, float elevation, float mountainHeight) {
-    std::mt19937 rng(worldX * 1000 + worldY);
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-    float random = dist(rng);
+void Map::loadChunks(const std::vector<ChunkCoord>& chunkCoords) {
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    std::vector<Chunk*> toGenerate;
 
-    // Higher mountain areas are more likely to be stone
-    float stoneThreshold = 0.3f + (mountainHeight - 0.4f) * 1.5f; // Increases with height
-    stoneThreshold = std::min(stoneThreshold, 0.9f);
+    for (ChunkCoord chunkCoord : chunkCoords) {
+        if (loadedChunks.find(chunkCoord) != loadedChunks.end()) {
+            continue;
+        }
 
-    // Very high peaks are almost always stone
-    if (mountainHeight > 0.8f) {
-        return (random < 0.95f) ? TileType::STONE : TileType::GRASS;
-    }
+        chunks.push_back(std::make_unique<Chunk>(chunkCoord));
 
-    // Medium height mountains have mixed stone and grass
-    if (random < stoneThreshold) {
-        return TileType::STONE;
+        // Rehydrate from the second-tier cache if this chunk was unloaded recently
+        if (!chunkCache.restore(chunkCoord, *chunks.back())) {
+            toGenerate.push_back(chunks.back().get());
+        }
     }
 
-    // Lower mountain areas can have some trees
-    if (mountainHeight < 0.6f && random < 0.1f) {
-        return TileType::TREE;
-    }
+    // Generation only reads shared map state (bake, tile cache, edits), so chunks can be built side by side
+    getJobSystem().parallelFor(0, static_cast<int>(toGenerate.size()), 1, [this, &toGenerate](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            generateChunkTiles(*toGenerate[i], getWorkerGenerator());
+        }
+    });
 
-    return TileType::GRASS;
-}
+    for (auto& chunk : chunks) {
+        // Settle the time the chunk spent unloaded before anything is derived from its tiles
+        if (!worldTicker.hasState(chunk->coord)) {
+            scheduleFelledTrees(*chunk);
+        }
+        tickChanges.clear();
+        worldTicker.catchUp(*this, *chunk, worldTick, tickChanges);
+        for (const TileChange& change : tickChanges) {
+            int tileX = floorMod(change.worldX, CHUNK_SIZE);
+            int tileY = floorMod(change.worldY, CHUNK_SIZE);
+            if (chunk->tileTypes[tileY][tileX] == change.expected) {
+                chunk->tileTypes[tileY][tileX] = change.replacement;
+                recordEdit(chunk->coord, tileY * CHUNK_SIZE + tileX, change.replacement);
+            }
+        }
 
-BiomeType Map::determineBiome(int worldX, int worldY) const {
-    Map* mutableThis = const_cast<Map*>(this);
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                // Cache collision data
+                chunk->solidTiles[y][x] = isSolidType(chunk->tileTypes[y][x]);
+            }
+        }
 
-    float elevation = mutableThis->noise(worldX, worldY, 150);
-    float moisture = mutableThis->noise(worldX + 1000, worldY + 1000, 120);
-    float temperature = mutableThis->noise(worldX + 2000, worldY + 2000, 180);
-    float distanceToRiver = mutableThis->getDistanceToRiver(worldX, worldY);
+        chunk->rebuildResourceIndex();
+        computeChunkAutotiles(loadedChunks, *chunk);
+        chunk->rebuildMesh();
 
-    // River check first
-    if (distanceToRiver < 8.0f) {
-        return BiomeType::RIVER;
-    }
+        // Light depends on the neighbors, so the new chunk and everything its torches reach are relit
+        for (int offsetY = -LIGHT_REACH_CHUNKS; offsetY <= LIGHT_REACH_CHUNKS; offsetY++) {
+            for (int offsetX = -LIGHT_REACH_CHUNKS; offsetX <= LIGHT_REACH_CHUNKS; offsetX++) {
+                dirtyLight.insert({ chunk->coord.x + offsetX, chunk->coord.y + offsetY });
+            }
+        }
 
-    // Lake generation in low elevation areas
-    if (elevation < 0.25f && moisture > 0.4f) {
-        return BiomeType::LAKE;
+        // Water levels aren't kept while unloaded, so dirt may need filling again
+        if (std::find(&chunk->tileTypes[0][0], &chunk->tileTypes[0][0] + CHUNK_SIZE * CHUNK_SIZE, TileType::DIRT) !=
+            &chunk->tileTypes[0][0] + CHUNK_SIZE * CHUNK_SIZE) {
+            water.wake(chunk->coord);
+        }
+
+        chunk->isLoaded = true;
+        ChunkCoord chunkCoord = chunk->coord;
+        loadedChunks[chunkCoord] = std::move(chunk);
+        interest.onChunkLoaded(chunkCoord);
+
+        // Neighbors' edge tiles took the new chunk's side as matching while it was unloaded
+        int startX = static_cast<int>(chunkCoord.x * CHUNK_SIZE);
+        int startY = static_cast<int>(chunkCoord.y * CHUNK_SIZE);
+        retiledChunks.clear();
+        retileArea(loadedChunks, startX - 1, startY - 1, CHUNK_SIZE + 2, 1, retiledChunks);
+        retileArea(loadedChunks, startX - 1, startY + CHUNK_SIZE, CHUNK_SIZE + 2, 1, retiledChunks);
+        retileArea(loadedChunks, startX - 1, startY, 1, CHUNK_SIZE, retiledChunks);
+        retileArea(loadedChunks, startX + CHUNK_SIZE, startY, 1, CHUNK_SIZE, retiledChunks);
+        for (ChunkCoord retiled : retiledChunks) {
+            loadedChunks[retiled]->rebuildMesh();
+        }
+
+        // New borders open up entrances into the neighbors
+        pathFinder.invalidateAround(chunkCoord);
+        flowField.onChunkChanged(chunkCoord);
     }
+}
 
-    // Mountain generation using new mountain height system
-    if (mutableThis->isInMountainRange(worldX, worldY)) {
-        return BiomeType::MOUNTAIN;
+void Map::unloadChunk(ChunkCoord chunkCoord) {
+    auto chunkIt = loadedChunks.find(chunkCoord);
+    if (chunkIt == loadedChunks.end()) {
+        return;
     }
 
-    // Forest generation - depends on moisture and temperature
-    if (moisture > 0.55f && temperature > 0.3f && temperature < 0.8f) {
-        return BiomeType::FOREST;
+    worldTicker.onChunkUnloaded(*chunkIt->second, worldTick);
+    pathFinder.onChunkUnloaded(chunkCoord);
+    flowField.onChunkChanged(chunkCoord);
+    chunkCache.store(*chunkIt->second);
+    loadedChunks.erase(chunkIt);
+    interest.onChunkUnloaded(chunkCoord);
+}
+
+int Map::unloadUnobservedChunks() {
+    // Copied out first, since unloading changes the set
+    std::vector<ChunkCoord> toUnload(interest.getPendingUnloads().begin(), interest.getPendingUnloads().end());
+    for (ChunkCoord chunkCoord : toUnload) {
+        unloadChunk(chunkCoord);
     }
+    return static_cast<int>(toUnload.size());
+}
 
-    // Default to grassland
-    return BiomeType::GRASSLAND;
+void Map::unloadDistantChunks(WorldVector playerPos, sf::Vector2f velocity) {
+    streamer.unloadBehind(*this, playerPos, velocity);
 }
 
-TileType Map::generateTileType(int worldX, int worldY) {
-    BiomeType biome = determineBiome(worldX, worldY);
-    float elevation = noise(worldX, worldY, 150);
-    float moisture = noise(worldX + 1000, worldY + 1000, 120);
+void Map::loadChunksAroundPlayer(WorldVector playerPos, sf::Vector2f velocity) {
+    // Load a small budget of chunks per frame to avoid stuttering, nearest to the direction of travel first
+    streamer.loadAround(*this, playerPos, velocity);
+}
 
-    std::mt19937 rng(worldX * 1000 + worldY);
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-    float random = dist(rng);
+void Map::tickWorld(long long tick, const std::vector<WorldRect>& keepClear) {
+    worldTick = tick;
 
-    switch (biome) {
-    case BiomeType::LAKE:
-    case BiomeType::RIVER:
-        return TileType::WATER;
+    tickChanges.clear();
+    worldTicker.advance(*this, tick, keepClear, tickChanges);
+    for (const TileChange& change : tickChanges) {
+        replaceTile(change.worldX, change.worldY, change.expected, change.replacement);
+    }
+}
 
-    case BiomeType::MOUNTAIN:
-    {
-        float mountainHeight = getMountainHeight(worldX, worldY);
-        return generateMountainTileType(worldX, worldY, elevation, mountainHeight);
+void Map::stepWater() {
+    water.step(loadedChunks, waterChangedChunks, floodedTiles);
+    for (ChunkCoord chunkCoord : waterChangedChunks) {
+        loadedChunks[chunkCoord]->rebuildMesh();
     }
+    for (sf::Vector2i tile : floodedTiles) {
+        replaceTile(tile.x, tile.y, TileType::DIRT, TileType::WATER);
+    }
+}
 
-    case BiomeType::FOREST:
-        // Forests have varying tree density
-        if (random < 0.75f) {
-            return TileType::TREE;
-        }
-        else {
-            return TileType::GRASS;
+void Map::updateLighting() {
+    for (ChunkCoord chunkCoord : dirtyLight) {
+        auto chunkIt = loadedChunks.find(chunkCoord);
+        if (chunkIt != loadedChunks.end()) {
+            computeChunkLight(loadedChunks, *chunkIt->second);
+            chunkIt->second->rebuildMesh();
         }
+    }
+    dirtyLight.clear();
+}
 
-    default: // GRASSLAND
-        // Grasslands have sparse trees
-        if (random < 0.05f) {
-            return TileType::TREE;
-        }
-        else {
-            return TileType::GRASS;
+void Map::scheduleFelledTrees(const Chunk& chunk) {
+    // Trees felled before this session (in a loaded save) have no regrowth scheduled yet:
+    // they are the grass edits over generated trees
+    const ChunkEdits* edits = worldEdits->find(chunk.coord);
+    if (!edits) {
+        return;
+    }
+
+    for (const auto& edit : *edits) {
+        sf::Vector2i world = chunkTileToWorld(chunk.coord, edit.first % CHUNK_SIZE, edit.first / CHUNK_SIZE);
+        if (edit.second == TileType::GRASS && getGeneratedTile(world.x, world.y) == TileType::TREE) {
+            worldTicker.scheduleRegrowth(chunk.coord, edit.first, worldTick);
         }
     }
 }
 
-void Map::loadChunk(ChunkCoord chunkCoord) {
-    if (loadedChunks.find(chunkCoord) != loadedChunks.end()) {
-        return;
+TileType Map::getGeneratedTile(int worldX, int worldY) const {
+    ChunkCoord chunkCoord = chunkOfTile(worldX, worldY);
+    if (const TileType* baked = bakedWorld.getChunkTiles(chunkCoord.x, chunkCoord.y)) {
+        return baked[localTileIndex(worldX, worldY)];
+    }
+
+    auto key = std::make_pair(worldX, worldY);
+    auto it = generatedTileCache.find(key);
+    if (it != generatedTileCache.end()) {
+        return it->second;
     }
 
-    auto chunk = std::make_unique<Chunk>(chunkCoord);
+    Map* mutableThis = const_cast<Map*>(this);
+    if (mutableThis->generatedTileCache.size() >= GENERATED_TILE_CACHE_LIMIT) {
+        mutableThis->generatedTileCache.clear();
+    }
 
-    for (int y = 0; y < CHUNK_SIZE; y++) {
-        for (int x = 0; x < CHUNK_SIZE; x++) {
-            int worldX = chunkCoord.x * CHUNK_SIZE + x;
-            int worldY = chunkCoord.y * CHUNK_SIZE + y;
-
-            TileType tileType = generateTileType(worldX, worldY);
-
-            if (!useSimpleGraphics) {
-                sf::Texture* texture = nullptr;
-                switch (tileType) {
-                case TileType::WATER: texture = &waterTexture; break;
-                case TileType::STONE: texture = &stoneTexture; break;
-                case TileType::TREE: texture = &treeTexture; break;
-                default: texture = &grassTexture; break;
-                }
+    TileType tileType = mutableThis->generateTileType(worldX, worldY);
+    mutableThis->generatedTileCache[key] = tileType;
+    return tileType;
+}
 
-                chunk->tiles[y][x] = Tile(tileType, *texture);
-                chunk->tiles[y][x]->sprite.setTexture(*texture);
-                chunk->tiles[y][x]->sprite.setPosition({
-                    static_cast<float>(worldX * TILE_SIZE),
-                    static_cast<float>(worldY * TILE_SIZE)
-                    });
+TileType Map::getTile(int worldX, int worldY) const {
+    // Outside the world reads as water so callers treat it as impassable
+    if (!isInWorld(worldX, worldY)) {
+        return TileType::WATER;
+    }
 
-                sf::Vector2u textureSize = texture->getSize();
-                if (textureSize.x > 0 && textureSize.y > 0) {
-                    chunk->tiles[y][x]->sprite.setScale({
-                        static_cast<float>(TILE_SIZE) / textureSize.x,
-                        static_cast<float>(TILE_SIZE) / textureSize.y
-                        });
-                }
-            }
+    ChunkCoord chunkCoord = chunkOfTile(worldX, worldY);
+    int tileX = floorMod(worldX, CHUNK_SIZE);
+    int tileY = floorMod(worldY, CHUNK_SIZE);
 
-            // Cache collision data
-            chunk->solidTiles[y][x] = (tileType == TileType::WATER || tileType == TileType::TREE);
+    auto chunkIt = loadedChunks.find(chunkCoord);
+    if (chunkIt != loadedChunks.end()) {
+        return chunkIt->second->tileTypes[tileY][tileX];
+    }
+
+    if (const ChunkEdits* edits = worldEdits->find(chunkCoord)) {
+        auto editIt = edits->find(tileY * CHUNK_SIZE + tileX);
+        if (editIt != edits->end()) {
+            return editIt->second;
         }
     }
 
-    chunk->isLoaded = true;
-    loadedChunks[chunkCoord] = std::move(chunk);
+    return getGeneratedTile(worldX, worldY);
 }
 
-void Map::unloadDistantChunks(sf::Vector2f playerPos) {
-    ChunkCoord playerChunk = {
-        static_cast<int>(playerPos.x / (CHUNK_SIZE * TILE_SIZE)),
-        static_cast<int>(playerPos.y / (CHUNK_SIZE * TILE_SIZE))
-    };
+void Map::getTilesInRect(int startX, int startY, int width, int height, std::vector<TileType>& out) const {
+    // Row-major result; rows that fall inside a loaded chunk are copied as contiguous spans
+    out.resize(static_cast<size_t>(std::max(0, width)) * std::max(0, height));
 
-    auto it = loadedChunks.begin();
-    while (it != loadedChunks.end()) {
-        ChunkCoord chunkCoord = it->first;
-        int distanceX = std::abs(chunkCoord.x - playerChunk.x);
-        int distanceY = std::abs(chunkCoord.y - playerChunk.y);
+    for (int y = 0; y < height; y++) {
+        int worldY = startY + y;
+        TileType* row = out.data() + static_cast<size_t>(y) * width;
 
-        if (distanceX > RENDER_DISTANCE + 1 || distanceY > RENDER_DISTANCE + 1) {
-            it = loadedChunks.erase(it);
-        }
-        else {
-            ++it;
+        int x = 0;
+        while (x < width) {
+            int worldX = startX + x;
+            if (!isInWorld(worldX, worldY)) {
+                row[x++] = getTile(worldX, worldY);
+                continue;
+            }
+
+            int tileX = floorMod(worldX, CHUNK_SIZE);
+            int spanLength = std::min(CHUNK_SIZE - tileX, width - x);
+
+            auto chunkIt = loadedChunks.find(chunkOfTile(worldX, worldY));
+            if (chunkIt != loadedChunks.end()) {
+                const TileType* source = &chunkIt->second->tileTypes[floorMod(worldY, CHUNK_SIZE)][tileX];
+                std::copy(source, source + spanLength, row + x);
+            }
+            else {
+                for (int i = 0; i < spanLength; i++) {
+                    row[x + i] = getTile(worldX + i, worldY);
+                }
+            }
+            x += spanLength;
         }
     }
 }
 
-void Map::loadChunksAroundPlayer(sf::Vector2f playerPos) {
-    ChunkCoord playerChunk = {
-        static_cast<int>(playerPos.x / (CHUNK_SIZE * TILE_SIZE)),
-        static_cast<int>(playerPos.y / (CHUNK_SIZE * TILE_SIZE))
+int Map::findNearestResources(TileType type, int worldX, int worldY, int radius, int maxResults, std::vector<ResourceHit>& out) const {
+    out.clear();
+    if (maxResults <= 0 || radius < 0) {
+        return 0;
+    }
+
+    auto closer = [](const ResourceHit& a, const ResourceHit& b) {
+        return a.distanceSquared < b.distanceSquared;
     };
 
-    // Load only 1 chunk per frame to avoid stuttering
-    for (int dx = -RENDER_DISTANCE; dx <= RENDER_DISTANCE; dx++) {
-        for (int dy = -RENDER_DISTANCE; dy <= RENDER_DISTANCE; dy++) {
-            int x = playerChunk.x + dx;
-            int y = playerChunk.y + dy;
-
-            if (x >= 0 && x < CHUNKS_X && y >= 0 && y < CHUNKS_Y) {
-                ChunkCoord coord = { x, y };
-                if (loadedChunks.find(coord) == loadedChunks.end()) {
-                    loadChunk(coord);
-                    return; // Load only one chunk per frame
+    ChunkCoord centerChunk = chunkOfTile(worldX, worldY);
+    int radiusSquared = radius * radius;
+    int maxRing = radius / CHUNK_SIZE + 1;
+
+    // Walk chunks in expanding square rings; out is kept as a max-heap of the best hits so far
+    for (int ring = 0; ring <= maxRing; ring++) {
+        for (int dy = -ring; dy <= ring; dy++) {
+            bool edgeRow = (dy == -ring || dy == ring);
+            for (int dx = -ring; dx <= ring; dx += (edgeRow ? 1 : 2 * ring)) {
+                auto chunkIt = loadedChunks.find({ centerChunk.x + dx, centerChunk.y + dy });
+                if (chunkIt != loadedChunks.end()) {
+                    const Chunk& chunk = *chunkIt->second;
+                    const std::vector<std::uint16_t>* list = chunk.getResourceList(type);
+                    if (list) {
+                        int baseX = static_cast<int>(chunk.coord.x * CHUNK_SIZE);
+                        int baseY = static_cast<int>(chunk.coord.y * CHUNK_SIZE);
+                        for (std::uint16_t index : *list) {
+                            int tileX = baseX + index % CHUNK_SIZE;
+                            int tileY = baseY + index / CHUNK_SIZE;
+                            int distX = tileX - worldX;
+                            int distY = tileY - worldY;
+                            int distanceSquared = distX * distX + distY * distY;
+                            if (distanceSquared > radiusSquared) {
+                                continue;
+                            }
+
+                            if (static_cast<int>(out.size()) < maxResults) {
+                                out.push_back({ tileX, tileY, distanceSquared });
+                                std::push_heap(out.begin(), out.end(), closer);
+                            }
+                            else if (distanceSquared < out.front().distanceSquared) {
+                                std::pop_heap(out.begin(), out.end(), closer);
+                                out.back() = { tileX, tileY, distanceSquared };
+                                std::push_heap(out.begin(), out.end(), closer);
+                            }
+                        }
+                    }
+                }
+
+                if (ring == 0) {
+                    break;
                 }
             }
         }
+
+        // Every tile in the next ring is at least ring * CHUNK_SIZE tiles away
+        int nextRingDistance = ring * CHUNK_SIZE;
+        if (static_cast<int>(out.size()) == maxResults &&
+            out.front().distanceSquared <= nextRingDistance * nextRingDistance) {
+            break;
+        }
     }
+
+    std::sort_heap(out.begin(), out.end(), closer);
+    return static_cast<int>(out.size());
 }
 
-bool Map::isTileSolid(int worldX, int worldY) const {
-    if (worldX < 0 || worldX >= WORLD_WIDTH || worldY < 0 || worldY >= WORLD_HEIGHT) {
-        return true;
+sf::Color Map::getBiomeColor(BiomeType biome) {
+    switch (biome) {
+    case BiomeType::GRASSLAND: return sf::Color{ 34, 139, 34 };
+    case BiomeType::FOREST: return sf::Color{ 0, 100, 0 };
+    case BiomeType::MOUNTAIN: return sf::Color{ 128, 128, 128 };
+    case BiomeType::LAKE: return sf::Color{ 30, 144, 255 };
+    case BiomeType::RIVER: return sf::Color{ 30, 144, 255 };
+    default: return sf::Color::Black;
     }
+}
 
-    ChunkCoord chunkCoord = {
-        worldX / CHUNK_SIZE,
-        worldY / CHUNK_SIZE
-    };
+bool Map::isSolidType(TileType tileType) {
+    return tileType == TileType::WATER || tileType == TileType::TREE;
+}
 
+const Chunk* Map::findChunk(ChunkCoord chunkCoord) const {
     auto chunkIt = loadedChunks.find(chunkCoord);
+    return (chunkIt != loadedChunks.end()) ? chunkIt->second.get() : nullptr;
+}
+
+bool Map::isTileSolid(int worldX, int worldY) const {
+    if (!isInWorld(worldX, worldY)) {
+        return true;
+    }
+
+    auto chunkIt = loadedChunks.find(chunkOfTile(worldX, worldY));
     if (chunkIt == loadedChunks.end()) {
-        return false;
+        return isSolidType(getTile(worldX, worldY));
     }
 
-    int tileX = worldX % CHUNK_SIZE;
-    int tileY = worldY % CHUNK_SIZE;
+    int tileX = floorMod(worldX, CHUNK_SIZE);
+    int tileY = floorMod(worldY, CHUNK_SIZE);
 
     return chunkIt->second->solidTiles[tileY][tileX];
 }
 
-bool Map::destroyTree(int worldX, int worldY) {
-    if (worldX < 0 || worldX >= WORLD_WIDTH || worldY < 0 || worldY >= WORLD_HEIGHT) {
+bool Map::replaceTile(int worldX, int worldY, TileType expected, TileType replacement) {
+    if (!isInWorld(worldX, worldY)) {
         return false;
     }
 
-    ChunkCoord chunkCoord = {
-        worldX / CHUNK_SIZE,
-        worldY / CHUNK_SIZE
-    };
+    ChunkCoord chunkCoord = chunkOfTile(worldX, worldY);
 
     auto chunkIt = loadedChunks.find(chunkCoord);
     if (chunkIt == loadedChunks.end()) {
         return false;
     }
 
-    int tileX = worldX % CHUNK_SIZE;
-    int tileY = worldY % CHUNK_SIZE;
+    int tileX = floorMod(worldX, CHUNK_SIZE);
+    int tileY = floorMod(worldY, CHUNK_SIZE);
+    Chunk& chunk = *chunkIt->second;
 
-    // Check if it's actually a tree
-    if (chunkIt->second->tiles[tileY][tileX].has_value() &&
-        chunkIt->second->tiles[tileY][tileX]->type == TileType::TREE) {
+    if (chunk.tileTypes[tileY][tileX] != expected) {
+        return false;
+    }
 
-        // Replace tree with grass
-        if (!useSimpleGraphics) {
-            chunkIt->second->tiles[tileY][tileX] = Tile(TileType::GRASS, grassTexture);
-            chunkIt->second->tiles[tileY][tileX]->sprite.setTexture(grassTexture);
-            chunkIt->second->tiles[tileY][tileX]->sprite.setPosition({
-                static_cast<float>(worldX * TILE_SIZE),
-                static_cast<float>(worldY * TILE_SIZE)
-                });
-
-            sf::Vector2u textureSize = grassTexture.getSize();
-            if (textureSize.x > 0 && textureSize.y > 0) {
-                chunkIt->second->tiles[tileY][tileX]->sprite.setScale({
-                    static_cast<float>(TILE_SIZE) / textureSize.x,
-                    static_cast<float>(TILE_SIZE) / textureSize.y
-                    });
+    chunk.tileTypes[tileY][tileX] = replacement;
+    chunk.solidTiles[tileY][tileX] = isSolidType(replacement);
+    chunk.updateResourceIndex(tileX, tileY, expected, replacement);
+
+    // Only the tile and its eight neighbors can change edge shape, possibly in the next chunks over
+    retiledChunks.clear();
+    retileArea(loadedChunks, worldX - 1, worldY - 1, 3, 3, retiledChunks);
+    chunk.rebuildMesh();
+    for (ChunkCoord retiled : retiledChunks) {
+        if (!(retiled == chunkCoord)) {
+            loadedChunks[retiled]->rebuildMesh();
+        }
+    }
+
+    // Remember the edit so it survives unloading
+    recordEdit(chunkCoord, tileY * CHUNK_SIZE + tileX, replacement);
+    if (recordTileDeltas) {
+        tileDeltas.push_back({ worldX, worldY, expected, replacement });
+    }
+
+    // Mining next to water (or flooding) may start a flow
+    water.wake(chunkCoord);
+
+    if (isSolidType(expected) != isSolidType(replacement)) {
+        pathFinder.invalidateAround(chunkCoord);
+        flowField.onTileChanged(*this, worldX, worldY);
+    }
+
+    // Torches, and the trees and stone that block their light, change the light around them
+    auto affectsLight = [](TileType tileType) {
+        return tileType == TileType::TORCH || tileType == TileType::TREE || tileType == TileType::STONE;
+    };
+    if (affectsLight(expected) || affectsLight(replacement)) {
+        for (int offsetY = -LIGHT_REACH_CHUNKS; offsetY <= LIGHT_REACH_CHUNKS; offsetY++) {
+            for (int offsetX = -LIGHT_REACH_CHUNKS; offsetX <= LIGHT_REACH_CHUNKS; offsetX++) {
+                dirtyLight.insert({ chunkCoord.x + offsetX, chunkCoord.y + offsetY });
             }
         }
+    }
+    return true;
+}
 
-        // Update collision data
-        chunkIt->second->solidTiles[tileY][tileX] = false;
+void Map::recordEdit(ChunkCoord chunkCoord, int tileIndex, TileType tileType) {
+    // Copy-on-write: clone whatever a pending save snapshot still shares
+    if (worldEdits.use_count() > 1) {
+        worldEdits = std::make_shared<WorldEdits>(*worldEdits);
+    }
 
-        return true;
+    std::shared_ptr<ChunkEdits>& edits = worldEdits->chunks[chunkCoord];
+    if (!edits) {
+        edits = std::make_shared<ChunkEdits>();
+    }
+    else if (edits.use_count() > 1) {
+        edits = std::make_shared<ChunkEdits>(*edits);
     }
 
-    return false;
+    (*edits)[tileIndex] = tileType;
 }
 
-bool Map::destroyStone(int worldX, int worldY) {
-    if (worldX < 0 || worldX >= WORLD_WIDTH || worldY < 0 || worldY >= WORLD_HEIGHT) {
+void Map::restoreEdits(std::shared_ptr<WorldEdits> edits) {
+    worldEdits = edits ? std::move(edits) : std::make_shared<WorldEdits>();
+
+    // Loaded and cached chunks reflect the old edits; reload them through the streamer
+    unloadAllChunks();
+    chunkCache.clear();
+    worldTicker.clear();
+    water.clear();
+    dirtyLight.clear();
+}
+
+void Map::unloadAllChunks() {
+    for (const auto& entry : loadedChunks) {
+        worldTicker.onChunkUnloaded(*entry.second, worldTick);
+        interest.onChunkUnloaded(entry.first);
+    }
+    loadedChunks.clear();
+    pathFinder.clear();
+    flowField.clear();
+}
+
+bool Map::destroyTree(int worldX, int worldY) {
+    // Replace tree with grass; it grows back after a while
+    if (!replaceTile(worldX, worldY, TileType::TREE, TileType::GRASS)) {
         return false;
     }
+    worldTicker.scheduleRegrowth(chunkOfTile(worldX, worldY), localTileIndex(worldX, worldY), worldTick);
+    return true;
+}
 
-    ChunkCoord chunkCoord = {
-        worldX / CHUNK_SIZE,
-        worldY / CHUNK_SIZE
-    };
+bool Map::destroyStone(int worldX, int worldY) {
+    // Replace stone with dirt (dirt is not solid)
+    return replaceTile(worldX, worldY, TileType::STONE, TileType::DIRT);
+}
 
-    auto chunkIt = loadedChunks.find(chunkCoord);
-    if (chunkIt == loadedChunks.end()) {
+bool Map::placeTorch(int worldX, int worldY) {
+    return replaceTile(worldX, worldY, TileType::GRASS, TileType::TORCH) ||
+        replaceTile(worldX, worldY, TileType::DIRT, TileType::TORCH);
+}
+
+bool Map::buildChunkImpostor(const std::shared_ptr<const ChunkMesh>& mesh, int level) {
+    int resolution = IMPOSTOR_TILE_RESOLUTIONS[level];
+    unsigned impostorSize = static_cast<unsigned>(CHUNK_SIZE * resolution);
+
+    auto impostor = std::make_unique<sf::RenderTexture>();
+    if (!impostor->resize({ impostorSize, impostorSize })) {
         return false;
     }
 
-    int tileX = worldX % CHUNK_SIZE;
-    int tileY = worldY % CHUNK_SIZE;
+    impostor->clear(sf::Color::Transparent);
 
-    // Check if it's actually stone
-    if (chunkIt->second->tiles[tileY][tileX].has_value() &&
-        chunkIt->second->tiles[tileY][tileX]->type == TileType::STONE) {
+    sf::RectangleShape tileRect({ static_cast<float>(resolution), static_cast<float>(resolution) });
+    for (int y = 0; y < CHUNK_SIZE; y++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            sf::Vector2f position{ static_cast<float>(x * resolution), static_cast<float>(y * resolution) };
+            TileType tileType = mesh->tileTypes[y][x];
 
-        // Replace stone with dirt
-        if (!useSimpleGraphics) {
-            chunkIt->second->tiles[tileY][tileX] = Tile(TileType::DIRT, dirtTexture);
-            chunkIt->second->tiles[tileY][tileX]->sprite.setTexture(dirtTexture);
-            chunkIt->second->tiles[tileY][tileX]->sprite.setPosition({
-                static_cast<float>(worldX * TILE_SIZE),
-                static_cast<float>(worldY * TILE_SIZE)
-                });
-
-            sf::Vector2u textureSize = dirtTexture.getSize();
-            if (textureSize.x > 0 && textureSize.y > 0) {
-                chunkIt->second->tiles[tileY][tileX]->sprite.setScale({
-                    static_cast<float>(TILE_SIZE) / textureSize.x,
-                    static_cast<float>(TILE_SIZE) / textureSize.y
+            if (useSimpleGraphics) {
+                tileRect.setFillColor(getTileShape(tileType).getFillColor());
+                tileRect.setPosition(position);
+                impostor->draw(tileRect);
+            }
+            else {
+                sf::Texture& texture = getTileTexture(tileType);
+                sf::Vector2u textureSize = texture.getSize();
+                if (textureSize.x == 0 || textureSize.y == 0) {
+                    continue;
+                }
+
+                sf::Sprite tileSprite(texture);
+                tileSprite.setPosition(position);
+                tileSprite.setScale({
+                    static_cast<float>(resolution) / textureSize.x,
+                    static_cast<float>(resolution) / textureSize.y
                     });
+                impostor->draw(tileSprite);
             }
         }
+    }
 
-        // Update collision data (dirt is not solid)
-        chunkIt->second->solidTiles[tileY][tileX] = false;
+    impostor->display();
+    impostor->setSmooth(true);
+    (void)impostor->generateMipmap(); // Falls back to plain linear filtering without mipmap support
 
-        return true;
+    ChunkImpostor& entry = chunkImpostors[level][mesh->coord];
+    entry.source = mesh;
+    entry.texture = std::move(impostor);
+    return true;
+}
+
+void Map::moveCoarseLayer(int startChunkX, int startChunkY, int endChunkX, int endChunkY) {
+    if (startChunkX >= coarseLayerOrigin.x && startChunkY >= coarseLayerOrigin.y &&
+        endChunkX < coarseLayerOrigin.x + COARSE_LAYER_CHUNKS && endChunkY < coarseLayerOrigin.y + COARSE_LAYER_CHUNKS) {
+        return;
+    }
+
+    // Center the window on the view, keeping the pixels the old and new windows share
+    ChunkCoord newOrigin = {
+        (static_cast<std::int64_t>(startChunkX) + endChunkX) / 2 - COARSE_LAYER_CHUNKS / 2,
+        (static_cast<std::int64_t>(startChunkY) + endChunkY) / 2 - COARSE_LAYER_CHUNKS / 2
+    };
+    sf::Image moved({ static_cast<unsigned>(COARSE_LAYER_CHUNKS), static_cast<unsigned>(COARSE_LAYER_CHUNKS) }, sf::Color::Transparent);
+
+    std::int64_t left = std::max(coarseLayerOrigin.x, newOrigin.x);
+    std::int64_t top = std::max(coarseLayerOrigin.y, newOrigin.y);
+    std::int64_t right = std::min(coarseLayerOrigin.x, newOrigin.x) + COARSE_LAYER_CHUNKS;
+    std::int64_t bottom = std::min(coarseLayerOrigin.y, newOrigin.y) + COARSE_LAYER_CHUNKS;
+    if (left < right && top < bottom) {
+        sf::IntRect shared(
+            { static_cast<int>(left - coarseLayerOrigin.x), static_cast<int>(top - coarseLayerOrigin.y) },
+            { static_cast<int>(right - left), static_cast<int>(bottom - top) });
+        (void)moved.copy(coarseLayerImage, { static_cast<unsigned>(left - newOrigin.x), static_cast<unsigned>(top - newOrigin.y) }, shared);
     }
 
-    return false;
+    coarseLayerImage = std::move(moved);
+    coarseLayerOrigin = newOrigin;
+    coarseLayerTexture.update(coarseLayerImage);
 }
 
-void Map::draw(sf::RenderWindow& window, sf::View& camera) {
-    sf::Vector2f cameraCenter = camera.getCenter();
-    sf::Vector2f cameraSize = camera.getSize();
+void Map::updateCoarseLayer(int startChunkX, int startChunkY, int endChunkX, int endChunkY) {
+    moveCoarseLayer(startChunkX, startChunkY, endChunkX, endChunkY);
+
+    // Fill in a bounded number of missing biome pixels per frame, then upload once
+    std::vector<sf::Vector2u> missing;
+    for (int chunkY = startChunkY; chunkY <= endChunkY; chunkY++) {
+        for (int chunkX = startChunkX; chunkX <= endChunkX; chunkX++) {
+            sf::Vector2u pixel{ static_cast<unsigned>(chunkX - coarseLayerOrigin.x), static_cast<unsigned>(chunkY - coarseLayerOrigin.y) };
+            if (coarseLayerImage.getPixel(pixel).a == 0) {
+                missing.push_back(pixel);
+                if (static_cast<int>(missing.size()) == COARSE_LAYER_UPDATES_PER_FRAME) {
+                    break;
+                }
+            }
+        }
+        if (static_cast<int>(missing.size()) == COARSE_LAYER_UPDATES_PER_FRAME) {
+            break;
+        }
+    }
 
-    // Calculate visible area with some padding
-    int startX = std::max(0, static_cast<int>((cameraCenter.x - cameraSize.x / 2) / TILE_SIZE) - 2);
-    int endX = std::min(WORLD_WIDTH, static_cast<int>((cameraCenter.x + cameraSize.x / 2) / TILE_SIZE) + 2);
-    int startY = std::max(0, static_cast<int>((cameraCenter.y - cameraSize.y / 2) / TILE_SIZE) - 2);
-    int endY = std::min(WORLD_HEIGHT, static_cast<int>((cameraCenter.y + cameraSize.y / 2) / TILE_SIZE) + 2);
+    if (missing.empty()) {
+        return;
+    }
+
+    // Biome sampling runs on the workers; each pixel is written by exactly one job
+    getJobSystem().parallelFor(0, static_cast<int>(missing.size()), 8, [this, &missing](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            int sampleX = static_cast<int>((coarseLayerOrigin.x + missing[i].x) * CHUNK_SIZE + CHUNK_SIZE / 2);
+            int sampleY = static_cast<int>((coarseLayerOrigin.y + missing[i].y) * CHUNK_SIZE + CHUNK_SIZE / 2);
+            coarseLayerImage.setPixel(missing[i], getBiomeColor(getWorkerGenerator().determineBiome(sampleX, sampleY)));
+        }
+    });
 
-    // Draw visible chunks only
-    for (const auto& chunkPair : loadedChunks) {
-        const auto& chunk = chunkPair.second;
+    coarseLayerTexture.update(coarseLayerImage);
+}
+
+void Map::drawCoarseLayer(sf::RenderWindow& window, const RenderOrigin& origin) {
+    sf::Sprite coarseSprite(coarseLayerTexture);
+    coarseSprite.setPosition(origin.chunkToLocal(coarseLayerOrigin));
+    coarseSprite.setScale({
+        static_cast<float>(CHUNK_SIZE * TILE_SIZE),
+        static_cast<float>(CHUNK_SIZE * TILE_SIZE)
+        });
+    window.draw(coarseSprite);
+    lastDrawCalls++;
+}
 
-        // Check if chunk is visible
-        int chunkStartX = chunk->coord.x * CHUNK_SIZE;
-        int chunkEndX = chunkStartX + CHUNK_SIZE;
-        int chunkStartY = chunk->coord.y * CHUNK_SIZE;
-        int chunkEndY = chunkStartY + CHUNK_SIZE;
+void Map::drawImpostors(sf::RenderWindow& window, const RenderOrigin& origin, int level, const std::vector<std::shared_ptr<const ChunkMesh>>& chunks) {
+    int builds = 0;
+    float scale = static_cast<float>(TILE_SIZE) / IMPOSTOR_TILE_RESOLUTIONS[level];
+
+    for (const auto& mesh : chunks) {
+        // A chunk that changed since its impostor was built has a new mesh
+        auto impostorIt = chunkImpostors[level].find(mesh->coord);
+        if (impostorIt == chunkImpostors[level].end() || impostorIt->second.source != mesh) {
+            // Build a limited number per frame; the coarse layer shows through until then
+            if (builds >= IMPOSTOR_BUILDS_PER_FRAME || !buildChunkImpostor(mesh, level)) {
+                continue;
+            }
+            builds++;
+            impostorIt = chunkImpostors[level].find(mesh->coord);
+        }
+
+        sf::Sprite impostorSprite(impostorIt->second.texture->getTexture());
+        impostorSprite.setPosition(origin.chunkToLocal(mesh->coord));
+        impostorSprite.setScale({ scale, scale });
+        window.draw(impostorSprite);
+        lastDrawCalls++;
+    }
+
+    // Drop impostors of chunks the simulation has unloaded (nothing else holds their mesh)
+    for (auto it = chunkImpostors[level].begin(); it != chunkImpostors[level].end();) {
+        if (it->second.source.use_count() == 1) {
+            it = chunkImpostors[level].erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
 
-        if (chunkEndX < startX || chunkStartX > endX ||
-            chunkEndY < startY || chunkStartY > endY) {
-            continue; // Skip invisible chunks
+    // The other level is not needed at this zoom; drop it to bound texture memory
+    for (int other = 0; other < IMPOSTOR_LEVELS; other++) {
+        if (other != level) {
+            chunkImpostors[other].clear();
         }
+    }
+}
+
+void Map::drawTiles(sf::RenderWindow& window, const RenderOrigin& origin, const std::vector<std::shared_ptr<const ChunkMesh>>& chunks, int startX, int startY, int endX, int endY) {
+    for (const auto& mesh : chunks) {
+        int chunkStartX = static_cast<int>(mesh->coord.x * CHUNK_SIZE);
+        int chunkStartY = static_cast<int>(mesh->coord.y * CHUNK_SIZE);
 
         for (int y = 0; y < CHUNK_SIZE; y++) {
             for (int x = 0; x < CHUNK_SIZE; x++) {
@@ -481,33 +873,108 @@ void Map::draw(sf::RenderWindow& window, sf::View& camera) {
                 int worldY = chunkStartY + y;
 
                 if (worldX >= startX && worldX < endX && worldY >= startY && worldY < endY) {
+                    sf::Vector2f position = origin.tileToLocal(worldX, worldY);
+
                     if (useSimpleGraphics) {
                         // Draw simple rectangles for better performance
-                        TileType tileType = generateTileType(worldX, worldY);
-                        sf::RectangleShape* shape = nullptr;
-
-                        switch (tileType) {
-                        case TileType::WATER: shape = &waterTile; break;
-                        case TileType::STONE: shape = &stoneTile; break;
-                        case TileType::TREE: shape = &treeTile; break;
-                        case TileType::DIRT: shape = &dirtTile; break;
-                        default: shape = &grassTile; break;
-                        }
-
-                        shape->setPosition({
-                            static_cast<float>(worldX * TILE_SIZE),
-                            static_cast<float>(worldY * TILE_SIZE)
-                            });
-
-                        window.draw(*shape);
+                        sf::RectangleShape& shape = getTileShape(mesh->tileTypes[y][x]);
+                        shape.setPosition(position);
+                        window.draw(shape);
                     }
                     else {
-                        if (chunk->tiles[y][x].has_value()) {
-                            window.draw(chunk->tiles[y][x]->sprite);
+                        sf::Sprite& sprite = tileSprites[static_cast<int>(mesh->tileTypes[y][x])];
+                        sprite.setPosition(position);
+                        window.draw(sprite);
+                    }
+                    lastDrawCalls++;
+
+                    // Standing water over the tile, more opaque the deeper it is
+                    std::uint8_t waterLevel = mesh->waterLevels[y][x];
+                    if (waterLevel > 0 && mesh->tileTypes[y][x] != TileType::WATER) {
+                        if (useSimpleGraphics) {
+                            sf::RectangleShape overlay = waterTile;
+                            sf::Color color = overlay.getFillColor();
+                            color.a = waterLevel;
+                            overlay.setFillColor(color);
+                            overlay.setPosition(position);
+                            window.draw(overlay);
                         }
+                        else {
+                            sf::Sprite& overlay = tileSprites[static_cast<int>(TileType::WATER)];
+                            overlay.setColor(sf::Color(255, 255, 255, waterLevel));
+                            overlay.setPosition(position);
+                            window.draw(overlay);
+                            overlay.setColor(sf::Color::White);
+                        }
+                        lastDrawCalls++;
                     }
                 }
             }
         }
     }
 }
+
+void Map::getVisibleTileRange(WorldVector center, sf::Vector2f size, int& startX, int& startY, int& endX, int& endY) {
+    startX = static_cast<int>(std::floor((center.x - size.x / 2) / TILE_SIZE)) - 2;
+    endX = static_cast<int>(std::floor((center.x + size.x / 2) / TILE_SIZE)) + 2;
+    startY = static_cast<int>(std::floor((center.y - size.y / 2) / TILE_SIZE)) - 2;
+    endY = static_cast<int>(std::floor((center.y + size.y / 2) / TILE_SIZE)) + 2;
+}
+
+void Map::clampTileRange(int& startX, int& startY, int& endX, int& endY) const {
+    if (infinite) {
+        return;
+    }
+    startX = std::max(0, startX);
+    endX = std::min(WORLD_WIDTH, endX);
+    startY = std::max(0, startY);
+    endY = std::min(WORLD_HEIGHT, endY);
+}
+
+void Map::collectChunkMeshes(int startChunkX, int startChunkY, int endChunkX, int endChunkY, std::vector<std::shared_ptr<const ChunkMesh>>& out) const {
+    out.clear();
+    for (int chunkY = startChunkY; chunkY <= endChunkY; chunkY++) {
+        for (int chunkX = startChunkX; chunkX <= endChunkX; chunkX++) {
+            auto chunkIt = loadedChunks.find({ chunkX, chunkY });
+            if (chunkIt != loadedChunks.end()) {
+                out.push_back(chunkIt->second->mesh);
+            }
+        }
+    }
+}
+
+void Map::draw(sf::RenderWindow& window, const sf::View& camera, const RenderOrigin& origin, const std::vector<std::shared_ptr<const ChunkMesh>>& chunks) {
+    sf::Vector2f cameraSize = camera.getSize();
+    lastDrawCalls = 0;
+
+    int startX, startY, endX, endY;
+    getVisibleTileRange(origin.toWorld(camera.getCenter()), cameraSize, startX, startY, endX, endY);
+    clampTileRange(startX, startY, endX, endY);
+
+    int startChunkX = floorDiv(startX, CHUNK_SIZE);
+    int startChunkY = floorDiv(startY, CHUNK_SIZE);
+    int endChunkX = floorDiv(endX - 1, CHUNK_SIZE);
+    int endChunkY = floorDiv(endY - 1, CHUNK_SIZE);
+
+    // Everything beyond the loaded area comes from the coarse biome layer
+    updateCoarseLayer(startChunkX, startChunkY, endChunkX, endChunkY);
+    drawCoarseLayer(window, origin);
+
+    // Pick the level of detail from the on-screen size of one tile
+    float tilePixels = TILE_SIZE * window.getSize().x / cameraSize.x;
+    if (tilePixels >= LOD_SPRITE_MIN_TILE_PIXELS) {
+        if (useTilemapShader && !tilemap.wasLoadAttempted()) {
+            tilemap.load(buildTileAtlas());
+        }
+        if (useTilemapShader && tilemap.draw(window, origin, chunks, startX, startY, endX, endY)) {
+            lastDrawCalls++;
+        }
+        else {
+            drawTiles(window, origin, chunks, startX, startY, endX, endY);
+        }
+    }
+    else {
+        int level = (tilePixels >= LOD_FINE_IMPOSTOR_MIN_TILE_PIXELS) ? 0 : 1;
+        drawImpostors(window, origin, level, chunks);
+    }
+}
@@ -3,23 +3,85 @@
 
 #include <SFML/Graphics.hpp>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
+#include <vector>
 #include "chunk.h"
 #include "constants.h"
 #include "utils.h"
+#include "streaming.h"
+#include "chunkinterest.h"
+#include "chunkcache.h"
+#include "worldgen.h"
+#include "worldfile.h"
+#include "worldedits.h"
+#include "worldtick.h"
+#include "water.h"
+#include "pathfinding.h"
+#include "flowfield.h"
+#include "tilemap.h"
 
+struct ResourceHit {
+    int worldX;
+    int worldY;
+    int distanceSquared;
+};
+
+// Cached low-detail rendering of one chunk, valid while its source mesh is current
+struct ChunkImpostor {
+    std::shared_ptr<const ChunkMesh> source;
+    std::unique_ptr<sf::RenderTexture> texture;
+};
+
+// Chunk state (loading, tile queries, edits) belongs to the simulation thread. Textures,
+// impostors and the coarse layer belong to the render thread, which only sees chunks
+// through the immutable meshes passed to draw().
 class Map {
 public:
-    std::unordered_map<ChunkCoord, std::unique_ptr<Chunk>, ChunkCoordHash> loadedChunks;
+    LoadedChunks loadedChunks;
     sf::Texture grassTexture;
     sf::Texture waterTexture;
     sf::Texture stoneTexture;
     sf::Texture treeTexture;
     sf::Texture woodTexture;  // Add wood texture
     sf::Texture dirtTexture;  // Add dirt texture
+    sf::Texture torchTexture; // Grass with a torch painted on
+
+    // Terrain generation (noise, biomes, rivers, mountains). Jobs use the generator of the
+    // worker running them, since generator caches are not thread-safe.
+    WorldGenerator generator;
+    std::vector<WorldGenerator> workerGenerators;
+
+    // Optional prebuilt world from the baker; used instead of generating when open
+    BakedWorld bakedWorld;
+
+    // Generated tile cache for queries into unloaded chunks
+    std::unordered_map<std::pair<int, int>, TileType, PairHash> generatedTileCache;
+    static const size_t GENERATED_TILE_CACHE_LIMIT = 1 << 18;
+
+    // Tile edits (felled trees, mined stone). Edits survive chunk unloading and are
+    // reapplied on load; snapshots for saving share them copy-on-write.
+    std::shared_ptr<WorldEdits> worldEdits = std::make_shared<WorldEdits>();
 
-    // Noise cache for performance
-    std::unordered_map<std::pair<int, int>, float, PairHash> noiseCache;
+    // Recently unloaded chunks in compressed form, rehydrated instead of regenerated
+    ChunkCache chunkCache;
+
+    // Tree regrowth and random tile updates, driven by tickWorld()
+    WorldTicker worldTicker;
+    long long worldTick = 0;
+
+    // Water flowing into mined-out dirt, driven by stepWater()
+    WaterSimulation water;
+
+    // Cached portal graphs for hierarchical pathfinding, kept in step with solidity changes
+    PathFinder pathFinder;
+
+    // Every tile change applied, while recordTileDeltas is set; the server drains it each tick
+    bool recordTileDeltas = false;
+    std::vector<TileChange> tileDeltas;
+
+    // Shared field leading mobs toward the player, updated by the simulation each tick
+    FlowField flowField;
 
     // Fallback colors
     sf::RectangleShape grassTile;
@@ -28,28 +90,107 @@ public:
     sf::RectangleShape treeTile;
     sf::RectangleShape woodTile;  // Add wood tile
     sf::RectangleShape dirtTile;  // Add dirt tile
+    sf::RectangleShape torchTile;
     bool useSimpleGraphics = false;
 
-    Map();
+    // One sprite per tile type, repositioned for every tile drawn
+    std::vector<sf::Sprite> tileSprites;
+
+    // Terrain at sprite zoom levels as one shader quad, with autotiled edges between terrains;
+    // falls back to tileSprites, square-edged, without shaders
+    TilemapRenderer tilemap;
+    bool useTilemapShader = true;
+
+    // Level of detail rendering: cached per-chunk impostors for each LOD level,
+    // plus a one-pixel-per-chunk biome layer for everything outside the loaded area. The layer
+    // is a COARSE_LAYER_CHUNKS square window starting at coarseLayerOrigin, moved with the camera.
+    std::unordered_map<ChunkCoord, ChunkImpostor, ChunkCoordHash> chunkImpostors[IMPOSTOR_LEVELS];
+    sf::Image coarseLayerImage;
+    sf::Texture coarseLayerTexture;
+    ChunkCoord coarseLayerOrigin{ 0, 0 };
+    int lastDrawCalls = 0;
+
+    // Reference-counted residency: which chunks each observer needs loaded
+    ChunkInterest interest;
+
+    // Velocity-aware chunk streaming for the local player, as observers in interest
+    ChunkStreamer streamer;
+
+    // Infinite world: no edges, the generator fills in wherever the player goes. Set before
+    // anything is loaded or observed.
+    bool infinite = false;
+
+    explicit Map(bool headless = false); // Headless skips textures, for a server without a window
+
+    void setInfinite(bool enabled);
+    bool isInWorld(int worldX, int worldY) const;
+    bool isChunkInWorld(ChunkCoord chunkCoord) const;
+
+    bool openBakedWorld(const std::string& path);
+
+    // Save/load support
+    std::shared_ptr<const WorldEdits> snapshotEdits() const { return worldEdits; }
+    void restoreEdits(std::shared_ptr<WorldEdits> edits);
+    void unloadAllChunks();
 
-    float noise(int x, int y, int scale);
-    float getDistanceToRiver(int worldX, int worldY);
     BiomeType determineBiome(int worldX, int worldY) const;
     TileType generateTileType(int worldX, int worldY);
 
-    // New mountain generation methods
-    float getMountainHeight(int worldX, int worldY);
-    bool isInMountainRange(int worldX, int worldY);
-    TileType generateMountainTileType(int worldX, int worldY, float elevation, float mountainHeight);
-
+    void generateChunkTiles(Chunk& chunk, WorldGenerator& chunkGenerator) const;
     void loadChunk(ChunkCoord chunkCoord);
-    void unloadDistantChunks(sf::Vector2f playerPos);
-    void loadChunksAroundPlayer(sf::Vector2f playerPos);
+    void loadChunks(const std::vector<ChunkCoord>& chunkCoords); // Generates in parallel on the job system
+    void unloadChunk(ChunkCoord chunkCoord);
+    int unloadUnobservedChunks(); // Loaded chunks no observer keeps; returns how many
+    void unloadDistantChunks(WorldVector playerPos, sf::Vector2f velocity);
+    void loadChunksAroundPlayer(WorldVector playerPos, sf::Vector2f velocity);
+    void tickWorld(long long tick, const std::vector<WorldRect>& keepClear); // keepClear: pixels where nothing may regrow
+    void stepWater();
+    void updateLighting(); // Recomputes the light of chunks touched by torch or wall changes
+
+    // Authoritative tile queries: loaded chunk state first, then edits, then the cached generator
+    TileType getTile(int worldX, int worldY) const;
+    void getTilesInRect(int startX, int startY, int width, int height, std::vector<TileType>& out) const;
+    static bool isSolidType(TileType tileType);
+    static sf::Color getBiomeColor(BiomeType biome);
 
+    // Resource index queries: k nearest tiles of a harvestable type within a tile radius
+    int findNearestResources(TileType type, int worldX, int worldY, int radius, int maxResults, std::vector<ResourceHit>& out) const;
+
+    const Chunk* findChunk(ChunkCoord chunkCoord) const; // nullptr if not loaded
     bool isTileSolid(int worldX, int worldY) const;
     bool destroyTree(int worldX, int worldY); // New method for tree destruction
     bool destroyStone(int worldX, int worldY); // New method for stone destruction
-    void draw(sf::RenderWindow& window, sf::View& camera);
+    bool placeTorch(int worldX, int worldY);   // On grass or dirt
+
+    // Tile range covered by a view, padded by two tiles; clampTileRange limits one to the world
+    static void getVisibleTileRange(WorldVector center, sf::Vector2f size, int& startX, int& startY, int& endX, int& endY);
+    void clampTileRange(int& startX, int& startY, int& endX, int& endY) const;
+    void collectChunkMeshes(int startChunkX, int startChunkY, int endChunkX, int endChunkY, std::vector<std::shared_ptr<const ChunkMesh>>& out) const;
+
+    // Render thread; camera and drawing are relative to origin
+    void draw(sf::RenderWindow& window, const sf::View& camera, const RenderOrigin& origin, const std::vector<std::shared_ptr<const ChunkMesh>>& chunks);
+
+private:
+    TileType getGeneratedTile(int worldX, int worldY) const;
+    WorldGenerator& getWorkerGenerator();
+    sf::Texture& getTileTexture(TileType tileType);
+    sf::RectangleShape& getTileShape(TileType tileType);
+    sf::Image buildTileAtlas();
+    bool buildChunkImpostor(const std::shared_ptr<const ChunkMesh>& mesh, int level);
+    void updateCoarseLayer(int startChunkX, int startChunkY, int endChunkX, int endChunkY);
+    void moveCoarseLayer(int startChunkX, int startChunkY, int endChunkX, int endChunkY);
+    void drawCoarseLayer(sf::RenderWindow& window, const RenderOrigin& origin);
+    void drawImpostors(sf::RenderWindow& window, const RenderOrigin& origin, int level, const std::vector<std::shared_ptr<const ChunkMesh>>& chunks);
+    void drawTiles(sf::RenderWindow& window, const RenderOrigin& origin, const std::vector<std::shared_ptr<const ChunkMesh>>& chunks, int startX, int startY, int endX, int endY);
+    std::vector<TileChange> tickChanges;
+    std::vector<ChunkCoord> waterChangedChunks;
+    std::vector<ChunkCoord> retiledChunks;
+    std::vector<sf::Vector2i> floodedTiles;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> dirtyLight;
+
+    bool replaceTile(int worldX, int worldY, TileType expected, TileType replacement);
+    void scheduleFelledTrees(const Chunk& chunk);
+    void recordEdit(ChunkCoord chunkCoord, int tileIndex, TileType tileType);
 };
 
 #endif
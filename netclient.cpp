@@ -0,0 +1,163 @@
+#include "netclient.h"
+#include "netprotocol.h"
+#include <iostream>
+#include <optional>
+
+bool NetClient::connect(const std::string& host, unsigned short port) {
+    std::optional<sf::IpAddress> address = sf::IpAddress::resolve(host);
+    if (!address) {
+        std::cout << "Could not resolve " << host << std::endl;
+        return false;
+    }
+    if (socket.connect(*address, port, sf::seconds(5.0f)) != sf::Socket::Status::Done) {
+        return false;
+    }
+    socket.setBlocking(false);
+    connected = true;
+
+    sf::Packet hello;
+    hello << static_cast<std::uint8_t>(NetMessage::HELLO) << NET_PROTOCOL_VERSION << static_cast<std::uint32_t>(CHUNK_SIZE);
+    queue(std::move(hello));
+    return true;
+}
+
+void NetClient::disconnect() {
+    socket.disconnect();
+    connected = false;
+    welcomed = false;
+    outgoing.clear();
+    chunks.clear();
+}
+
+void NetClient::sendCommand(const InputCommand& command) {
+    sf::Packet packet;
+    packet << static_cast<std::uint8_t>(NetMessage::INPUT);
+    writeCommand(packet, command);
+    queue(std::move(packet));
+}
+
+void NetClient::queue(sf::Packet&& packet) {
+    if (connected) {
+        outgoing.push_back(std::move(packet));
+    }
+}
+
+bool NetClient::poll() {
+    while (connected) {
+        sf::Packet packet;
+        sf::Socket::Status status = socket.receive(packet);
+        if (status == sf::Socket::Status::Done) {
+            stats.bytesReceived += static_cast<long long>(wireBytes(packet));
+            handle(packet);
+        }
+        else if (status == sf::Socket::Status::NotReady || status == sf::Socket::Status::Partial) {
+            break;
+        }
+        else {
+            connected = false;
+        }
+    }
+
+    while (connected && !outgoing.empty()) {
+        sf::Socket::Status status = socket.send(outgoing.front());
+        if (status == sf::Socket::Status::Done) {
+            stats.bytesSent += static_cast<long long>(wireBytes(outgoing.front()));
+            outgoing.pop_front();
+        }
+        else if (status == sf::Socket::Status::Partial || status == sf::Socket::Status::NotReady) {
+            break;
+        }
+        else {
+            connected = false;
+        }
+    }
+    return connected;
+}
+
+void NetClient::handle(sf::Packet& packet) {
+    std::uint8_t type;
+    if (!(packet >> type)) {
+        return;
+    }
+
+    switch (static_cast<NetMessage>(type)) {
+    case NetMessage::WELCOME:
+        if (packet >> clientId >> serverTickRate) {
+            welcomed = true;
+        }
+        break;
+    case NetMessage::CHUNK:
+        if (readChunk(packet, chunkScratch)) {
+            decompressChunk(chunkScratch, chunks[chunkScratch.coord].data());
+            stats.chunksReceived++;
+            stats.chunkBytes += static_cast<long long>(wireBytes(packet));
+        }
+        break;
+    case NetMessage::CHUNK_DROP: {
+        std::int32_t x, y;
+        if (packet >> x >> y) {
+            chunks.erase({ x, y });
+            stats.chunksDropped++;
+        }
+        break;
+    }
+    case NetMessage::TILE_DELTAS: {
+        std::uint32_t count;
+        if (!(packet >> count)) {
+            break;
+        }
+        for (std::uint32_t i = 0; i < count; i++) {
+            std::int32_t x, y;
+            std::uint8_t tileType;
+            if (!(packet >> x >> y >> tileType)) {
+                break;
+            }
+            auto chunkIt = chunks.find(chunkOfTile(x, y));
+            if (chunkIt != chunks.end()) {
+                chunkIt->second[localTileIndex(x, y)] = static_cast<TileType>(tileType);
+            }
+            stats.tileDeltas++;
+        }
+        break;
+    }
+    case NetMessage::PLAYER_STATE:
+        packet >> serverTick >> position.x >> position.y >> harvesting >> harvestProgress;
+        break;
+    case NetMessage::OTHER_PLAYERS: {
+        std::uint16_t count;
+        if (!(packet >> count)) {
+            break;
+        }
+        otherPlayers.clear();
+        for (int i = 0; i < count; i++) {
+            RemotePlayer player;
+            if (!(packet >> player.id >> player.position.x >> player.position.y)) {
+                break;
+            }
+            otherPlayers.push_back(player);
+        }
+        break;
+    }
+    case NetMessage::SERVER_STATS: {
+        std::uint16_t clients;
+        if (packet >> serverTickMilliseconds >> serverMaxTickMilliseconds >> clients) {
+            serverClients = clients;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+bool NetClient::getTile(int worldX, int worldY, TileType& tileType) const {
+    if (worldX < 0 || worldY < 0) {
+        return false;
+    }
+    auto chunkIt = chunks.find(chunkOfTile(worldX, worldY));
+    if (chunkIt == chunks.end()) {
+        return false;
+    }
+    tileType = chunkIt->second[localTileIndex(worldX, worldY)];
+    return true;
+}
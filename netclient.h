@@ -0,0 +1,73 @@
+#ifndef NETCLIENT_H
+#define NETCLIENT_H
+
+#include <SFML/Network.hpp>
+#include <array>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include "constants.h"
+#include "utils.h"
+#include "input.h"
+#include "chunkcache.h"
+
+struct NetClientStats {
+    long long bytesReceived = 0;
+    long long bytesSent = 0;
+    long long chunksReceived = 0;
+    long long chunkBytes = 0;   // Chunk packets only
+    long long chunksDropped = 0;
+    long long tileDeltas = 0;
+};
+
+struct RemotePlayer {
+    std::uint16_t id;
+    sf::Vector2f position; // Pixels
+};
+
+// Connection to a GameServer: sends InputCommands and keeps a copy of the tiles of every
+// chunk the server has streamed, kept current by its tile deltas
+class NetClient {
+public:
+    using ChunkTiles = std::array<TileType, CHUNK_SIZE * CHUNK_SIZE>;
+
+    // From the server
+    std::uint16_t clientId = 0;
+    bool welcomed = false;
+    float serverTickRate = 0.0f;
+    std::uint32_t serverTick = 0;
+    sf::Vector2f position;          // Our player, pixels
+    bool harvesting = false;
+    float harvestProgress = 0.0f;   // 0 to 1
+    std::vector<RemotePlayer> otherPlayers;
+    std::unordered_map<ChunkCoord, ChunkTiles, ChunkCoordHash> chunks;
+
+    // The server's own numbers, refreshed once a second
+    float serverTickMilliseconds = 0.0f;
+    float serverMaxTickMilliseconds = 0.0f;
+    int serverClients = 0;
+
+    NetClientStats stats;
+
+    bool connect(const std::string& host, unsigned short port); // Blocks until connected or failed
+    void disconnect();
+    bool isConnected() const { return connected; }
+
+    void sendCommand(const InputCommand& command);
+    bool poll(); // Handles everything received and sends what is queued; false once disconnected
+
+    bool getTile(int worldX, int worldY, TileType& tileType) const; // False outside received chunks
+
+private:
+    sf::TcpSocket socket;
+    bool connected = false;
+    std::deque<sf::Packet> outgoing;
+    CompressedChunk chunkScratch;
+
+    void handle(sf::Packet& packet);
+    void queue(sf::Packet&& packet);
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include "netprotocol.h"
+#include <algorithm>
+
+namespace {
+    enum class ChunkEncoding : std::uint8_t {
+        RUNS,   // Run count, then (palette index, length - 1) byte pairs
+        PACKED  // Palette index of every tile in as few bits as the palette needs
+    };
+
+    int bitsForPalette(size_t paletteSize) {
+        int bits = 0;
+        while ((static_cast<size_t>(1) << bits) < paletteSize) {
+            bits++;
+        }
+        return bits;
+    }
+}
+
+void writeChunk(sf::Packet& packet, const CompressedChunk& compressed) {
+    packet << static_cast<std::int32_t>(compressed.coord.x) << static_cast<std::int32_t>(compressed.coord.y);
+
+    packet << static_cast<std::uint8_t>(compressed.palette.size());
+    for (TileType tileType : compressed.palette) {
+        packet << static_cast<std::uint8_t>(tileType);
+    }
+
+    // Runs are at most 256 tiles on the wire; longer ones are split
+    std::uint16_t runCount = 0;
+    for (const TileRun& run : compressed.runs) {
+        runCount += static_cast<std::uint16_t>((run.length + 255) / 256);
+    }
+
+    // Busy chunks (forest edges, rivers) pack smaller than they run-length encode
+    const int tileCount = CHUNK_SIZE * CHUNK_SIZE;
+    int bits = bitsForPalette(compressed.palette.size());
+    int packedBytes = (tileCount * bits + 7) / 8;
+    if (packedBytes < 2 + 2 * runCount) {
+        packet << static_cast<std::uint8_t>(ChunkEncoding::PACKED);
+        std::uint32_t buffer = 0;
+        int buffered = 0;
+        for (const TileRun& run : compressed.runs) {
+            for (int i = 0; i < run.length; i++) {
+                buffer |= static_cast<std::uint32_t>(run.paletteIndex) << buffered;
+                buffered += bits;
+                while (buffered >= 8) {
+                    packet << static_cast<std::uint8_t>(buffer & 0xFF);
+                    buffer >>= 8;
+                    buffered -= 8;
+                }
+            }
+        }
+        if (buffered > 0) {
+            packet << static_cast<std::uint8_t>(buffer & 0xFF);
+        }
+        return;
+    }
+
+    packet << static_cast<std::uint8_t>(ChunkEncoding::RUNS) << runCount;
+    for (const TileRun& run : compressed.runs) {
+        for (int remaining = run.length; remaining > 0; remaining -= 256) {
+            packet << run.paletteIndex << static_cast<std::uint8_t>(std::min(remaining, 256) - 1);
+        }
+    }
+}
+
+bool readChunk(sf::Packet& packet, CompressedChunk& compressed) {
+    std::int32_t x, y;
+    std::uint8_t paletteSize;
+    if (!(packet >> x >> y >> paletteSize) || paletteSize == 0) {
+        return false;
+    }
+    compressed.coord = { x, y };
+
+    compressed.palette.resize(paletteSize);
+    for (TileType& tileType : compressed.palette) {
+        std::uint8_t value;
+        if (!(packet >> value)) {
+            return false;
+        }
+        tileType = static_cast<TileType>(value);
+    }
+
+    std::uint8_t encoding;
+    if (!(packet >> encoding)) {
+        return false;
+    }
+    const int tileCount = CHUNK_SIZE * CHUNK_SIZE;
+    compressed.runs.clear();
+
+    if (static_cast<ChunkEncoding>(encoding) == ChunkEncoding::PACKED) {
+        // Back into runs, so both encodings arrive in the same form
+        int bits = bitsForPalette(paletteSize);
+        std::uint32_t buffer = 0;
+        int buffered = 0;
+        for (int i = 0; i < tileCount; i++) {
+            while (buffered < bits) {
+                std::uint8_t byte;
+                if (!(packet >> byte)) {
+                    return false;
+                }
+                buffer |= static_cast<std::uint32_t>(byte) << buffered;
+                buffered += 8;
+            }
+            std::uint8_t index = static_cast<std::uint8_t>(buffer & ((1u << bits) - 1));
+            buffer >>= bits;
+            buffered -= bits;
+            if (index >= paletteSize) {
+                return false;
+            }
+            if (!compressed.runs.empty() && compressed.runs.back().paletteIndex == index) {
+                compressed.runs.back().length++;
+            }
+            else {
+                compressed.runs.push_back({ index, 1 });
+            }
+        }
+        return true;
+    }
+
+    std::uint16_t runCount;
+    if (static_cast<ChunkEncoding>(encoding) != ChunkEncoding::RUNS || !(packet >> runCount)) {
+        return false;
+    }
+    compressed.runs.resize(runCount);
+    int total = 0;
+    for (TileRun& run : compressed.runs) {
+        std::uint8_t lengthMinusOne;
+        if (!(packet >> run.paletteIndex >> lengthMinusOne) || run.paletteIndex >= paletteSize) {
+            return false;
+        }
+        run.length = static_cast<std::uint16_t>(lengthMinusOne + 1);
+        total += run.length;
+    }
+    return total == tileCount;
+}
+
+void writeCommand(sf::Packet& packet, const InputCommand& command) {
+    packet << static_cast<std::uint8_t>(command.type) << command.flags
+        << static_cast<std::int32_t>(command.a) << static_cast<std::int32_t>(command.b);
+}
+
+bool readCommand(sf::Packet& packet, InputCommand& command) {
+    std::uint8_t type;
+    std::int32_t a, b;
+    if (!(packet >> type >> command.flags >> a >> b)) {
+        return false;
+    }
+    command.type = static_cast<InputCommandType>(type);
+    command.a = a;
+    command.b = b;
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef NETPROTOCOL_H
+#define NETPROTOCOL_H
+
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include <cstddef>
+#include "constants.h"
+#include "chunkcache.h"
+#include "input.h"
+
+const std::uint32_t NET_PROTOCOL_VERSION = 3; // 2: HELLO carries the chunk size; 3: 32-bit tile delta count
+
+// First field of every packet. Each client has one TCP connection, framed by sf::Packet.
+enum class NetMessage : std::uint8_t {
+    // Client to server
+    HELLO,          // Protocol version, chunk size
+    INPUT,          // One InputCommand: type, flags, a, b
+
+    // Server to client
+    WELCOME,        // Client id, server tick rate
+    CHUNK,          // A chunk entering the client's interest area, palette compressed
+    CHUNK_DROP,     // Coordinates of a chunk that left it
+    TILE_DELTAS,    // Count, then x, y and new type of each tile changed in chunks the client has
+    PLAYER_STATE,   // Server tick, own position and harvest progress
+    OTHER_PLAYERS,  // Count, then id and position of the nearest other players
+    SERVER_STATS    // Average and longest tick over the last second, clients connected
+};
+
+// A chunk on the wire: coordinates and palette, then either runs of palette indices or every
+// tile's index bit-packed, whichever is smaller
+void writeChunk(sf::Packet& packet, const CompressedChunk& compressed);
+bool readChunk(sf::Packet& packet, CompressedChunk& compressed); // False if malformed
+
+void writeCommand(sf::Packet& packet, const InputCommand& command);
+bool readCommand(sf::Packet& packet, InputCommand& command);
+
+// What a packet costs on the connection, including sf::Packet's 4-byte size prefix
+inline std::size_t wireBytes(const sf::Packet& packet) { return packet.getDataSize() + 4; }
+
+#endif
@@ -0,0 +1,278 @@
+// Pathfinding benchmark: loads a square region of the world and times long path queries
+// across it, hierarchical against plain tile A*, then how quickly queries recover after a
+// tile edit invalidates part of the cached portal graph, and queries with no path.
+//
+// Usage: pathbench [QUERIES] [--chunks N] [--world PATH]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+
+#include "constants.h"
+#include "map.h"
+#include "pathfinding.h"
+#include "benchutil.h"
+
+namespace {
+    // Plain A* over tiles with the same moves and costs, for comparison; returns the path cost or -1
+    int tileAStar(const Map& gameMap, sf::Vector2i start, sf::Vector2i goal, int regionX, int regionY, int regionTiles) {
+        auto index = [&](int x, int y) { return (y - regionY) * regionTiles + (x - regionX); };
+        auto heuristic = [&goal](int x, int y) {
+            int dx = std::abs(x - goal.x);
+            int dy = std::abs(y - goal.y);
+            return 10 * std::max(dx, dy) + 4 * std::min(dx, dy);
+        };
+        auto open = [&](int x, int y) {
+            return x >= regionX && x < regionX + regionTiles && y >= regionY && y < regionY + regionTiles && !gameMap.isTileSolid(x, y);
+        };
+
+        std::vector<int> cost(static_cast<size_t>(regionTiles) * regionTiles, -1);
+        std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> heap;
+        cost[index(start.x, start.y)] = 0;
+        heap.push({ heuristic(start.x, start.y), index(start.x, start.y) });
+        while (!heap.empty()) {
+            int tile = heap.top().second;
+            int estimate = heap.top().first;
+            heap.pop();
+            int x = regionX + tile % regionTiles;
+            int y = regionY + tile / regionTiles;
+            if (estimate - heuristic(x, y) > cost[tile]) {
+                continue;
+            }
+            if (x == goal.x && y == goal.y) {
+                return cost[tile];
+            }
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    bool diagonal = dx != 0 && dy != 0;
+                    if ((dx == 0 && dy == 0) || !open(x + dx, y + dy) || (diagonal && (!open(x + dx, y) || !open(x, y + dy)))) {
+                        continue;
+                    }
+                    int next = index(x + dx, y + dy);
+                    int nextCost = cost[tile] + (diagonal ? 14 : 10);
+                    if (cost[next] < 0 || nextCost < cost[next]) {
+                        cost[next] = nextCost;
+                        heap.push({ nextCost + heuristic(x + dx, y + dy), next });
+                    }
+                }
+            }
+        }
+        return -1;
+    }
+
+    // Steps are single moves onto open tiles, diagonals only past two open sides
+    bool isValidPath(const Map& gameMap, sf::Vector2i start, const std::vector<sf::Vector2i>& tiles, int& cost) {
+        cost = 0;
+        sf::Vector2i previous = start;
+        for (sf::Vector2i tile : tiles) {
+            int dx = tile.x - previous.x;
+            int dy = tile.y - previous.y;
+            bool diagonal = dx != 0 && dy != 0;
+            if (std::abs(dx) > 1 || std::abs(dy) > 1 || (dx == 0 && dy == 0) || gameMap.isTileSolid(tile.x, tile.y) ||
+                (diagonal && (gameMap.isTileSolid(previous.x + dx, previous.y) || gameMap.isTileSolid(previous.x, previous.y + dy)))) {
+                return false;
+            }
+            cost += diagonal ? 14 : 10;
+            previous = tile;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int queryCount = 200;
+    int regionChunks = 64;
+    std::string worldPath = "world.bake";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--chunks" && hasValue) regionChunks = std::max(2, std::atoi(argv[++i]));
+        else if (arg == "--world" && hasValue) worldPath = argv[++i];
+        else if (!arg.empty() && arg[0] != '-') queryCount = std::max(1, std::atoi(arg.c_str()));
+        else {
+            std::cout << "Usage: pathbench [QUERIES] [--chunks N] [--world PATH]" << std::endl;
+            return 1;
+        }
+    }
+
+    Map gameMap;
+    gameMap.openBakedWorld(worldPath);
+
+    regionChunks = std::min({ regionChunks, CHUNKS_X, CHUNKS_Y });
+    int firstChunkX = (CHUNKS_X - regionChunks) / 2;
+    int firstChunkY = (CHUNKS_Y - regionChunks) / 2;
+    std::vector<ChunkCoord> region;
+    for (int y = 0; y < regionChunks; y++) {
+        for (int x = 0; x < regionChunks; x++) {
+            region.push_back({ firstChunkX + x, firstChunkY + y });
+        }
+    }
+    gameMap.loadChunks(region);
+
+    // Rivers split the world into separate landmasses. Reachable queries run between far
+    // apart tiles of the largest one; unreachable ones (the most expensive kind, searching a
+    // whole landmass) between different landmasses.
+    int regionX = firstChunkX * CHUNK_SIZE;
+    int regionY = firstChunkY * CHUNK_SIZE;
+    int regionTiles = regionChunks * CHUNK_SIZE;
+    std::vector<int> landmass(static_cast<size_t>(regionTiles) * regionTiles, -1);
+    std::vector<std::vector<sf::Vector2i>> landmasses;
+    for (int y = regionY; y < regionY + regionTiles; y++) {
+        for (int x = regionX; x < regionX + regionTiles; x++) {
+            if (gameMap.isTileSolid(x, y) || landmass[(y - regionY) * regionTiles + (x - regionX)] >= 0) {
+                continue;
+            }
+
+            // Moves along the axes connect the same tiles as diagonal ones, since corners can't be cut
+            int label = static_cast<int>(landmasses.size());
+            landmasses.emplace_back();
+            std::vector<sf::Vector2i> frontier = { { x, y } };
+            landmass[(y - regionY) * regionTiles + (x - regionX)] = label;
+            while (!frontier.empty()) {
+                sf::Vector2i tile = frontier.back();
+                frontier.pop_back();
+                landmasses[label].push_back(tile);
+
+                const int offsets[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+                for (const auto& offset : offsets) {
+                    sf::Vector2i next = { tile.x + offset[0], tile.y + offset[1] };
+                    if (next.x < regionX || next.x >= regionX + regionTiles || next.y < regionY || next.y >= regionY + regionTiles) {
+                        continue;
+                    }
+                    int& nextLabel = landmass[(next.y - regionY) * regionTiles + (next.x - regionX)];
+                    if (nextLabel < 0 && !gameMap.isTileSolid(next.x, next.y)) {
+                        nextLabel = label;
+                        frontier.push_back(next);
+                    }
+                }
+            }
+        }
+    }
+    if (landmasses.empty()) {
+        std::cout << "The region has no open tiles" << std::endl;
+        return 1;
+    }
+    auto largest = std::max_element(landmasses.begin(), landmasses.end(),
+        [](const std::vector<sf::Vector2i>& a, const std::vector<sf::Vector2i>& b) { return a.size() < b.size(); });
+
+    std::mt19937 rng(4242);
+    std::vector<std::pair<sf::Vector2i, sf::Vector2i>> queries;
+    int farEnough = regionTiles / 2;
+    for (int attempt = 0; static_cast<int>(queries.size()) < queryCount && attempt < queryCount * 1000; attempt++) {
+        sf::Vector2i start = (*largest)[rng() % largest->size()];
+        sf::Vector2i goal = (*largest)[rng() % largest->size()];
+        if (std::abs(start.x - goal.x) + std::abs(start.y - goal.y) >= farEnough || attempt >= queryCount * 500) {
+            queries.push_back({ start, goal });
+        }
+    }
+    queryCount = static_cast<int>(queries.size());
+
+    std::vector<std::pair<sf::Vector2i, sf::Vector2i>> unreachableQueries;
+    for (int attempt = 0; landmasses.size() > 1 && unreachableQueries.size() < 20 && attempt < 100000; attempt++) {
+        sf::Vector2i start = (*largest)[rng() % largest->size()];
+        const auto& other = landmasses[rng() % landmasses.size()];
+        if (&other != &*largest && other.size() > 1) {
+            unreachableQueries.push_back({ start, other[rng() % other.size()] });
+        }
+    }
+
+    std::cout << "Region: " << regionChunks << "x" << regionChunks << " chunks (" << regionTiles << " tiles across), "
+        << landmasses.size() << " landmasses, the largest " << largest->size() << " tiles" << std::endl;
+    std::cout << queryCount << " queries at least " << farEnough << " tiles apart" << std::endl;
+
+    PathFinder pathFinder;
+    std::vector<sf::Vector2i> waypoints;
+    std::vector<sf::Vector2i> tiles;
+
+    // Cold: the first queries build the portal graphs of every chunk they touch
+    auto start = std::chrono::steady_clock::now();
+    int found = 0;
+    for (const auto& query : queries) {
+        found += pathFinder.findAbstractPath(gameMap, query.first, query.second, waypoints) ? 1 : 0;
+    }
+    std::cout << "Cold pass: " << millisecondsSince(start) << " ms total, " << pathFinder.getCachedChunks()
+        << " chunk graphs built, " << found << "/" << queryCount << " paths found" << std::endl;
+
+    std::vector<double> abstractTimes;
+    std::vector<double> fullTimes;
+    long long expanded = 0;
+    for (const auto& query : queries) {
+        start = std::chrono::steady_clock::now();
+        pathFinder.findAbstractPath(gameMap, query.first, query.second, waypoints);
+        abstractTimes.push_back(millisecondsSince(start));
+        expanded += pathFinder.getLastExpandedNodes();
+
+        start = std::chrono::steady_clock::now();
+        pathFinder.findPath(gameMap, query.first, query.second, tiles);
+        fullTimes.push_back(millisecondsSince(start));
+    }
+    reportTimes("Abstract path (warm)", abstractTimes);
+    reportTimes("Refined tile path (warm)", fullTimes);
+    std::cout << "Expanded portal nodes: " << expanded / queryCount << " per query avg" << std::endl;
+
+    // Plain tile A* on a sample of the queries: check the paths and how much longer they are
+    int samples = std::min(queryCount, 20);
+    std::vector<double> referenceTimes;
+    double totalOverhead = 0.0;
+    int compared = 0;
+    bool consistent = true;
+    for (int i = 0; i < samples; i++) {
+        const auto& query = queries[i];
+        bool hierarchicalFound = pathFinder.findPath(gameMap, query.first, query.second, tiles);
+        int hierarchicalCost = 0;
+        if (hierarchicalFound && !isValidPath(gameMap, query.first, tiles, hierarchicalCost)) {
+            std::cout << "Invalid path for query " << i << std::endl;
+            consistent = false;
+        }
+
+        start = std::chrono::steady_clock::now();
+        int referenceCost = tileAStar(gameMap, query.first, query.second, regionX, regionY, regionTiles);
+        referenceTimes.push_back(millisecondsSince(start));
+
+        if (hierarchicalFound != (referenceCost >= 0)) {
+            std::cout << "Query " << i << ": hierarchical " << (hierarchicalFound ? "found" : "missed")
+                << " a path tile A* " << (referenceCost >= 0 ? "found" : "didn't") << std::endl;
+            consistent = false;
+        }
+        else if (referenceCost > 0) {
+            totalOverhead += static_cast<double>(hierarchicalCost) / referenceCost - 1.0;
+            compared++;
+        }
+    }
+    reportTimes("Tile A* (reference)", referenceTimes);
+    std::cout << "Hierarchical paths are " << 100.0 * totalOverhead / std::max(1, compared)
+        << "% longer than optimal on average (" << compared << " compared)" << std::endl;
+
+    // An edit only rebuilds the graphs around it, on the next query that reaches them
+    std::vector<double> editTimes;
+    for (int i = 0; i < std::min(queryCount, 50); i++) {
+        ChunkCoord chunk = region[rng() % region.size()];
+        pathFinder.invalidateAround(chunk);
+        const auto& query = queries[i];
+        start = std::chrono::steady_clock::now();
+        pathFinder.findAbstractPath(gameMap, query.first, query.second, waypoints);
+        editTimes.push_back(millisecondsSince(start));
+    }
+    reportTimes("Query after an edit", editTimes);
+
+    std::vector<double> unreachableTimes;
+    for (const auto& query : unreachableQueries) {
+        start = std::chrono::steady_clock::now();
+        if (pathFinder.findAbstractPath(gameMap, query.first, query.second, waypoints)) {
+            std::cout << "Found a path between separate landmasses" << std::endl;
+            consistent = false;
+        }
+        unreachableTimes.push_back(millisecondsSince(start));
+    }
+    reportTimes("Unreachable goal", unreachableTimes);
+
+    std::cout << "Hierarchical and tile A* " << (consistent ? "agree" : "DISAGREE") << std::endl;
+    return consistent ? 0 : 1;
+}
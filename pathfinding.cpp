@@ -0,0 +1,426 @@
+#include "pathfinding.h"
+#include "map.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <cstdlib>
+
+namespace {
+    const std::int32_t UNREACHED = std::numeric_limits<std::int32_t>::max();
+    const int STRAIGHT_COST = 10;
+    const int DIAGONAL_COST = 14;
+
+    // Directions as used by ChunkGraph::nodeExits: north, south, west, east
+    const int DIRECTIONS[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+
+    int octileDistance(sf::Vector2i from, sf::Vector2i to) {
+        int dx = std::abs(from.x - to.x);
+        int dy = std::abs(from.y - to.y);
+        return STRAIGHT_COST * std::max(dx, dy) + (DIAGONAL_COST - STRAIGHT_COST) * std::min(dx, dy);
+    }
+
+    // Local tile index of the i-th tile along a chunk's border in a direction, and of the
+    // tile facing it in the neighbor
+    int borderTile(int direction, int i) {
+        switch (direction) {
+        case 0: return i;
+        case 1: return (CHUNK_SIZE - 1) * CHUNK_SIZE + i;
+        case 2: return i * CHUNK_SIZE;
+        default: return i * CHUNK_SIZE + CHUNK_SIZE - 1;
+        }
+    }
+
+    int facingTile(int direction, int i) {
+        return borderTile(direction ^ 1, i); // North faces the neighbor's south edge and so on
+    }
+
+    int borderPosition(int direction, int tileIndex) {
+        return (direction < 2) ? tileIndex % CHUNK_SIZE : tileIndex / CHUNK_SIZE;
+    }
+
+    bool isSolid(const Chunk& chunk, int tileIndex) {
+        return chunk.solidTiles[tileIndex / CHUNK_SIZE][tileIndex % CHUNK_SIZE];
+    }
+}
+
+PathFinder::SearchNode& PathFinder::searchNode(int id) {
+    if (id >= static_cast<int>(searchNodes.size())) {
+        searchNodes.resize(graphs.size() * MAX_CHUNK_NODES);
+    }
+    SearchNode& node = searchNodes[id];
+    if (node.stamp != searchStamp) {
+        node.stamp = searchStamp;
+        node.cost = UNREACHED;
+        node.parent = NO_NODE;
+        node.closed = false;
+    }
+    return node;
+}
+
+void PathFinder::searchChunk(const Chunk& chunk, int fromTile, int toTile) {
+    std::fill(localCost, localCost + CHUNK_SIZE * CHUNK_SIZE, UNREACHED);
+    localCost[fromTile] = 0;
+    localParent[fromTile] = -1;
+
+    // A* toward a target tile, plain Dijkstra over the whole chunk without one
+    sf::Vector2i target = { toTile % CHUNK_SIZE, toTile / CHUNK_SIZE };
+    auto heuristic = [toTile, target](int tile) {
+        return (toTile < 0) ? 0 : octileDistance({ tile % CHUNK_SIZE, tile / CHUNK_SIZE }, target);
+    };
+
+    auto byCost = std::greater<std::pair<std::int32_t, std::int16_t>>();
+    localHeap.clear();
+    localHeap.push_back({ heuristic(fromTile), static_cast<std::int16_t>(fromTile) });
+
+    while (!localHeap.empty()) {
+        std::pop_heap(localHeap.begin(), localHeap.end(), byCost);
+        int tile = localHeap.back().second;
+        std::int32_t cost = localHeap.back().first - heuristic(tile);
+        localHeap.pop_back();
+        if (cost > localCost[tile]) {
+            continue;
+        }
+        if (tile == toTile) {
+            return;
+        }
+
+        int x = tile % CHUNK_SIZE;
+        int y = tile / CHUNK_SIZE;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                int nextX = x + dx;
+                int nextY = y + dy;
+                if ((dx == 0 && dy == 0) || nextX < 0 || nextX >= CHUNK_SIZE || nextY < 0 || nextY >= CHUNK_SIZE ||
+                    chunk.solidTiles[nextY][nextX]) {
+                    continue;
+                }
+
+                // Diagonals need both tiles beside them open, so nothing squeezes between two corners
+                bool diagonal = dx != 0 && dy != 0;
+                if (diagonal && (chunk.solidTiles[y][nextX] || chunk.solidTiles[nextY][x])) {
+                    continue;
+                }
+
+                int next = nextY * CHUNK_SIZE + nextX;
+                std::int32_t nextCost = cost + (diagonal ? DIAGONAL_COST : STRAIGHT_COST);
+                if (nextCost < localCost[next]) {
+                    localCost[next] = nextCost;
+                    localParent[next] = static_cast<std::int16_t>(tile);
+                    localHeap.push_back({ nextCost + heuristic(next), static_cast<std::int16_t>(next) });
+                    std::push_heap(localHeap.begin(), localHeap.end(), byCost);
+                }
+            }
+        }
+    }
+}
+
+void PathFinder::buildGraph(const Map& gameMap, const Chunk& chunk, ChunkGraph& graph) {
+    graph.nodeTiles.clear();
+    graph.nodePositions.clear();
+    graph.nodeExits.clear();
+    graph.edgeOffsets.clear();
+    graph.edges.clear();
+    std::fill(graph.nodeAt, graph.nodeAt + CHUNK_SIZE * CHUNK_SIZE, static_cast<std::int16_t>(NO_NODE));
+    std::fill(graph.neighborSlots, graph.neighborSlots + 4, NO_NODE);
+
+    auto addNode = [&graph](int tileIndex, int direction) {
+        if (graph.nodeAt[tileIndex] == NO_NODE) {
+            graph.nodeAt[tileIndex] = static_cast<std::int16_t>(graph.nodeTiles.size());
+            graph.nodeTiles.push_back(static_cast<std::uint16_t>(tileIndex));
+            graph.nodePositions.push_back({
+                static_cast<int>(graph.coord.x * CHUNK_SIZE + tileIndex % CHUNK_SIZE),
+                static_cast<int>(graph.coord.y * CHUNK_SIZE + tileIndex / CHUNK_SIZE)
+            });
+            graph.nodeExits.push_back(0);
+        }
+        graph.nodeExits[graph.nodeAt[tileIndex]] |= 1 << direction;
+    };
+
+    // Entrances: runs of tiles open on both sides of a border. Short runs get one in the
+    // middle, long ones one at each end. The neighbor finds the same runs from its side.
+    for (int direction = 0; direction < 4; direction++) {
+        const Chunk* neighbor = gameMap.findChunk({ chunk.coord.x + DIRECTIONS[direction][0], chunk.coord.y + DIRECTIONS[direction][1] });
+        if (!neighbor) {
+            continue;
+        }
+
+        int runStart = -1;
+        for (int i = 0; i <= CHUNK_SIZE; i++) {
+            bool open = i < CHUNK_SIZE && !isSolid(chunk, borderTile(direction, i)) && !isSolid(*neighbor, facingTile(direction, i));
+            if (open && runStart < 0) {
+                runStart = i;
+            }
+            else if (!open && runStart >= 0) {
+                int runEnd = i - 1;
+                if (runEnd - runStart + 1 >= PATH_LONG_ENTRANCE) {
+                    addNode(borderTile(direction, runStart), direction);
+                    addNode(borderTile(direction, runEnd), direction);
+                }
+                else {
+                    addNode(borderTile(direction, (runStart + runEnd) / 2), direction);
+                }
+                runStart = -1;
+            }
+        }
+    }
+
+    // Shortest paths inside the chunk between every pair of entrances
+    for (size_t node = 0; node < graph.nodeTiles.size(); node++) {
+        graph.edgeOffsets.push_back(static_cast<int>(graph.edges.size()));
+        searchChunk(chunk, graph.nodeTiles[node], -1);
+        for (size_t other = 0; other < graph.nodeTiles.size(); other++) {
+            std::int32_t cost = localCost[graph.nodeTiles[other]];
+            if (other != node && cost != UNREACHED) {
+                graph.edges.push_back({ static_cast<std::int16_t>(other), cost });
+            }
+        }
+    }
+    graph.edgeOffsets.push_back(static_cast<int>(graph.edges.size()));
+    graph.valid = true;
+}
+
+PathFinder::ChunkGraph* PathFinder::getGraph(const Map& gameMap, ChunkCoord coord, int* slot) {
+    const Chunk* chunk = gameMap.findChunk(coord);
+    if (!chunk) {
+        return nullptr;
+    }
+
+    int graphSlot;
+    auto slotIt = slots.find(coord);
+    if (slotIt != slots.end()) {
+        graphSlot = slotIt->second;
+    }
+    else {
+        if (!freeSlots.empty()) {
+            graphSlot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            graphSlot = static_cast<int>(graphs.size());
+            graphs.push_back(std::make_unique<ChunkGraph>());
+        }
+        slots[coord] = graphSlot;
+        graphs[graphSlot]->coord = coord;
+        graphs[graphSlot]->valid = false;
+    }
+
+    ChunkGraph& graph = *graphs[graphSlot];
+    if (!graph.valid) {
+        buildGraph(gameMap, *chunk, graph);
+    }
+    if (slot) {
+        *slot = graphSlot;
+    }
+    return &graph;
+}
+
+bool PathFinder::findAbstractPath(const Map& gameMap, sf::Vector2i start, sf::Vector2i goal, std::vector<sf::Vector2i>& waypoints) {
+    waypoints.clear();
+    lastExpandedNodes = 0;
+    if (!gameMap.isInWorld(start.x, start.y) || !gameMap.isInWorld(goal.x, goal.y)) {
+        return false;
+    }
+
+    ChunkCoord startChunk = chunkOfTile(start.x, start.y);
+    ChunkCoord goalChunk = chunkOfTile(goal.x, goal.y);
+    int startTile = localTileIndex(start.x, start.y);
+    int goalTile = localTileIndex(goal.x, goal.y);
+
+    int startSlot, goalSlot;
+    const ChunkGraph* startGraph = getGraph(gameMap, startChunk, &startSlot);
+    const ChunkGraph* goalGraph = getGraph(gameMap, goalChunk, &goalSlot);
+    if (!startGraph || !goalGraph ||
+        isSolid(*gameMap.findChunk(startChunk), startTile) || isSolid(*gameMap.findChunk(goalChunk), goalTile)) {
+        return false;
+    }
+    if (start == goal) {
+        waypoints.push_back(start);
+        return true;
+    }
+
+    // Costs from the start to its chunk's entrances (and to the goal when it's in the same
+    // chunk), and from the goal chunk's entrances to the goal
+    searchChunk(*gameMap.findChunk(startChunk), startTile, -1);
+    std::int32_t bestGoalCost = (startSlot == goalSlot) ? localCost[goalTile] : UNREACHED;
+    int bestGoalParent = NO_NODE;
+    startCosts.clear();
+    for (std::uint16_t tile : startGraph->nodeTiles) {
+        startCosts.push_back(localCost[tile]);
+    }
+    searchChunk(*gameMap.findChunk(goalChunk), goalTile, -1);
+    goalCosts.clear();
+    for (std::uint16_t tile : goalGraph->nodeTiles) {
+        goalCosts.push_back(localCost[tile]);
+    }
+
+    if (++searchStamp == 0) {
+        searchNodes.assign(searchNodes.size(), SearchNode());
+        searchStamp = 1;
+    }
+
+    auto nodeTile = [this](int id) {
+        return graphs[id / MAX_CHUNK_NODES]->nodePositions[id % MAX_CHUNK_NODES];
+    };
+
+    auto byCost = std::greater<std::pair<std::int32_t, std::int32_t>>();
+    openHeap.clear();
+    auto relax = [&](int id, std::int32_t cost, int parent) {
+        SearchNode& node = searchNode(id);
+        if (node.closed || cost >= node.cost) {
+            return;
+        }
+        node.cost = cost;
+        node.parent = parent;
+        openHeap.push_back({ cost + octileDistance(nodeTile(id), goal), id });
+        std::push_heap(openHeap.begin(), openHeap.end(), byCost);
+    };
+
+    for (size_t node = 0; node < startCosts.size(); node++) {
+        if (startCosts[node] != UNREACHED) {
+            relax(startSlot * MAX_CHUNK_NODES + static_cast<int>(node), startCosts[node], NO_NODE);
+        }
+    }
+
+    while (!openHeap.empty()) {
+        std::pop_heap(openHeap.begin(), openHeap.end(), byCost);
+        std::int32_t estimate = openHeap.back().first;
+        int id = openHeap.back().second;
+        openHeap.pop_back();
+        if (estimate >= bestGoalCost || lastExpandedNodes >= MAX_PATH_EXPANSIONS) {
+            break;
+        }
+
+        SearchNode& current = searchNode(id);
+        if (current.closed) {
+            continue;
+        }
+        current.closed = true;
+        std::int32_t cost = current.cost;
+        lastExpandedNodes++;
+
+        int slot = id / MAX_CHUNK_NODES;
+        int node = id % MAX_CHUNK_NODES;
+        const ChunkGraph& graph = *graphs[slot];
+
+        if (slot == goalSlot && goalCosts[node] != UNREACHED && cost + goalCosts[node] < bestGoalCost) {
+            bestGoalCost = cost + goalCosts[node];
+            bestGoalParent = id;
+        }
+
+        for (int edge = graph.edgeOffsets[node]; edge < graph.edgeOffsets[node + 1]; edge++) {
+            relax(slot * MAX_CHUNK_NODES + graph.edges[edge].to, cost + graph.edges[edge].cost, id);
+        }
+
+        // Crossing a border is one straight step onto the neighbor's matching entrance
+        for (int direction = 0; direction < 4; direction++) {
+            if (!(graph.nodeExits[node] & (1 << direction))) {
+                continue;
+            }
+            // Unloading a chunk invalidates its neighbors, so a remembered slot stays theirs
+            int neighborSlot = graph.neighborSlots[direction];
+            const ChunkGraph* neighbor = (neighborSlot != NO_NODE && graphs[neighborSlot]->valid) ? graphs[neighborSlot].get() :
+                getGraph(gameMap, { graph.coord.x + DIRECTIONS[direction][0], graph.coord.y + DIRECTIONS[direction][1] }, &neighborSlot);
+            if (!neighbor) {
+                continue;
+            }
+            graphs[slot]->neighborSlots[direction] = neighborSlot;
+            int neighborNode = neighbor->nodeAt[facingTile(direction, borderPosition(direction, graph.nodeTiles[node]))];
+            if (neighborNode != NO_NODE) {
+                relax(neighborSlot * MAX_CHUNK_NODES + neighborNode, cost + STRAIGHT_COST, id);
+            }
+        }
+    }
+
+    if (bestGoalCost == UNREACHED) {
+        return false;
+    }
+
+    // Walk back from the goal; the start and goal may be entrances themselves
+    waypoints.push_back(goal);
+    for (int id = bestGoalParent; id != NO_NODE; id = searchNodes[id].parent) {
+        if (nodeTile(id) != waypoints.back()) {
+            waypoints.push_back(nodeTile(id));
+        }
+    }
+    if (waypoints.back() != start) {
+        waypoints.push_back(start);
+    }
+    std::reverse(waypoints.begin(), waypoints.end());
+    return true;
+}
+
+bool PathFinder::refineSegment(const Map& gameMap, sf::Vector2i from, sf::Vector2i to, std::vector<sf::Vector2i>& tiles) {
+    ChunkCoord fromChunk = chunkOfTile(from.x, from.y);
+    ChunkCoord toChunk = chunkOfTile(to.x, to.y);
+    const Chunk* chunk = gameMap.findChunk(toChunk);
+    if (!chunk || isSolid(*chunk, localTileIndex(to.x, to.y))) {
+        return false;
+    }
+
+    // A border crossing is a single straight step
+    if (!(fromChunk == toChunk)) {
+        if (std::abs(from.x - to.x) + std::abs(from.y - to.y) != 1) {
+            return false;
+        }
+        tiles.push_back(to);
+        return true;
+    }
+
+    int fromTile = localTileIndex(from.x, from.y);
+    int toTile = localTileIndex(to.x, to.y);
+    searchChunk(*chunk, fromTile, toTile);
+    if (localCost[toTile] == UNREACHED) {
+        return false;
+    }
+
+    size_t first = tiles.size();
+    for (int tile = toTile; tile != fromTile; tile = localParent[tile]) {
+        tiles.push_back({ static_cast<int>(toChunk.x * CHUNK_SIZE + tile % CHUNK_SIZE), static_cast<int>(toChunk.y * CHUNK_SIZE + tile / CHUNK_SIZE) });
+    }
+    std::reverse(tiles.begin() + first, tiles.end());
+    return true;
+}
+
+bool PathFinder::findPath(const Map& gameMap, sf::Vector2i start, sf::Vector2i goal, std::vector<sf::Vector2i>& tiles) {
+    tiles.clear();
+    std::vector<sf::Vector2i> waypoints;
+    if (!findAbstractPath(gameMap, start, goal, waypoints)) {
+        return false;
+    }
+    for (size_t i = 0; i + 1 < waypoints.size(); i++) {
+        if (!refineSegment(gameMap, waypoints[i], waypoints[i + 1], tiles)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PathFinder::invalidateAround(ChunkCoord chunk) {
+    auto invalidate = [this](ChunkCoord coord) {
+        auto slotIt = slots.find(coord);
+        if (slotIt != slots.end()) {
+            graphs[slotIt->second]->valid = false;
+        }
+    };
+
+    invalidate(chunk);
+    for (const auto& direction : DIRECTIONS) {
+        invalidate({ chunk.x + direction[0], chunk.y + direction[1] });
+    }
+}
+
+void PathFinder::onChunkUnloaded(ChunkCoord chunk) {
+    invalidateAround(chunk);
+    auto slotIt = slots.find(chunk);
+    if (slotIt != slots.end()) {
+        freeSlots.push_back(slotIt->second);
+        slots.erase(slotIt);
+    }
+}
+
+void PathFinder::clear() {
+    graphs.clear();
+    slots.clear();
+    freeSlots.clear();
+    searchNodes.clear();
+}
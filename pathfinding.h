@@ -0,0 +1,99 @@
+#ifndef PATHFINDING_H
+#define PATHFINDING_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include "constants.h"
+#include "chunk.h"
+#include "utils.h"
+
+class Map; // Forward declaration
+
+// Hierarchical A* (HPA*) over loaded chunks. Wherever two chunks share a stretch of open
+// tiles along their border there is an entrance; each chunk caches a small graph linking
+// its entrance tiles by their shortest path inside the chunk. Queries search that graph,
+// entering from the start chunk and leaving into the goal chunk, and tile paths are only
+// worked out one segment at a time when a caller needs them.
+//
+// Moves are 8-directional without cutting corners, costing 10 straight and 14 diagonal.
+// Unloaded chunks are walls. A solidity change rebuilds only the graphs of that chunk and
+// its four neighbors, and only when next searched.
+class PathFinder {
+public:
+    // Waypoints from start to goal (tile coordinates), each sharing a chunk with the next or
+    // just across a border from it. False if the goal can't be reached through loaded chunks.
+    bool findAbstractPath(const Map& gameMap, sf::Vector2i start, sf::Vector2i goal, std::vector<sf::Vector2i>& waypoints);
+
+    // Tiles after from up to and including to, for two consecutive waypoints. False if
+    // tiles changed since the waypoints were found and the path is blocked.
+    bool refineSegment(const Map& gameMap, sf::Vector2i from, sf::Vector2i to, std::vector<sf::Vector2i>& tiles);
+
+    // Both at once: every tile after start up to and including goal
+    bool findPath(const Map& gameMap, sf::Vector2i start, sf::Vector2i goal, std::vector<sf::Vector2i>& tiles);
+
+    void invalidateAround(ChunkCoord chunk); // Solidity changed in the chunk, or it loaded
+    void onChunkUnloaded(ChunkCoord chunk);
+    void clear();
+
+    size_t getCachedChunks() const { return slots.size(); }
+    int getLastExpandedNodes() const { return lastExpandedNodes; }
+
+private:
+    // Runs on a border are at least one blocked tile apart, and a run gets one entrance, or two
+    // once it is PATH_LONG_ENTRANCE wide, so a border has at most CHUNK_SIZE / 2 entrances
+    static constexpr int MAX_CHUNK_NODES = 4 * (CHUNK_SIZE / 2);
+    static_assert(PATH_LONG_ENTRANCE >= 3, "Two entrances per run must not outnumber one per two tiles");
+    static constexpr int NO_NODE = -1;
+
+    struct IntraEdge {
+        std::int16_t to;
+        std::int32_t cost;
+    };
+
+    // Entrance tiles of one chunk and the costs between them
+    struct ChunkGraph {
+        ChunkCoord coord;
+        bool valid = false;
+        std::vector<std::uint16_t> nodeTiles; // Local tile index (y * CHUNK_SIZE + x)
+        std::vector<sf::Vector2i> nodePositions; // World tile coordinates, for the heuristic
+        std::vector<std::uint8_t> nodeExits;  // Bit per direction the node crosses into
+        std::vector<int> edgeOffsets;         // Edges of node i: [edgeOffsets[i], edgeOffsets[i + 1])
+        std::vector<IntraEdge> edges;
+        std::int16_t nodeAt[CHUNK_SIZE * CHUNK_SIZE];
+        int neighborSlots[4];                 // Looked up on first crossing, NO_NODE until then
+    };
+
+    struct SearchNode {
+        std::uint32_t stamp = 0;
+        std::int32_t cost = 0;
+        std::int32_t parent = NO_NODE; // Search id, or NO_NODE for the start
+        bool closed = false;
+    };
+
+    // Graphs keep their slot while cached, so slot * MAX_CHUNK_NODES + node is a stable search id
+    std::vector<std::unique_ptr<ChunkGraph>> graphs;
+    std::unordered_map<ChunkCoord, int, ChunkCoordHash> slots;
+    std::vector<int> freeSlots;
+
+    std::vector<SearchNode> searchNodes;
+    std::uint32_t searchStamp = 0;
+    int lastExpandedNodes = 0;
+
+    // Scratch for searches inside one chunk
+    std::int32_t localCost[CHUNK_SIZE * CHUNK_SIZE];
+    std::int16_t localParent[CHUNK_SIZE * CHUNK_SIZE];
+    std::vector<std::pair<std::int32_t, std::int16_t>> localHeap;
+    std::vector<std::pair<std::int32_t, std::int32_t>> openHeap;
+    std::vector<std::int32_t> startCosts;
+    std::vector<std::int32_t> goalCosts;
+
+    ChunkGraph* getGraph(const Map& gameMap, ChunkCoord coord, int* slot = nullptr);
+    void buildGraph(const Map& gameMap, const Chunk& chunk, ChunkGraph& graph);
+    void searchChunk(const Chunk& chunk, int fromTile, int toTile); // toTile < 0 searches the whole chunk
+    SearchNode& searchNode(int id);
+};
+
+#endif
@@ -4,7 +4,7 @@
 #include <iostream>
 #include <algorithm>
 
-Player::Player() {
+Player::Player(bool headless) {
     // Initialize inventory - start completely empty
     inventory.resize(INVENTORY_SIZE);
 
@@ -16,6 +16,11 @@ Player::Player() {
 
     // Don't add any test items - start with empty inventory
 
+    if (headless) {
+        useSimpleGraphics = true;
+        return;
+    }
+
     // Try to load player texture
     if (!texture.loadFromFile("textures/player.png")) {
         std::cout << "Could not load player texture, using simple rectangle..." << std::endl;
@@ -39,9 +44,6 @@ Player::Player() {
             sprite.setScale({ scaleX, scaleY });
         }
     }
-
-    // Find a safe spawn position in plains
-    findSafeSpawnPosition();
 }
 
 void Player::initializeCraftingRecipes() {
@@ -64,9 +66,23 @@ void Player::initializeCraftingRecipes() {
     axeRecipe.requiredQuantity = 20;
     axeRecipe.name = "Wooden Axe";
     craftingRecipes.push_back(axeRecipe);
+
+    // Torch recipe
+    CraftingRecipe torchRecipe;
+    torchRecipe.resultItemId = 7; // TORCH
+    torchRecipe.resultQuantity = 4;
+    torchRecipe.requiredItemId = 4; // WOOD
+    torchRecipe.requiredQuantity = 2;
+    torchRecipe.name = "Torch";
+    craftingRecipes.push_back(torchRecipe);
 }
 
 bool Player::addItem(int itemId, int quantity) {
+    return addItemUpTo(itemId, quantity) == quantity;
+}
+
+int Player::addItemUpTo(int itemId, int quantity) {
+    int remaining = quantity;
     int maxStackSize = 64; // Default stack size
     if (itemId == 4) { // Wood item
         maxStackSize = 200;
@@ -75,10 +91,10 @@ bool Player::addItem(int itemId, int quantity) {
     // First try to add to existing stacks
     for (auto& slot : inventory) {
         if (slot.itemId == itemId && slot.quantity < maxStackSize) {
-            int canAdd = std::min(quantity, maxStackSize - slot.quantity);
+            int canAdd = std::min(remaining, maxStackSize - slot.quantity);
             slot.quantity += canAdd;
-            quantity -= canAdd;
-            if (quantity <= 0) return true;
+            remaining -= canAdd;
+            if (remaining <= 0) return quantity;
         }
     }
 
@@ -86,13 +102,13 @@ bool Player::addItem(int itemId, int quantity) {
     for (auto& slot : inventory) {
         if (slot.isEmpty()) {
             slot.itemId = itemId;
-            slot.quantity = std::min(quantity, maxStackSize);
-            quantity -= slot.quantity;
-            if (quantity <= 0) return true;
+            slot.quantity = std::min(remaining, maxStackSize);
+            remaining -= slot.quantity;
+            if (remaining <= 0) return quantity;
         }
     }
 
-    return quantity <= 0; // Return true if all items were added
+    return quantity - remaining;
 }
 
 bool Player::removeItem(int itemId, int quantity) {
@@ -307,7 +323,7 @@ bool Player::canHarvestTile(TileType tileType) const {
     return false;
 }
 
-void Player::findSafeSpawnPosition() {
+void Player::findSafeSpawnPosition(const Map& gameMap) {
     // Start from center and spiral outward to find plains
     int centerX = WORLD_WIDTH / 2;
     int centerY = WORLD_HEIGHT / 2;
@@ -317,14 +333,10 @@ void Player::findSafeSpawnPosition() {
             int x = centerX + static_cast<int>(radius * std::cos(angle * M_PI / 180));
             int y = centerY + static_cast<int>(radius * std::sin(angle * M_PI / 180));
 
-            if (x >= 0 && x < WORLD_WIDTH && y >= 0 && y < WORLD_HEIGHT) {
-                // Check if this position is in plains (grassland)
-                Map tempMap; // Temporary map for biome checking
-                BiomeType biome = tempMap.determineBiome(x, y);
-                TileType tileType = tempMap.generateTileType(x, y);
-
-                if (biome == BiomeType::GRASSLAND && tileType == TileType::GRASS) {
-                    setPosition({ static_cast<float>(x * TILE_SIZE), static_cast<float>(y * TILE_SIZE) });
+            if (gameMap.isInWorld(x, y)) {
+                // Check if this position is open grass in plains (grassland)
+                if (gameMap.getTile(x, y) == TileType::GRASS && gameMap.determineBiome(x, y) == BiomeType::GRASSLAND) {
+                    setPosition({ static_cast<double>(x * TILE_SIZE), static_cast<double>(y * TILE_SIZE) });
                     return;
                 }
             }
@@ -332,28 +344,30 @@ void Player::findSafeSpawnPosition() {
     }
 
     // Fallback to center if no plains found
-    setPosition({ static_cast<float>(WORLD_WIDTH * TILE_SIZE / 2), static_cast<float>(WORLD_HEIGHT * TILE_SIZE / 2) });
+    setPosition({ static_cast<double>(WORLD_WIDTH * TILE_SIZE / 2), static_cast<double>(WORLD_HEIGHT * TILE_SIZE / 2) });
 }
 
 float Player::getCurrentMaxSpeed() const {
     return sprinting ? maxSpeed * sprintMultiplier : maxSpeed;
 }
 
-void Player::setPosition(const sf::Vector2f& position) {
-    if (useSimpleGraphics) {
-        fallbackRect.setPosition(position);
-    }
-    else {
-        sprite.setPosition(position);
-    }
+void Player::setPosition(const WorldVector& newPosition) {
+    position = newPosition;
+}
+
+WorldVector Player::getPosition() const {
+    return position;
 }
 
-sf::Vector2f Player::getPosition() const {
+void Player::draw(sf::RenderWindow& window, sf::Vector2f drawPosition) {
+    // Either sprite or fallback rectangle
     if (useSimpleGraphics) {
-        return fallbackRect.getPosition();
+        fallbackRect.setPosition(drawPosition);
+        window.draw(fallbackRect);
     }
     else {
-        return sprite.getPosition();
+        sprite.setPosition(drawPosition);
+        window.draw(sprite);
     }
 }
 
@@ -388,30 +402,28 @@ void Player::update(float dt, const Map& gameMap) {
     velocity.y += (velocityDiff.y > 0 ? 1 : -1) * std::min(std::abs(velocityDiff.y), changeAmount * dt);
 
     // Movement with collision detection
-    sf::Vector2f originalPos = getPosition();
+    WorldVector originalPos = getPosition();
 
     // Try horizontal movement
-    sf::Vector2f newPos = originalPos + sf::Vector2f{ velocity.x * dt, 0 };
+    WorldVector newPos = originalPos + WorldVector{ velocity.x * dt, 0.0 };
     setPosition(newPos);
 
     // Simple collision check (just check player center)
-    int tileX = static_cast<int>(newPos.x / TILE_SIZE);
-    int tileY = static_cast<int>(newPos.y / TILE_SIZE);
+    sf::Vector2i tile = tileOf(newPos);
 
-    if (gameMap.isTileSolid(tileX, tileY)) {
+    if (gameMap.isTileSolid(tile.x, tile.y)) {
         setPosition({ originalPos.x, newPos.y });
         velocity.x = 0;
     }
 
     // Try vertical movement
-    sf::Vector2f currentPos = getPosition();
-    newPos = currentPos + sf::Vector2f{ 0, velocity.y * dt };
+    WorldVector currentPos = getPosition();
+    newPos = currentPos + WorldVector{ 0.0, velocity.y * dt };
     setPosition(newPos);
 
-    tileX = static_cast<int>(newPos.x / TILE_SIZE);
-    tileY = static_cast<int>(newPos.y / TILE_SIZE);
+    tile = tileOf(newPos);
 
-    if (gameMap.isTileSolid(tileX, tileY)) {
+    if (gameMap.isTileSolid(tile.x, tile.y)) {
         setPosition({ currentPos.x, originalPos.y });
         velocity.y = 0;
     }
@@ -420,11 +432,18 @@ void Player::update(float dt, const Map& gameMap) {
     updateHarvesting(dt, const_cast<Map&>(gameMap));
 
     // World bounds
-    sf::Vector2f pos = getPosition();
-    if (pos.x < 0) setPosition({ 0, pos.y });
-    if (pos.y < 0) setPosition({ pos.x, 0 });
-    if (pos.x > WORLD_WIDTH * TILE_SIZE) setPosition({ static_cast<float>(WORLD_WIDTH * TILE_SIZE), pos.y });
-    if (pos.y > WORLD_HEIGHT * TILE_SIZE) setPosition({ pos.x, static_cast<float>(WORLD_HEIGHT * TILE_SIZE) });
+    WorldVector pos = getPosition();
+    WorldVector minPos = { 0.0, 0.0 };
+    WorldVector maxPos = { static_cast<double>(WORLD_WIDTH * TILE_SIZE), static_cast<double>(WORLD_HEIGHT * TILE_SIZE) };
+    if (gameMap.infinite) {
+        double limit = static_cast<double>(INFINITE_WORLD_LIMIT - MAX_RENDER_DISTANCE * CHUNK_SIZE) * TILE_SIZE;
+        minPos = { -limit, -limit };
+        maxPos = { limit, limit };
+    }
+    if (pos.x < minPos.x) setPosition({ minPos.x, pos.y });
+    if (pos.y < minPos.y) setPosition({ pos.x, minPos.y });
+    if (pos.x > maxPos.x) setPosition({ maxPos.x, pos.y });
+    if (pos.y > maxPos.y) setPosition({ pos.x, maxPos.y });
 }
 
 void Player::setMovement(bool left, bool right, bool up, bool down) {
@@ -438,12 +457,15 @@ void Player::setSprinting(bool isSprinting) {
     sprinting = isSprinting;
 }
 
-sf::Vector2f Player::getWorldPosition() const {
-    sf::Vector2f pos = getPosition();
-    return sf::Vector2f{ pos.x / TILE_SIZE, pos.y / TILE_SIZE };
+WorldVector Player::getWorldPosition() const {
+    return getPosition() / static_cast<double>(TILE_SIZE);
+}
+
+sf::Vector2i Player::getTilePosition() const {
+    return tileOf(getPosition());
 }
 
-void Player::startHarvesting(int worldX, int worldY, sf::Vector2f targetPos, TileType tileType) {
+void Player::startHarvesting(int worldX, int worldY, WorldVector targetPos, TileType tileType) {
     if (isWithinHarvestRange(worldX, worldY) && canHarvestTile(tileType)) {
         isHarvesting = true;
         harvestProgress = 0.0f;
@@ -466,16 +488,60 @@ void Player::stopHarvesting() {
 }
 
 bool Player::isWithinHarvestRange(int worldX, int worldY) const {
-    sf::Vector2f playerWorldPos = getWorldPosition();
-    int playerTileX = static_cast<int>(playerWorldPos.x);
-    int playerTileY = static_cast<int>(playerWorldPos.y);
+    sf::Vector2i playerTile = getTilePosition();
 
-    int distanceX = std::abs(worldX - playerTileX);
-    int distanceY = std::abs(worldY - playerTileY);
+    int distanceX = std::abs(worldX - playerTile.x);
+    int distanceY = std::abs(worldY - playerTile.y);
 
     return (distanceX <= 3 && distanceY <= 3);
 }
 
+bool Player::findHarvestTarget(const Map& gameMap, int& targetX, int& targetY, TileType& targetType) const {
+    sf::Vector2i playerTile = getTilePosition();
+
+    // Harvest range is 3 tiles on each axis, so 5 tiles covers its corners. Tiles outside the
+    // box can be nearer than its corners, so every hit in the disc is kept and filtered below.
+    const int searchRadius = 5;
+    const int maxCandidates = (2 * searchRadius + 1) * (2 * searchRadius + 1);
+    std::vector<ResourceHit> hits;
+    int bestDistance = -1;
+
+    for (TileType type : { TileType::TREE, TileType::STONE }) {
+        if (!canHarvestTile(type)) {
+            continue;
+        }
+
+        gameMap.findNearestResources(type, playerTile.x, playerTile.y, searchRadius, maxCandidates, hits);
+        for (const ResourceHit& hit : hits) {
+            if (bestDistance >= 0 && hit.distanceSquared >= bestDistance) {
+                break;
+            }
+            if (isWithinHarvestRange(hit.worldX, hit.worldY)) {
+                targetX = hit.worldX;
+                targetY = hit.worldY;
+                targetType = type;
+                bestDistance = hit.distanceSquared;
+                break;
+            }
+        }
+    }
+
+    return bestDistance >= 0;
+}
+
+bool Player::startHarvestingNearest(const Map& gameMap) {
+    int targetX = -1;
+    int targetY = -1;
+    TileType targetType = TileType::GRASS;
+
+    if (isHarvesting || !findHarvestTarget(gameMap, targetX, targetY, targetType)) {
+        return false;
+    }
+
+    startHarvesting(targetX, targetY, tileCenter(targetX, targetY), targetType);
+    return isHarvesting;
+}
+
 void Player::updateHarvesting(float dt, Map& gameMap) {
     if (!isHarvesting) return;
 
@@ -493,16 +559,14 @@ void Player::updateHarvesting(float dt, Map& gameMap) {
         // Complete harvesting
         if (harvestTargetType == TileType::TREE) {
             if (gameMap.destroyTree(harvestTargetX, harvestTargetY)) {
-                bool success = addItem(4, 10); // Add 10 wood (item ID 4)
-                std::cout << "Tree harvested! Wood added to inventory: " << (success ? "Success" : "Failed - Inventory Full") << std::endl;
-                std::cout << "Current wood count: " << getItemCount(4) << std::endl;
+                harvestDrops.push_back({ 4, 10, harvestTarget }); // Drop 10 wood (item ID 4)
+                std::cout << "Tree harvested! Dropped 10 wood" << std::endl;
             }
         }
         else if (harvestTargetType == TileType::STONE) {
             if (gameMap.destroyStone(harvestTargetX, harvestTargetY)) {
-                bool success = addItem(2, 5); // Add 5 stone (item ID 2)
-                std::cout << "Stone harvested! Stone added to inventory: " << (success ? "Success" : "Failed - Inventory Full") << std::endl;
-                std::cout << "Current stone count: " << getItemCount(2) << std::endl;
+                harvestDrops.push_back({ 2, 5, harvestTarget }); // Drop 5 stone (item ID 2)
+                std::cout << "Stone harvested! Dropped 5 stone" << std::endl;
             }
         }
         stopHarvesting();
@@ -4,6 +4,7 @@
 #include <SFML/Graphics.hpp>
 #include <vector>
 #include "constants.h"
+#include "worldcoords.h"
 
 class Map; // Forward declaration
 
@@ -15,6 +16,13 @@ struct InventorySlot {
     void clear() { itemId = -1; quantity = 0; }
 };
 
+// Items produced by a finished harvest, to be spawned into the world
+struct ItemDrop {
+    int itemId;
+    int quantity;
+    WorldVector position; // Pixels
+};
+
 struct CraftingRecipe {
     int resultItemId;
     int resultQuantity;
@@ -28,6 +36,7 @@ public:
     sf::Texture texture;
     sf::Sprite sprite = sf::Sprite(texture);
     sf::RectangleShape fallbackRect;  // Fallback rectangle for when texture fails
+    WorldVector position;             // Simulation state; the sprite is only positioned when drawn
     sf::Vector2f velocity;
     float speed = 200.0f;
     float maxSpeed = 200.0f;
@@ -55,27 +64,31 @@ public:
 
     // Harvesting system
     bool isHarvesting = false;
-    sf::Vector2f harvestTarget;
+    WorldVector harvestTarget;
     float harvestProgress = 0.0f;
     float harvestDuration = 5.0f; // 5 seconds base
     int harvestTargetX = -1;
     int harvestTargetY = -1;
     TileType harvestTargetType = TileType::GRASS;
+    std::vector<ItemDrop> harvestDrops; // Collected and spawned by the simulation every tick
 
-    Player();
+    explicit Player(bool headless = false); // Headless skips the texture, for players on a server
 
     void initializeCraftingRecipes();
-    void findSafeSpawnPosition();
+    void findSafeSpawnPosition(const Map& gameMap);
     void update(float dt, const Map& gameMap);
     void setMovement(bool left, bool right, bool up, bool down);
     void setSprinting(bool isSprinting);
 
-    sf::Vector2f getPosition() const;
-    sf::Vector2f getWorldPosition() const;
-    void setPosition(const sf::Vector2f& position);
+    WorldVector getPosition() const;
+    WorldVector getWorldPosition() const; // In tiles
+    sf::Vector2i getTilePosition() const;
+    void setPosition(const WorldVector& newPosition);
+    void draw(sf::RenderWindow& window, sf::Vector2f drawPosition); // Render thread only
 
     // Inventory methods
     bool addItem(int itemId, int quantity = 1);
+    int addItemUpTo(int itemId, int quantity); // Adds as many as fit, returns how many
     bool removeItem(int itemId, int quantity = 1);
     int getItemCount(int itemId) const;
     bool moveItem(int fromSlot, int toSlot); // Move between inventory slots
@@ -95,14 +108,16 @@ public:
     float getHarvestSpeedMultiplier() const;
 
     // Harvesting methods
-    void startHarvesting(int worldX, int worldY, sf::Vector2f targetPos, TileType tileType);
+    void startHarvesting(int worldX, int worldY, WorldVector targetPos, TileType tileType);
     void stopHarvesting();
     void updateHarvesting(float dt, Map& gameMap);
     bool isWithinHarvestRange(int worldX, int worldY) const;
     bool canHarvestTile(TileType tileType) const;
+    bool findHarvestTarget(const Map& gameMap, int& targetX, int& targetY, TileType& targetType) const;
+    bool startHarvestingNearest(const Map& gameMap);
     float getHarvestProgress() const { return harvestProgress / harvestDuration; }
     bool getIsHarvesting() const { return isHarvesting; }
-    sf::Vector2f getHarvestTarget() const { return harvestTarget; }
+    WorldVector getHarvestTarget() const { return harvestTarget; }
 
 private:
     float getCurrentMaxSpeed() const;
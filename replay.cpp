@@ -0,0 +1,85 @@
+// Headless replay: plays a recording made with `--record` through the simulation without a
+// window, as fast as it steps, checks that the world ends up where the recording did, and
+// reports step times. Run it before and after a change on the same recording to compare.
+//
+// Usage: replay RECORDING [--world PATH] [--csv PATH] [--infinite]
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include "constants.h"
+#include "map.h"
+#include "player.h"
+#include "savegame.h"
+#include "simulation.h"
+#include "inputrecord.h"
+
+int main(int argc, char* argv[]) {
+    std::string recordingPath;
+    std::string worldPath = "world.bake";
+    std::string csvPath;
+    bool infinite = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--world" && hasValue) worldPath = argv[++i];
+        else if (arg == "--csv" && hasValue) csvPath = argv[++i];
+        else if (arg == "--infinite") infinite = true;
+        else if (!arg.empty() && arg[0] != '-' && recordingPath.empty()) recordingPath = arg;
+        else {
+            recordingPath.clear();
+            break;
+        }
+    }
+    if (recordingPath.empty()) {
+        std::cout << "Usage: replay RECORDING [--world PATH] [--csv PATH] [--infinite]" << std::endl;
+        return 1;
+    }
+
+    // The same start as the game: world, spawn, then the save the recording began from
+    Map gameMap(true);
+    Player player(true);
+    gameMap.openBakedWorld(worldPath);
+    gameMap.setInfinite(infinite);
+    player.findSafeSpawnPosition(gameMap);
+
+    InputReplay replay;
+    if (!replay.open(recordingPath, gameMap)) {
+        return 1;
+    }
+    replay.prepareStartSave();
+
+    Simulation simulation(gameMap, player, replay.getSavePath());
+    loadGame(replay.getSavePath(), gameMap, player, simulation.exploredChunks);
+    simulation.replay = &replay;
+    simulation.tickRate = replay.getTickRate();
+    simulation.unthrottled = true;
+    gameMap.streamer.setRenderDistance(replay.getRenderDistance());
+
+    auto start = std::chrono::steady_clock::now();
+    simulation.start();
+    while (!simulation.replayFinished) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    simulation.stop();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t ticks = replay.stepMilliseconds.size();
+    std::cout << "Replayed " << ticks << " ticks (" << ticks / simulation.tickRate << " s of play) in " << seconds << " s" << std::endl;
+    printFrameTimes("Simulation step", replay.stepMilliseconds, 1000.0f / simulation.tickRate);
+
+    if (!csvPath.empty()) {
+        std::ofstream csv(csvPath);
+        csv << "tick,step_ms\n";
+        for (size_t i = 0; i < ticks; i++) {
+            csv << i << "," << replay.stepMilliseconds[i] << "\n";
+        }
+    }
+
+    std::cout << "Replay " << (replay.matched() ? "matched the recording" : "diverged from the recording") << std::endl;
+    return replay.matched() ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include "riverfield.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    const float DISTANCE_STEPS = 8.0f; // Stored units per tile
+
+    // The transform runs over the stored cells plus a margin, so centerlines just outside the
+    // region still reach its edge cells
+    const int MARGIN_CELLS = (RIVER_FIELD_MAX_DISTANCE + RIVER_FIELD_CELL - 1) / RIVER_FIELD_CELL + 1;
+    const int GRID = RiverDistanceField::CELLS + 2 * MARGIN_CELLS;
+
+    // The centerline point a cell is nearest to, as far as the transform has found
+    struct NearestPoint {
+        float x = 0.0f;
+        float y = 0.0f;
+        float distanceSquared = std::numeric_limits<float>::infinity();
+    };
+
+    // Working grid cell i spans [(i - MARGIN_CELLS - 1), (i - MARGIN_CELLS)) cells of region tiles
+    float getCellCenter(int cell) {
+        return (cell - MARGIN_CELLS - 0.5f) * RIVER_FIELD_CELL;
+    }
+
+    int getCellOf(float tiles) {
+        return static_cast<int>(std::floor(tiles / RIVER_FIELD_CELL)) + MARGIN_CELLS + 1;
+    }
+
+    RiverPoint getClosestOnSegment(RiverPoint a, RiverPoint b, float x, float y) {
+        float segmentX = b.x - a.x;
+        float segmentY = b.y - a.y;
+        float lengthSquared = segmentX * segmentX + segmentY * segmentY;
+        float t = (lengthSquared > 0.0f) ? ((x - a.x) * segmentX + (y - a.y) * segmentY) / lengthSquared : 0.0f;
+        t = std::max(0.0f, std::min(1.0f, t));
+        return { a.x + segmentX * t, a.y + segmentY * t };
+    }
+}
+
+void RiverDistanceField::build(const std::vector<RiverPolyline>& rivers) {
+    std::vector<NearestPoint> grid(static_cast<size_t>(GRID) * GRID);
+
+    auto offer = [&grid](int cellX, int cellY, RiverPoint point) {
+        if (cellX < 0 || cellX >= GRID || cellY < 0 || cellY >= GRID) {
+            return;
+        }
+        float offsetX = getCellCenter(cellX) - point.x;
+        float offsetY = getCellCenter(cellY) - point.y;
+        NearestPoint& nearest = grid[static_cast<size_t>(cellY) * GRID + cellX];
+        float distanceSquared = offsetX * offsetX + offsetY * offsetY;
+        if (distanceSquared < nearest.distanceSquared) {
+            nearest = { point.x, point.y, distanceSquared };
+        }
+    };
+
+    // Seed the cells along every segment, and their neighbors, with their exact nearest point on it
+    for (const RiverPolyline& river : rivers) {
+        for (size_t i = 0; i + 1 < river.size(); i++) {
+            RiverPoint a = river[i];
+            RiverPoint b = river[i + 1];
+            float length = std::hypot(b.x - a.x, b.y - a.y);
+            int steps = std::max(1, static_cast<int>(std::ceil(length / (RIVER_FIELD_CELL * 0.5f))));
+            for (int step = 0; step <= steps; step++) {
+                float t = static_cast<float>(step) / steps;
+                int cellX = getCellOf(a.x + (b.x - a.x) * t);
+                int cellY = getCellOf(a.y + (b.y - a.y) * t);
+                for (int offsetY = -1; offsetY <= 1; offsetY++) {
+                    for (int offsetX = -1; offsetX <= 1; offsetX++) {
+                        int x = cellX + offsetX;
+                        int y = cellY + offsetY;
+                        offer(x, y, getClosestOnSegment(a, b, getCellCenter(x), getCellCenter(y)));
+                    }
+                }
+            }
+        }
+    }
+
+    // Two sweeps, each passing every cell's nearest point to the neighbors it hasn't visited yet
+    auto propagate = [&grid, &offer](int cellX, int cellY, int fromX, int fromY) {
+        if (fromX < 0 || fromX >= GRID || fromY < 0 || fromY >= GRID) {
+            return;
+        }
+        const NearestPoint& from = grid[static_cast<size_t>(fromY) * GRID + fromX];
+        if (from.distanceSquared != std::numeric_limits<float>::infinity()) {
+            offer(cellX, cellY, { from.x, from.y });
+        }
+    };
+    for (int y = 0; y < GRID; y++) {
+        for (int x = 0; x < GRID; x++) {
+            propagate(x, y, x - 1, y);
+            propagate(x, y, x - 1, y - 1);
+            propagate(x, y, x, y - 1);
+            propagate(x, y, x + 1, y - 1);
+        }
+        for (int x = GRID - 1; x >= 0; x--) {
+            propagate(x, y, x + 1, y);
+        }
+    }
+    for (int y = GRID - 1; y >= 0; y--) {
+        for (int x = GRID - 1; x >= 0; x--) {
+            propagate(x, y, x + 1, y);
+            propagate(x, y, x + 1, y + 1);
+            propagate(x, y, x, y + 1);
+            propagate(x, y, x - 1, y + 1);
+        }
+        for (int x = 0; x < GRID; x++) {
+            propagate(x, y, x - 1, y);
+        }
+    }
+
+    distances.resize(static_cast<size_t>(CELLS) * CELLS);
+    for (int y = 0; y < CELLS; y++) {
+        for (int x = 0; x < CELLS; x++) {
+            const NearestPoint& nearest = grid[static_cast<size_t>(y + MARGIN_CELLS) * GRID + x + MARGIN_CELLS];
+            float distance = std::min(std::sqrt(nearest.distanceSquared), static_cast<float>(RIVER_FIELD_MAX_DISTANCE));
+            distances[static_cast<size_t>(y) * CELLS + x] = static_cast<std::uint8_t>(std::min(255.0f, std::round(distance * DISTANCE_STEPS)));
+        }
+    }
+}
+
+float RiverDistanceField::getDistance(float localX, float localY) const {
+    // Stored cell i is centered (i - 0.5) cells into the region
+    float cellX = localX / RIVER_FIELD_CELL + 0.5f;
+    float cellY = localY / RIVER_FIELD_CELL + 0.5f;
+    int x = std::max(0, std::min(CELLS - 2, static_cast<int>(std::floor(cellX))));
+    int y = std::max(0, std::min(CELLS - 2, static_cast<int>(std::floor(cellY))));
+    float fractionX = std::max(0.0f, std::min(1.0f, cellX - x));
+    float fractionY = std::max(0.0f, std::min(1.0f, cellY - y));
+
+    const std::uint8_t* row = &distances[static_cast<size_t>(y) * CELLS + x];
+    float top = row[0] + (row[1] - row[0]) * fractionX;
+    float bottom = row[CELLS] + (row[CELLS + 1] - row[CELLS]) * fractionX;
+    return (top + (bottom - top) * fractionY) / DISTANCE_STEPS;
+}
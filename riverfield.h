@@ -0,0 +1,36 @@
+#ifndef RIVERFIELD_H
+#define RIVERFIELD_H
+
+#include <vector>
+#include <cstdint>
+#include "constants.h"
+
+// A point on a river centerline, in tiles from its region's top-left corner
+struct RiverPoint {
+    float x;
+    float y;
+};
+
+using RiverPolyline = std::vector<RiverPoint>;
+
+// Distance from one RIVER_REGION_TILES square region to the nearest river centerline, on a
+// grid of RIVER_FIELD_CELL tile cells plus one cell of border, so a lookup anywhere in the
+// region interpolates between four cells of its own. Built once per region by a two-pass
+// distance transform: cells along the centerlines get their exact nearest point, and two
+// sweeps pass those points on to the rest of the grid. Distances are capped at
+// RIVER_FIELD_MAX_DISTANCE, and stored in eighths of a tile.
+class RiverDistanceField {
+public:
+    static const int CELLS = RIVER_REGION_TILES / RIVER_FIELD_CELL + 2;
+
+    // Centerlines in region tiles; those within RIVER_FIELD_MAX_DISTANCE outside the region count too
+    void build(const std::vector<RiverPolyline>& rivers);
+
+    // Bilinear lookup at a position in region tiles, inside the region
+    float getDistance(float localX, float localY) const;
+
+private:
+    std::vector<std::uint8_t> distances; // CELLS * CELLS, row-major
+};
+
+#endif
@@ -0,0 +1,312 @@
+#include "savegame.h"
+#include "map.h"
+#include "jobsystem.h"
+#include <fstream>
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+    // Little-endian binary writer/reader over a byte buffer
+    class SaveWriter {
+    public:
+        std::vector<char> buffer;
+
+        template<typename T> void write(T value) {
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+        }
+    };
+
+    class SaveReader {
+    public:
+        SaveReader(const std::vector<char>& data) : buffer(data) {}
+
+        template<typename T> bool read(T& value) {
+            if (position + sizeof(T) > buffer.size()) {
+                return false;
+            }
+            std::memcpy(&value, buffer.data() + position, sizeof(T));
+            position += sizeof(T);
+            return true;
+        }
+
+        bool atEnd() const { return position == buffer.size(); }
+        size_t remaining() const { return buffer.size() - position; }
+
+    private:
+        const std::vector<char>& buffer;
+        size_t position = 0;
+    };
+
+    void writeSlots(SaveWriter& writer, const std::vector<InventorySlot>& slots) {
+        writer.write<std::uint32_t>(static_cast<std::uint32_t>(slots.size()));
+        for (const InventorySlot& slot : slots) {
+            writer.write<std::int32_t>(slot.itemId);
+            writer.write<std::int32_t>(slot.quantity);
+        }
+    }
+
+    bool readSlots(SaveReader& reader, std::vector<InventorySlot>& slots) {
+        std::uint32_t count;
+        if (!reader.read(count) || count > 10000) {
+            return false;
+        }
+        slots.resize(count);
+        for (InventorySlot& slot : slots) {
+            std::int32_t itemId, quantity;
+            if (!reader.read(itemId) || !reader.read(quantity)) {
+                return false;
+            }
+            slot.itemId = itemId;
+            slot.quantity = quantity;
+        }
+        return true;
+    }
+
+    bool readCoord(SaveReader& reader, ChunkCoord& coord) {
+        return reader.read(coord.x) && reader.read(coord.y);
+    }
+}
+
+SaveSnapshot captureSnapshot(const Map& gameMap, const Player& player, const ExploredChunks& exploredChunks) {
+    SaveSnapshot snapshot;
+    snapshot.seed = gameMap.generator.getSeed();
+    snapshot.playerPosition = player.getPosition();
+    snapshot.selectedHotbarSlot = player.selectedHotbarSlot;
+    snapshot.inventory = player.getInventory();
+    snapshot.toolSlots = player.getToolSlots();
+
+    snapshot.exploredChunks.reserve(exploredChunks.size());
+    for (const auto& explored : exploredChunks) {
+        snapshot.exploredChunks.push_back(explored.first);
+    }
+
+    snapshot.edits = gameMap.snapshotEdits();
+    return snapshot;
+}
+
+bool writeSave(const std::string& path, const SaveSnapshot& snapshot) {
+    SaveWriter writer;
+    writer.buffer.reserve(4096 + snapshot.exploredChunks.size() * 16);
+
+    writer.buffer.insert(writer.buffer.end(), SAVE_MAGIC, SAVE_MAGIC + 4);
+    writer.write<std::uint32_t>(SAVE_VERSION);
+    writer.write<std::uint32_t>(snapshot.seed);
+    writer.write<std::uint32_t>(snapshot.chunkSize);
+
+    writer.write<double>(snapshot.playerPosition.x);
+    writer.write<double>(snapshot.playerPosition.y);
+    writer.write<std::int32_t>(snapshot.selectedHotbarSlot);
+    writeSlots(writer, snapshot.inventory);
+    writeSlots(writer, snapshot.toolSlots);
+
+    writer.write<std::uint32_t>(static_cast<std::uint32_t>(snapshot.exploredChunks.size()));
+    for (const ChunkCoord& coord : snapshot.exploredChunks) {
+        writer.write<std::int64_t>(coord.x);
+        writer.write<std::int64_t>(coord.y);
+    }
+
+    std::uint32_t editedChunks = snapshot.edits ? static_cast<std::uint32_t>(snapshot.edits->chunks.size()) : 0;
+    writer.write<std::uint32_t>(editedChunks);
+    if (snapshot.edits) {
+        for (const auto& chunkPair : snapshot.edits->chunks) {
+            writer.write<std::int64_t>(chunkPair.first.x);
+            writer.write<std::int64_t>(chunkPair.first.y);
+            writer.write<std::uint32_t>(static_cast<std::uint32_t>(chunkPair.second->size()));
+            for (const auto& edit : *chunkPair.second) {
+                writer.write<std::uint16_t>(static_cast<std::uint16_t>(edit.first));
+                writer.write<std::uint8_t>(static_cast<std::uint8_t>(edit.second));
+            }
+        }
+    }
+
+    // Write to a temporary file and swap it in, so a crash mid-write never corrupts the save
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file.write(writer.buffer.data(), writer.buffer.size());
+        if (!file) {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+bool readSave(const std::string& path, SaveSnapshot& snapshot, std::shared_ptr<WorldEdits>& edits) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(data.data(), data.size())) {
+        return false;
+    }
+
+    SaveReader reader(data);
+    char magic[4];
+    std::uint32_t version;
+    for (char& c : magic) {
+        if (!reader.read(c)) return false;
+    }
+    if (std::memcmp(magic, SAVE_MAGIC, 4) != 0 || !reader.read(version) || version < 1 || version > SAVE_VERSION) {
+        std::cout << "Save file " << path << " has an unknown format or version" << std::endl;
+        return false;
+    }
+
+    // Edits only make sense on the terrain they were made on, which older generators don't produce
+    if (version < SAVE_OLDEST_VERSION) {
+        std::cout << "Save file " << path << " is from an older world generator (version " << version
+            << "); not loading" << std::endl;
+        return false;
+    }
+
+    std::int32_t hotbarSlot;
+    if (!reader.read(snapshot.seed) || !reader.read(snapshot.chunkSize) ||
+        !reader.read(snapshot.playerPosition.x) || !reader.read(snapshot.playerPosition.y) ||
+        !reader.read(hotbarSlot) ||
+        !readSlots(reader, snapshot.inventory) || !readSlots(reader, snapshot.toolSlots)) {
+        return false;
+    }
+    snapshot.selectedHotbarSlot = hotbarSlot;
+
+    // Counts are checked against what's left of the file before anything is allocated for them
+    std::uint32_t exploredCount;
+    if (!reader.read(exploredCount) || exploredCount > reader.remaining() / (2 * sizeof(std::int64_t))) return false;
+    snapshot.exploredChunks.resize(exploredCount);
+    for (ChunkCoord& coord : snapshot.exploredChunks) {
+        if (!readCoord(reader, coord)) return false;
+    }
+
+    edits = std::make_shared<WorldEdits>();
+    std::uint32_t editedChunks;
+    if (!reader.read(editedChunks)) return false;
+    for (std::uint32_t i = 0; i < editedChunks; i++) {
+        ChunkCoord coord;
+        std::uint32_t editCount;
+        if (!readCoord(reader, coord) || !reader.read(editCount) ||
+            editCount > reader.remaining() / (sizeof(std::uint16_t) + sizeof(std::uint8_t))) return false;
+
+        auto chunkEdits = std::make_shared<ChunkEdits>();
+        chunkEdits->reserve(editCount);
+        for (std::uint32_t e = 0; e < editCount; e++) {
+            std::uint16_t index;
+            std::uint8_t type;
+            if (!reader.read(index) || !reader.read(type) || index >= snapshot.chunkSize * snapshot.chunkSize ||
+                type > static_cast<std::uint8_t>(TileType::TORCH)) return false;
+            (*chunkEdits)[index] = static_cast<TileType>(type);
+        }
+        edits->chunks[coord] = std::move(chunkEdits);
+    }
+
+    return reader.atEnd();
+}
+
+bool loadGame(const std::string& path, Map& gameMap, Player& player, ExploredChunks& exploredChunks) {
+    auto start = std::chrono::steady_clock::now();
+
+    SaveSnapshot snapshot;
+    std::shared_ptr<WorldEdits> edits;
+    if (!readSave(path, snapshot, edits)) {
+        return false;
+    }
+
+    if (snapshot.seed != gameMap.generator.getSeed()) {
+        std::cout << "Save was made with seed " << snapshot.seed << " but the world uses seed "
+            << gameMap.generator.getSeed() << "; not loading" << std::endl;
+        return false;
+    }
+    if (snapshot.chunkSize != CHUNK_SIZE) {
+        std::cout << "Save was made with " << snapshot.chunkSize << "-tile chunks but this build uses "
+            << CHUNK_SIZE << "; not loading" << std::endl;
+        return false;
+    }
+
+    gameMap.restoreEdits(std::move(edits));
+
+    player.stopHarvesting();
+    player.velocity = { 0.0f, 0.0f };
+    player.setPosition(snapshot.playerPosition);
+    player.selectedHotbarSlot = std::clamp(snapshot.selectedHotbarSlot, 0, Player::HOTBAR_SIZE - 1);
+    if (snapshot.inventory.size() == player.inventory.size()) {
+        player.inventory = std::move(snapshot.inventory);
+    }
+    if (snapshot.toolSlots.size() == player.toolSlots.size()) {
+        player.toolSlots = std::move(snapshot.toolSlots);
+    }
+
+    exploredChunks.clear();
+    for (const ChunkCoord& coord : snapshot.exploredChunks) {
+        exploredChunks[coord] = true;
+    }
+
+    float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Loaded " << path << " in " << milliseconds << " ms" << std::endl;
+    return true;
+}
+
+AutoSaver::AutoSaver(std::string savePath) : path(std::move(savePath)) {
+}
+
+AutoSaver::~AutoSaver() {
+    wait();
+}
+
+void AutoSaver::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return !writing; });
+}
+
+void AutoSaver::submit(SaveSnapshot snapshot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending = std::move(snapshot);
+
+    // The running job picks up the new snapshot when it finishes its current write
+    if (!writing) {
+        writing = true;
+        getJobSystem().submit([this] { writePending(); });
+    }
+}
+
+bool AutoSaver::isBusy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return writing;
+}
+
+void AutoSaver::writePending() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (pending) {
+        SaveSnapshot snapshot = std::move(*pending);
+        pending.reset();
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        bool success = writeSave(path, snapshot);
+        lastWriteMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (success) {
+            savesWritten++;
+        }
+        else {
+            saveFailures++;
+            std::cout << "Autosave to " << path << " failed" << std::endl;
+        }
+
+        // Release the shared edits before the simulation's next edit so it can skip the copy
+        snapshot = SaveSnapshot();
+
+        lock.lock();
+    }
+
+    writing = false;
+    idle.notify_all();
+}
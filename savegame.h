@@ -0,0 +1,67 @@
+#ifndef SAVEGAME_H
+#define SAVEGAME_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <atomic>
+#include <cstdint>
+#include "constants.h"
+#include "chunk.h"
+#include "utils.h"
+#include "player.h"
+#include "worldedits.h"
+
+class Map;
+
+const char SAVE_MAGIC[4] = { 'S', 'A', 'E', 'S' };
+const std::uint32_t SAVE_VERSION = 4; // 2: double player position, 64-bit chunk coordinates; 3: chunk size; 4: traced rivers
+const std::uint32_t SAVE_OLDEST_VERSION = 4; // Older saves hold edits to terrain the generator no longer makes
+
+// Everything needed to write a save, captured on the simulation thread. World edits are
+// shared copy-on-write with Map, so capturing does not copy them.
+struct SaveSnapshot {
+    std::uint32_t seed = 0;
+    std::uint32_t chunkSize = CHUNK_SIZE; // Edits are stored per chunk, by local tile index
+    WorldVector playerPosition;
+    int selectedHotbarSlot = 0;
+    std::vector<InventorySlot> inventory;
+    std::vector<InventorySlot> toolSlots;
+    std::vector<ChunkCoord> exploredChunks;
+    std::shared_ptr<const WorldEdits> edits;
+};
+
+SaveSnapshot captureSnapshot(const Map& gameMap, const Player& player, const ExploredChunks& exploredChunks);
+bool writeSave(const std::string& path, const SaveSnapshot& snapshot);
+bool readSave(const std::string& path, SaveSnapshot& snapshot, std::shared_ptr<WorldEdits>& edits);
+bool loadGame(const std::string& path, Map& gameMap, Player& player, ExploredChunks& exploredChunks);
+
+// Serializes and writes snapshots as a job on the job system. Submitting while a write is
+// in progress replaces any snapshot still waiting, so only the newest one is written.
+class AutoSaver {
+public:
+    explicit AutoSaver(std::string savePath);
+    ~AutoSaver(); // Waits for pending snapshots to be written
+
+    void submit(SaveSnapshot snapshot);
+    bool isBusy() const;
+    void wait(); // Until everything submitted is written
+
+    std::atomic<long long> savesWritten{ 0 };
+    std::atomic<long long> saveFailures{ 0 };
+    std::atomic<float> lastWriteMilliseconds{ 0.0f };
+
+private:
+    std::string path;
+    mutable std::mutex mutex;
+    std::condition_variable idle;
+    std::optional<SaveSnapshot> pending;
+    bool writing = false; // A write job is queued or running
+
+    void writePending();
+};
+
+#endif
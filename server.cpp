@@ -0,0 +1,60 @@
+// Headless server: owns the world and its edits, simulates every connected player and streams
+// chunks and tile changes to them. Stops cleanly (saving the world) on Ctrl+C.
+//
+// Usage: server [--port N] [--world PATH] [--save PATH]
+
+#include <iostream>
+#include <string>
+#include <csignal>
+#include <cstdlib>
+
+#include "constants.h"
+#include "map.h"
+#include "gameserver.h"
+
+namespace {
+    GameServer* activeServer = nullptr;
+
+    void onInterrupt(int) {
+        if (activeServer) {
+            activeServer->running = false;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    unsigned short port = SERVER_PORT;
+    std::string worldPath = "world.bake";
+    std::string savePath = "server.dat";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--port" && hasValue) port = static_cast<unsigned short>(std::atoi(argv[++i]));
+        else if (arg == "--world" && hasValue) worldPath = argv[++i];
+        else if (arg == "--save" && hasValue) savePath = argv[++i];
+        else {
+            std::cout << "Usage: server [--port N] [--world PATH] [--save PATH]" << std::endl;
+            return 1;
+        }
+    }
+
+    Map gameMap(true);
+    gameMap.openBakedWorld(worldPath);
+
+    GameServer server(gameMap, port, savePath);
+    if (!server.listen()) {
+        return 1;
+    }
+
+    activeServer = &server;
+    std::signal(SIGINT, onInterrupt);
+    std::signal(SIGTERM, onInterrupt);
+
+    server.running = true;
+    server.run();
+
+    std::cout << "Server stopped after " << server.stats.ticks << " ticks, sent " << server.stats.bytesSent / 1024
+        << " KB, received " << server.stats.bytesReceived / 1024 << " KB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,431 @@
+#include "simulation.h"
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+Simulation::Simulation(Map& map, Player& gamePlayer, const std::string& savePath)
+    : gameMap(map), player(gamePlayer), path(savePath), autoSaver(savePath) {
+}
+
+Simulation::~Simulation() {
+    stop();
+}
+
+void Simulation::start() {
+    if (running) {
+        return;
+    }
+
+    // Which chunks load each tick is part of the recorded state, so it can't depend on the machine
+    gameMap.streamer.hostIndependent = recorder || replay;
+
+    // The render thread needs a complete frame before the first tick finishes
+    float dt = 0.0f;
+    takeCommands(dt);
+    for (const InputCommand& command : tickCommands) {
+        applyCommand(command);
+    }
+    markExplored();
+    publishFrame(0.0f);
+
+    running = true;
+    thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop() {
+    if (!running) {
+        return;
+    }
+
+    running = false;
+    thread.join();
+
+    std::uint64_t finalHash = (recorder || replay) ? hashGameState(gameMap, player, entities, itemDrops) : 0;
+    if (recorder) {
+        recorder->close(tick, finalHash);
+    }
+    if (replay) {
+        replay->verifyEnd(tick, finalHash);
+        return;
+    }
+
+    // AutoSaver's destructor waits for this to reach disk
+    autoSaver.submit(captureSnapshot(gameMap, player, exploredChunks));
+}
+
+void Simulation::run() {
+    using clock = std::chrono::steady_clock;
+    const clock::duration tickLength = std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(1.0f / tickRate));
+
+    clock::time_point lastTick = clock::now();
+    clock::time_point nextTick = lastTick + tickLength;
+
+    while (running && !replayFinished) {
+        clock::time_point now = clock::now();
+        float dt = std::chrono::duration<float>(now - lastTick).count();
+        lastTick = now;
+
+        step(dt);
+        if (unthrottled) {
+            continue;
+        }
+
+        // After a long step, start counting again from now instead of running a burst of catch-up ticks
+        nextTick += tickLength;
+        if (nextTick < clock::now()) {
+            nextTick = clock::now() + tickLength;
+        }
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+void Simulation::step(float dt) {
+    auto start = std::chrono::steady_clock::now();
+
+    if (!takeCommands(dt)) {
+        replayFinished = true;
+        return;
+    }
+    for (const InputCommand& command : tickCommands) {
+        applyCommand(command);
+    }
+
+    // The player is paused while a menu is open, as are the chunks around them
+    if (!(movementFlags & INPUT_MENU_OPEN)) {
+        followPath();
+        player.update(dt, gameMap);
+
+        // Chunk management (limited per tick)
+        gameMap.loadChunksAroundPlayer(player.getPosition(), player.velocity);
+        gameMap.unloadDistantChunks(player.getPosition(), player.velocity);
+
+        // Nothing regrows on the tile the player stands on
+        WorldVector tileSize{ static_cast<double>(TILE_SIZE), static_cast<double>(TILE_SIZE) };
+        gameMap.tickWorld(tick, { WorldRect(player.getPosition() - tileSize / 2.0, tileSize) });
+        if (tick % WATER_STEP_TICKS == 0) {
+            gameMap.stepWater();
+        }
+        gameMap.updateLighting();
+
+        // Mobs near the player chase them along one shared field
+        gameMap.flowField.update(gameMap, player.getTilePosition());
+
+        spawnMobs();
+        entities.update(dt, gameMap, &gameMap.flowField);
+
+        // Harvests drop their items into the world; they reach the inventory by walking over them
+        for (const ItemDrop& drop : player.harvestDrops) {
+            itemDrops.drop(drop.itemId, drop.quantity, drop.position);
+        }
+        player.harvestDrops.clear();
+        itemDrops.pickUp(player);
+    }
+
+    markExplored();
+
+    // Snapshotting is cheap (edits are shared copy-on-write); the write happens on the saver's thread
+    autosaveElapsed += dt;
+    if (!replay && autosaveElapsed >= AUTOSAVE_INTERVAL && !autoSaver.isBusy()) {
+        autoSaver.submit(captureSnapshot(gameMap, player, exploredChunks));
+        autosaveElapsed = 0.0f;
+    }
+
+    float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    publishFrame(milliseconds);
+
+    if (tick % RECORDING_CHECK_TICKS == 0 && (recorder || replay)) {
+        std::uint64_t hash = hashGameState(gameMap, player, entities, itemDrops);
+        if (recorder) {
+            recorder->recordChecksum(tick, hash);
+        }
+        if (replay) {
+            replay->verify(tick, hash);
+        }
+    }
+    if (replay) {
+        replay->stepMilliseconds.push_back(milliseconds);
+    }
+    tick++;
+}
+
+bool Simulation::takeCommands(float& dt) {
+    tickCommands.clear();
+    InputCommand command;
+    if (replay) {
+        while (input.pop(command)) {
+        }
+        return replay->readTick(dt, tickCommands);
+    }
+
+    while (input.pop(command)) {
+        tickCommands.push_back(command);
+    }
+    if (recorder) {
+        // A load reads whatever the saver last wrote, so it has to be finished, and the file goes in the recording
+        for (const InputCommand& loadCommand : tickCommands) {
+            if (loadCommand.type == InputCommandType::LOAD) {
+                autoSaver.wait();
+                recorder->recordLoad(path);
+                break;
+            }
+        }
+        recorder->recordTick(dt, tickCommands);
+    }
+    return true;
+}
+
+void Simulation::applyCommand(const InputCommand& command) {
+    switch (command.type) {
+    case InputCommandType::MOVEMENT: {
+        movementFlags = command.flags;
+        bool menuOpen = (command.flags & INPUT_MENU_OPEN) != 0;
+        bool left = !menuOpen && (command.flags & INPUT_LEFT);
+        bool right = !menuOpen && (command.flags & INPUT_RIGHT);
+        bool up = !menuOpen && (command.flags & INPUT_UP);
+        bool down = !menuOpen && (command.flags & INPUT_DOWN);
+
+        // Stop harvesting if player tries to move
+        if ((left || right || up || down) && player.getIsHarvesting()) {
+            player.stopHarvesting();
+        }
+
+        // Walking by hand cancels click-to-move
+        if (left || right || up || down) {
+            moveWaypoints.clear();
+        }
+
+        player.setMovement(left, right, up, down);
+        player.setSprinting(!menuOpen && (command.flags & INPUT_SPRINT));
+        break;
+    }
+    case InputCommandType::HARVEST_TILE: {
+        int tileX = command.a;
+        int tileY = command.b;
+
+        // Check if it's a harvestable tile and within range
+        if (gameMap.isInWorld(tileX, tileY) && !player.getIsHarvesting()) {
+            TileType tileType = gameMap.getTile(tileX, tileY);
+            if (player.canHarvestTile(tileType) && player.isWithinHarvestRange(tileX, tileY)) {
+                player.startHarvesting(tileX, tileY, tileCenter(tileX, tileY), tileType);
+            }
+        }
+        break;
+    }
+    case InputCommandType::HARVEST_NEAREST:
+        player.startHarvestingNearest(gameMap);
+        break;
+    case InputCommandType::MOVE_TO:
+        moveTo({ command.a, command.b });
+        break;
+    case InputCommandType::PLACE_TORCH:
+        if (player.getItemCount(7) > 0 && player.isWithinHarvestRange(command.a, command.b) && // Torch
+            gameMap.placeTorch(command.a, command.b)) {
+            player.removeItem(7, 1);
+        }
+        break;
+    case InputCommandType::MOVE_ITEM:
+        player.moveItem(command.a, command.b);
+        break;
+    case InputCommandType::MOVE_ITEM_TO_TOOL:
+        player.moveItemToTool(command.a, command.b);
+        break;
+    case InputCommandType::MOVE_ITEM_FROM_TOOL:
+        player.moveItemFromTool(command.a, command.b);
+        break;
+    case InputCommandType::CRAFT: {
+        const auto& recipes = player.getCraftingRecipes();
+        if (command.a >= 0 && command.a < static_cast<int>(recipes.size())) {
+            player.craft(recipes[command.a]);
+        }
+        break;
+    }
+    case InputCommandType::SET_VIEW:
+        viewSize = command.viewSize;
+        if (command.a != exploredHalfWidth || command.b != exploredHalfHeight) {
+            exploredHalfWidth = command.a;
+            exploredHalfHeight = command.b;
+            exploredMapDirty = true;
+        }
+        break;
+    case InputCommandType::SAVE:
+        if (replay) {
+            break;
+        }
+        autoSaver.submit(captureSnapshot(gameMap, player, exploredChunks));
+        autosaveElapsed = 0.0f;
+        break;
+    case InputCommandType::LOAD:
+        // A save still being written is the one the player expects to load
+        autoSaver.wait();
+        if (loadGame(path, gameMap, player, exploredChunks)) {
+            itemDrops.clear();
+            moveWaypoints.clear();
+            exploredMapDirty = true;
+        }
+        break;
+    }
+}
+
+void Simulation::moveTo(sf::Vector2i goal) {
+    sf::Vector2i start = player.getTilePosition();
+
+    moveWaypointIndex = 0;
+    moveTiles.clear();
+    moveTileIndex = 0;
+    if (!gameMap.pathFinder.findAbstractPath(gameMap, start, goal, moveWaypoints)) {
+        std::cout << "No path to (" << goal.x << ", " << goal.y << ")" << std::endl;
+    }
+}
+
+void Simulation::followPath() {
+    if (moveWaypoints.empty()) {
+        return;
+    }
+
+    // Work out the tiles to the next waypoint once the last ones are walked
+    if (moveTileIndex >= moveTiles.size()) {
+        if (moveWaypointIndex + 1 >= moveWaypoints.size()) {
+            moveWaypoints.clear();
+            player.setMovement(false, false, false, false);
+            return;
+        }
+
+        moveTiles.clear();
+        moveTileIndex = 0;
+        if (!gameMap.pathFinder.refineSegment(gameMap, moveWaypoints[moveWaypointIndex], moveWaypoints[moveWaypointIndex + 1], moveTiles)) {
+            // The world changed under the path; plan again from here
+            moveTo(moveWaypoints.back());
+            return;
+        }
+        moveWaypointIndex++;
+    }
+
+    // Steer toward the center of the next tile with the same controls as the keyboard
+    sf::Vector2i tile = moveTiles[moveTileIndex];
+    WorldVector offset = tileCenter(tile.x, tile.y) - player.getPosition();
+    if (std::abs(offset.x) < PATH_ARRIVE_DISTANCE && std::abs(offset.y) < PATH_ARRIVE_DISTANCE) {
+        moveTileIndex++;
+    }
+
+    double deadZone = PATH_ARRIVE_DISTANCE / 2.0;
+    player.setMovement(offset.x < -deadZone, offset.x > deadZone, offset.y < -deadZone, offset.y > deadZone);
+}
+
+void Simulation::spawnMobs() {
+    if (entities.size() >= MAX_MOBS) {
+        return;
+    }
+
+    // One attempt per tick: a random grass tile in a loaded chunk around the player
+    sf::Vector2i playerTile = player.getTilePosition();
+    int range = gameMap.streamer.getRenderDistance() * CHUNK_SIZE;
+    std::uniform_int_distribution<int> offset(-range, range);
+    int tileX = playerTile.x + offset(spawnRng);
+    int tileY = playerTile.y + offset(spawnRng);
+    if (!gameMap.isInWorld(tileX, tileY)) {
+        return;
+    }
+
+    const Chunk* chunk = gameMap.findChunk(chunkOfTile(tileX, tileY));
+    if (!chunk || chunk->tileTypes[floorMod(tileY, CHUNK_SIZE)][floorMod(tileX, CHUNK_SIZE)] != TileType::GRASS) {
+        return;
+    }
+
+    WorldVector spawnPos = tileCenter(tileX, tileY);
+    entities.spawn(spawnPos.x, spawnPos.y, EntitySprite::CRITTER);
+}
+
+void Simulation::markExplored() {
+    ChunkCoord currentChunk = chunkOf(player.getPosition());
+
+    if (exploredChunks.emplace(currentChunk, true).second) {
+        exploredMapDirty = true;
+    }
+
+    std::int64_t originX = currentChunk.x - exploredHalfWidth;
+    std::int64_t originY = currentChunk.y - exploredHalfHeight;
+    if (originX != exploredMap.originChunkX || originY != exploredMap.originChunkY) {
+        exploredMapDirty = true;
+    }
+}
+
+void Simulation::updateExploredMap() {
+    ChunkCoord playerChunk = chunkOf(player.getPosition());
+    exploredMap.originChunkX = playerChunk.x - exploredHalfWidth;
+    exploredMap.originChunkY = playerChunk.y - exploredHalfHeight;
+    exploredMap.width = exploredHalfWidth * 2 + 1;
+    exploredMap.height = exploredHalfHeight * 2 + 1;
+    exploredMap.cells.assign(static_cast<size_t>(exploredMap.width) * exploredMap.height, UNEXPLORED_CELL);
+
+    for (int y = 0; y < exploredMap.height; y++) {
+        for (int x = 0; x < exploredMap.width; x++) {
+            ChunkCoord chunk = { exploredMap.originChunkX + x, exploredMap.originChunkY + y };
+            if (!gameMap.isChunkInWorld(chunk) || exploredChunks.find(chunk) == exploredChunks.end()) {
+                continue;
+            }
+
+            // Sample the tile at the center of the chunk
+            TileType tileType = gameMap.getTile(static_cast<int>(chunk.x * CHUNK_SIZE + CHUNK_SIZE / 2), static_cast<int>(chunk.y * CHUNK_SIZE + CHUNK_SIZE / 2));
+            exploredMap.cells[y * exploredMap.width + x] = static_cast<std::uint8_t>(tileType);
+        }
+    }
+
+    exploredMapDirty = false;
+}
+
+void Simulation::publishFrame(float stepMilliseconds) {
+    // Edits can change a chunk's center tile, so refresh at least once a second regardless
+    if (exploredMapDirty || tick % static_cast<long long>(tickRate) == 0) {
+        updateExploredMap();
+    }
+
+    FrameSnapshot& frame = frames.writeSlot();
+    frame.tick = tick;
+    frame.timeOfDay = static_cast<float>(std::fmod(static_cast<double>(tick) / DAY_LENGTH_TICKS + DAY_START_TIME, 1.0));
+    frame.stepMilliseconds = stepMilliseconds;
+    frame.flowFieldMilliseconds = gameMap.flowField.getLastRecomputeMilliseconds();
+
+    PlayerView& view = frame.player;
+    view.position = player.getPosition();
+    view.sprinting = player.sprinting;
+    view.selectedHotbarSlot = player.selectedHotbarSlot;
+    view.inventory = player.getInventory();
+    view.toolSlots = player.getToolSlots();
+    view.craftingRecipes = &player.getCraftingRecipes();
+    view.isHarvesting = player.getIsHarvesting();
+    view.harvestProgress = player.getHarvestProgress();
+    view.harvestTargetType = player.harvestTargetType;
+
+    TileType targetType = TileType::GRASS;
+    view.hasHarvestHighlight = !player.getIsHarvesting() &&
+        player.findHarvestTarget(gameMap, view.harvestHighlightX, view.harvestHighlightY, targetType);
+
+    // Everything in the frame is placed relative to an origin near the player
+    renderOrigin.follow(player.getPosition());
+    frame.origin = renderOrigin;
+
+    // Visible chunks for the renderer; the same range drives the streaming metrics
+    int startX, startY, endX, endY;
+    Map::getVisibleTileRange(player.getPosition(), viewSize, startX, startY, endX, endY);
+    gameMap.clampTileRange(startX, startY, endX, endY);
+    int startChunkX = floorDiv(startX, CHUNK_SIZE);
+    int startChunkY = floorDiv(startY, CHUNK_SIZE);
+    int endChunkX = floorDiv(endX - 1, CHUNK_SIZE);
+    int endChunkY = floorDiv(endY - 1, CHUNK_SIZE);
+    gameMap.streamer.recordVisibility(gameMap, startChunkX, startChunkY, endChunkX, endChunkY);
+    gameMap.collectChunkMeshes(startChunkX, startChunkY, endChunkX, endChunkY, frame.visibleChunks);
+
+    WorldVector halfView = WorldVector(viewSize) / 2.0;
+    WorldRect viewArea(player.getPosition() - halfView, WorldVector(viewSize));
+    entities.collectVisible(viewArea, renderOrigin, frame.entities);
+    itemDrops.collectVisible(viewArea, renderOrigin, frame.entities);
+    frame.entityCount = entities.size() + itemDrops.size();
+
+    frame.exploredMap = exploredMap;
+    frame.loadedChunks = static_cast<int>(gameMap.loadedChunks.size());
+    frame.streamingStats = gameMap.streamer.stats;
+    frame.cacheStats = gameMap.chunkCache.getStats();
+
+    frames.publish();
+}
@@ -0,0 +1,93 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <random>
+#include "constants.h"
+#include "utils.h"
+#include "map.h"
+#include "player.h"
+#include "input.h"
+#include "snapshot.h"
+#include "threading.h"
+#include "savegame.h"
+#include "entities.h"
+#include "itemdrops.h"
+#include "inputrecord.h"
+
+// Runs the game on its own thread: player movement and harvesting, entities, chunk
+// streaming, exploration and autosaving. The render thread talks to it only through the input
+// queue and reads the published frames; it never touches Map chunk state or Player
+// simulation state directly.
+class Simulation {
+public:
+    Map& gameMap;
+    Player& player;
+    ExploredChunks exploredChunks;
+    EntitySystem entities;
+    ItemDrops itemDrops;
+
+    SpscQueue<InputCommand> input;      // Render thread -> simulation
+    TripleBuffer<FrameSnapshot> frames; // Simulation -> render thread
+
+    float tickRate = 60.0f;
+
+    // Deterministic record and replay, set before start(). While replaying, ticks and their dt
+    // come from the recording, live input is drained and ignored, and nothing is saved.
+    InputRecorder* recorder = nullptr;
+    InputReplay* replay = nullptr;
+    bool unthrottled = false; // Step back to back instead of at tickRate, for fast replays
+    std::atomic<bool> replayFinished{ false };
+
+    Simulation(Map& map, Player& gamePlayer, const std::string& savePath);
+    ~Simulation();
+
+    void start(); // Publishes a first frame, then starts the thread
+    void stop();  // Joins the thread and writes a final save
+    void step(float dt);
+
+private:
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    long long tick = 0;
+
+    std::string path;
+    AutoSaver autoSaver;
+    float autosaveElapsed = 0.0f;
+    std::mt19937 spawnRng{ 1337 };
+
+    // Latest input state
+    std::uint8_t movementFlags = 0;
+    sf::Vector2f viewSize{ 2560.0f, 1440.0f };
+    int exploredHalfWidth = 0;
+    int exploredHalfHeight = 0;
+
+    // Click-to-move: waypoints from the path finder, refined into tiles one segment at a time
+    std::vector<sf::Vector2i> moveWaypoints;
+    size_t moveWaypointIndex = 0;
+    std::vector<sf::Vector2i> moveTiles;
+    size_t moveTileIndex = 0;
+
+    RenderOrigin renderOrigin;
+
+    // Rebuilt only when the player changes chunk or something new is explored
+    ExploredMapView exploredMap;
+    bool exploredMapDirty = true;
+
+    std::vector<InputCommand> tickCommands;
+
+    void run();
+    bool takeCommands(float& dt); // This tick's commands into tickCommands; false once a replay ends
+    void applyCommand(const InputCommand& command);
+    void spawnMobs();
+    void moveTo(sf::Vector2i goal);
+    void followPath();
+    void markExplored();
+    void updateExploredMap();
+    void publishFrame(float stepMilliseconds);
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "constants.h"
+#include "chunk.h"
+#include "player.h"
+#include "streaming.h"
+#include "chunkcache.h"
+#include "entities.h"
+
+// Everything the UI shows about the player, copied out of the simulation each tick
+struct PlayerView {
+    WorldVector position;   // Pixels
+    bool sprinting = false;
+    int selectedHotbarSlot = 0;
+    std::vector<InventorySlot> inventory;
+    std::vector<InventorySlot> toolSlots;
+    const std::vector<CraftingRecipe>* craftingRecipes = nullptr; // Fixed once the Player is constructed
+
+    bool isHarvesting = false;
+    float harvestProgress = 0.0f; // 0 to 1
+    TileType harvestTargetType = TileType::GRASS;
+
+    // Tile the F key would harvest, if any
+    bool hasHarvestHighlight = false;
+    int harvestHighlightX = -1;
+    int harvestHighlightY = -1;
+
+    WorldVector getWorldPosition() const { return position / static_cast<double>(TILE_SIZE); }
+    ChunkCoord getChunk() const { return chunkOf(position); }
+    const std::vector<InventorySlot>& getToolSlots() const { return toolSlots; }
+    const std::vector<CraftingRecipe>& getCraftingRecipes() const { return *craftingRecipes; }
+    bool getIsHarvesting() const { return isHarvesting; }
+    float getHarvestProgress() const { return harvestProgress; }
+
+    int getItemCount(int itemId) const {
+        int total = 0;
+        for (const auto& slot : inventory) {
+            if (slot.itemId == itemId) {
+                total += slot.quantity;
+            }
+        }
+        return total;
+    }
+
+    bool canCraft(const CraftingRecipe& recipe) const {
+        return getItemCount(recipe.requiredItemId) >= recipe.requiredQuantity;
+    }
+};
+
+const std::uint8_t UNEXPLORED_CELL = 0xFF;
+
+// Explored chunks around the player for the minimap and full map: one cell per chunk
+// holding the TileType at the chunk's center, or UNEXPLORED_CELL
+struct ExploredMapView {
+    std::int64_t originChunkX = 0;
+    std::int64_t originChunkY = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint8_t> cells;
+
+    bool getCell(std::int64_t chunkX, std::int64_t chunkY, TileType& tileType) const {
+        std::int64_t x = chunkX - originChunkX;
+        std::int64_t y = chunkY - originChunkY;
+        if (x < 0 || x >= width || y < 0 || y >= height) {
+            return false;
+        }
+
+        std::uint8_t cell = cells[y * width + x];
+        if (cell == UNEXPLORED_CELL) {
+            return false;
+        }
+        tileType = static_cast<TileType>(cell);
+        return true;
+    }
+};
+
+// One simulation tick as seen by the render thread. Chunk meshes are immutable and
+// shared, so publishing a frame copies pointers rather than tiles.
+struct FrameSnapshot {
+    long long tick = 0;
+    float stepMilliseconds = 0.0f;
+    float flowFieldMilliseconds = 0.0f; // Last full recompute of the mobs' chase field
+    float timeOfDay = DAY_START_TIME; // 0 = midnight, 0.5 = noon
+    RenderOrigin origin;    // Chunk meshes, entities and the camera are all drawn relative to it
+    PlayerView player;
+    std::vector<std::shared_ptr<const ChunkMesh>> visibleChunks;
+    EntityView entities; // Only those inside the view
+    int entityCount = 0;
+    ExploredMapView exploredMap;
+    int loadedChunks = 0;
+    StreamingStats streamingStats;
+    ChunkCacheStats cacheStats;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "streaming.h"
+#include "map.h"
+#include "jobsystem.h"
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+void ChunkStreamer::setRenderDistance(int chunks) {
+    renderDistance = std::clamp(chunks, 1, MAX_RENDER_DISTANCE);
+    maxLookaheadChunks = std::max(1, renderDistance / 2);
+}
+
+void ChunkStreamer::predict(Map& gameMap, WorldVector playerPos, sf::Vector2f velocity) {
+    const float chunkPixels = static_cast<float>(CHUNK_SIZE * TILE_SIZE);
+
+    playerChunk = chunkOf(playerPos);
+
+    // Lookahead distance grows with speed, capped so prefetching never outruns the load budget
+    sf::Vector2f offset = velocity * (lookaheadSeconds / chunkPixels);
+    float length = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+    if (length > maxLookaheadChunks) {
+        offset = offset * (maxLookaheadChunks / length);
+    }
+
+    predictedChunkPos = playerPos / static_cast<double>(chunkPixels) + WorldVector(offset);
+    ChunkCoord predictedChunk = {
+        static_cast<std::int64_t>(std::floor(predictedChunkPos.x)),
+        static_cast<std::int64_t>(std::floor(predictedChunkPos.y))
+    };
+
+    // The prefetch square is loaded and kept, but has no hysteresis of its own
+    if (playerObserver < 0) {
+        playerObserver = gameMap.interest.addObserver(playerChunk, renderDistance, renderDistance + unloadHysteresis);
+        lookaheadObserver = gameMap.interest.addObserver(predictedChunk, renderDistance, renderDistance);
+    }
+    gameMap.interest.setRadius(playerObserver, renderDistance, renderDistance + unloadHysteresis);
+    gameMap.interest.setRadius(lookaheadObserver, renderDistance, renderDistance);
+    gameMap.interest.moveObserver(playerObserver, playerChunk);
+    gameMap.interest.moveObserver(lookaheadObserver, predictedChunk);
+}
+
+bool ChunkStreamer::isRequired(ChunkCoord coord) const {
+    return std::llabs(coord.x - playerChunk.x) <= renderDistance &&
+        std::llabs(coord.y - playerChunk.y) <= renderDistance;
+}
+
+void ChunkStreamer::loadAround(Map& gameMap, WorldVector playerPos, sf::Vector2f velocity) {
+    predict(gameMap, playerPos, velocity);
+
+    // Missing chunks in the required square and the square around the predicted position,
+    // plus any other observer's
+    const auto& pendingLoads = gameMap.interest.getPendingLoads();
+    if (pendingLoads.empty()) {
+        return;
+    }
+    candidates.clear();
+    for (const auto& entry : pendingLoads) {
+        ChunkCoord coord = entry.first;
+        float distX = static_cast<float>(coord.x + 0.5 - predictedChunkPos.x);
+        float distY = static_cast<float>(coord.y + 0.5 - predictedChunkPos.y);
+        candidates.push_back({ distX * distX + distY * distY, coord });
+    }
+
+    // Load the chunks closest to where the player is heading, within the per-frame budget
+    // While catching up, a batch as wide as the job system costs about as much wall time as one
+    // chunk. That width is the host's core count, so recordings and replays go without it.
+    int budget = loadsPerFrame;
+    if (stats.missingVisibleLastFrame > 0) {
+        budget = hostIndependent ? catchUpLoadsPerFrame
+            : std::max(catchUpLoadsPerFrame, static_cast<int>(getJobSystem().getWorkerCount()));
+    }
+    budget = std::min(budget, static_cast<int>(candidates.size()));
+    std::partial_sort(candidates.begin(), candidates.begin() + budget, candidates.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    // The whole budget is generated as one batch on the job system
+    batch.clear();
+    for (int i = 0; i < budget; i++) {
+        ChunkCoord coord = candidates[i].second;
+        batch.push_back(coord);
+        stats.chunksLoaded++;
+        if (!isRequired(coord)) {
+            stats.chunksPrefetched++;
+        }
+    }
+    gameMap.loadChunks(batch);
+}
+
+void ChunkStreamer::unloadBehind(Map& gameMap, WorldVector playerPos, sf::Vector2f velocity) {
+    predict(gameMap, playerPos, velocity);
+
+    // Whatever is outside the hysteresis band and the prefetch square, unless another observer keeps it
+    stats.chunksUnloaded += gameMap.unloadUnobservedChunks();
+}
+
+void ChunkStreamer::recordVisibility(const Map& gameMap, int startChunkX, int startChunkY, int endChunkX, int endChunkY) {
+    // Only chunks the streamer is responsible for count; farther ones are drawn from the coarse layer
+    int missing = 0;
+    for (int chunkY = startChunkY; chunkY <= endChunkY; chunkY++) {
+        for (int chunkX = startChunkX; chunkX <= endChunkX; chunkX++) {
+            ChunkCoord coord = { chunkX, chunkY };
+            if (isRequired(coord) && gameMap.loadedChunks.find(coord) == gameMap.loadedChunks.end()) {
+                missing++;
+            }
+        }
+    }
+
+    stats.frames++;
+    stats.missingVisibleLastFrame = missing;
+    if (missing > 0) {
+        stats.framesWithMissingVisible++;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef STREAMING_H
+#define STREAMING_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <utility>
+#include "chunk.h"
+#include "constants.h"
+#include "chunkinterest.h"
+
+class Map; // Forward declaration
+
+// Counters for tuning the streaming scheduler
+struct StreamingStats {
+    long long frames = 0;
+    long long framesWithMissingVisible = 0; // Frames where a visible chunk near the player was not loaded
+    long long chunksLoaded = 0;
+    long long chunksUnloaded = 0;
+    long long chunksPrefetched = 0;         // Loads outside the required radius, ahead of the player
+    int missingVisibleLastFrame = 0;
+};
+
+// Streams chunks for the local player through the map's ChunkInterest, as two observers:
+// the player, keeping a hysteresis band so boundary chunks don't thrash, and a lookahead
+// square around where the player will be after lookaheadSeconds. Loads are ordered by
+// distance to that predicted position, so chunks in the direction of travel come first.
+class ChunkStreamer {
+public:
+    float lookaheadSeconds = 4.0f;
+    int maxLookaheadChunks = RENDER_DISTANCE / 2;
+    int loadsPerFrame = 1;
+    int catchUpLoadsPerFrame = 4;   // Used while visible chunks are missing
+    bool hostIndependent = false;   // Catch up by catchUpLoadsPerFrame alone, ignoring the core count
+    int unloadHysteresis = 2;       // Extra chunks kept beyond the render distance before unloading
+    StreamingStats stats;
+
+    // Chunks each way around the player that are kept loaded, 1-MAX_RENDER_DISTANCE. Takes
+    // effect on the next loadAround; the lookahead cap scales with it.
+    void setRenderDistance(int chunks);
+    int getRenderDistance() const { return renderDistance; }
+
+    void loadAround(Map& gameMap, WorldVector playerPos, sf::Vector2f velocity);
+    void unloadBehind(Map& gameMap, WorldVector playerPos, sf::Vector2f velocity);
+    void recordVisibility(const Map& gameMap, int startChunkX, int startChunkY, int endChunkX, int endChunkY);
+
+private:
+    int renderDistance = RENDER_DISTANCE;
+    ChunkCoord playerChunk{ 0, 0 };
+    WorldVector predictedChunkPos;    // Predicted position in (fractional) chunk units
+    ChunkInterest::ObserverId playerObserver = -1;
+    ChunkInterest::ObserverId lookaheadObserver = -1;
+    std::vector<std::pair<float, ChunkCoord>> candidates;
+    std::vector<ChunkCoord> batch;
+
+    void predict(Map& gameMap, WorldVector playerPos, sf::Vector2f velocity); // Moves both observers
+    bool isRequired(ChunkCoord coord) const;
+};
+
+#endif
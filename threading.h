@@ -0,0 +1,89 @@
+#ifndef THREADING_H
+#define THREADING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Lock-free single-producer single-consumer ring buffer. push() must only be called from
+// one thread and pop() from one other thread. Capacity is rounded to a power of two.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(std::size_t capacity = 1024) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    // Returns false if the queue is full
+    bool push(const T& value) {
+        std::size_t tail = writeIndex.load(std::memory_order_relaxed);
+        if (tail - readIndex.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+        slots[tail & mask] = value;
+        writeIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false if the queue is empty
+    bool pop(T& value) {
+        std::size_t head = readIndex.load(std::memory_order_relaxed);
+        if (head == writeIndex.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(slots[head & mask]);
+        readIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> slots;
+    std::size_t mask = 0;
+    alignas(64) std::atomic<std::size_t> writeIndex{ 0 };
+    alignas(64) std::atomic<std::size_t> readIndex{ 0 };
+};
+
+// Triple buffer for handing whole frames from one writer thread to one reader thread.
+// The writer always has a free slot to fill and the reader always keeps the newest
+// complete one, so neither side ever waits; frames the reader doesn't get to are dropped.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side: fill writeSlot(), then publish() it
+    T& writeSlot() { return buffers[writeIndex]; }
+
+    void publish() {
+        std::uint8_t previous = middle.exchange(static_cast<std::uint8_t>(writeIndex | FRESH_BIT), std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // Reader side: switch readSlot() to the newest published frame, if there is a new one
+    bool acquire() {
+        if ((middle.load(std::memory_order_acquire) & FRESH_BIT) == 0) {
+            return false;
+        }
+        std::uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readSlot() const { return buffers[readIndex]; }
+
+private:
+    static const std::uint8_t INDEX_MASK = 3;
+    static const std::uint8_t FRESH_BIT = 4;
+
+    T buffers[3];
+    std::uint8_t writeIndex = 0;
+    std::atomic<std::uint8_t> middle{ 1 };
+    std::uint8_t readIndex = 2;
+};
+
+#endif
@@ -0,0 +1,264 @@
+#include "tilemap.h"
+#include "autotile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Texture coordinates are tiles from the render origin. The tile texture is sampled at
+    // the tile's ring texel, the atlas at the tile's type cell and the masks at its shape's
+    // cell, inset half a texel so nearest sampling never reads the neighboring cell.
+    const char* TILEMAP_SHADER =
+        "uniform sampler2D tiles;\n"
+        "uniform sampler2D atlas;\n"
+        "uniform sampler2D masks;\n"
+        "uniform float windowTiles;\n"
+        "uniform vec2 originTile;\n"
+        "uniform float atlasCells;\n"
+        "uniform float waterCell;\n"
+        "uniform float groundCell;\n"
+        "uniform float shapeCount;\n"
+        "uniform float cellInset;\n"
+        "uniform float maskInset;\n"
+        "void main() {\n"
+        "    vec2 local = gl_TexCoord[0].xy;\n"
+        "    vec2 tile = floor(local);\n"
+        "    vec2 texel = mod(tile + originTile, windowTiles);\n"
+        "    vec4 id = texture2D(tiles, (texel + 0.5) / windowTiles);\n"
+        "    if (id.a == 0.0) discard;\n"
+        "    vec2 inTile = clamp(local - tile, cellInset, 1.0 - cellInset);\n"
+        "    vec2 inMask = clamp(local - tile, maskInset, 1.0 - maskInset);\n"
+        "    float type = floor(id.r * 255.0 + 0.5);\n"
+        "    float shape = floor(id.b * 255.0 + 0.5);\n"
+        "    vec4 color = texture2D(atlas, vec2((type + inTile.x) / atlasCells, inTile.y));\n"
+        "    vec4 ground = texture2D(atlas, vec2((groundCell + inTile.x) / atlasCells, inTile.y));\n"
+        "    float cover = texture2D(masks, vec2((shape + inMask.x) / shapeCount, inMask.y)).a;\n"
+        "    color = mix(ground, color, cover);\n"
+        "    vec4 water = texture2D(atlas, vec2((waterCell + inTile.x) / atlasCells, inTile.y));\n"
+        "    gl_FragColor = mix(color, water, id.g) * gl_Color;\n"
+        "}\n";
+
+    std::int64_t ringIndex(std::int64_t value) {
+        std::int64_t remainder = value % TILEMAP_WINDOW_CHUNKS;
+        return (remainder < 0) ? remainder + TILEMAP_WINDOW_CHUNKS : remainder;
+    }
+
+    void setTexel(std::uint8_t* pixel, const ChunkMesh& mesh, int x, int y) {
+        pixel[0] = static_cast<std::uint8_t>(mesh.tileTypes[y][x]);
+        pixel[1] = (mesh.tileTypes[y][x] == TileType::WATER) ? 0 : mesh.waterLevels[y][x];
+        pixel[2] = mesh.autotiles[y][x];
+        pixel[3] = 255;
+    }
+
+    bool texelChanged(const ChunkMesh& before, const ChunkMesh& after, int x, int y) {
+        return before.tileTypes[y][x] != after.tileTypes[y][x] || before.waterLevels[y][x] != after.waterLevels[y][x] ||
+            before.autotiles[y][x] != after.autotiles[y][x];
+    }
+
+    // How much of a tile its own terrain covers at (u, v), for a shape's reduced neighbor mask.
+    // Open sides fade out over the outer EDGE_WIDTH of the tile, corners open on both sides
+    // are rounded off, and an open diagonal between two matching sides bites out its corner.
+    float getShapeCoverage(std::uint8_t mask, float u, float v) {
+        const float EDGE_WIDTH = 0.25f;
+        bool north = (mask & AUTOTILE_N) != 0;
+        bool east = (mask & AUTOTILE_E) != 0;
+        bool south = (mask & AUTOTILE_S) != 0;
+        bool west = (mask & AUTOTILE_W) != 0;
+
+        float cover = 1.0f;
+        if (!north) cover = std::min(cover, v / EDGE_WIDTH);
+        if (!south) cover = std::min(cover, (1.0f - v) / EDGE_WIDTH);
+        if (!west) cover = std::min(cover, u / EDGE_WIDTH);
+        if (!east) cover = std::min(cover, (1.0f - u) / EDGE_WIDTH);
+
+        struct Corner { float x, y; bool sideA, sideB; std::uint8_t diagonal; };
+        const Corner corners[4] = {
+            { 0.0f, 0.0f, north, west, AUTOTILE_NW },
+            { 1.0f, 0.0f, north, east, AUTOTILE_NE },
+            { 1.0f, 1.0f, south, east, AUTOTILE_SE },
+            { 0.0f, 1.0f, south, west, AUTOTILE_SW }
+        };
+        for (const Corner& corner : corners) {
+            float cornerU = std::abs(u - corner.x);
+            float cornerV = std::abs(v - corner.y);
+            if (!corner.sideA && !corner.sideB && cornerU < EDGE_WIDTH && cornerV < EDGE_WIDTH) {
+                float distance = std::hypot(EDGE_WIDTH - cornerU, EDGE_WIDTH - cornerV);
+                cover = std::min(cover, 1.0f - distance / EDGE_WIDTH);
+            }
+            else if (corner.sideA && corner.sideB && !(mask & corner.diagonal)) {
+                cover = std::min(cover, std::hypot(cornerU, cornerV) / EDGE_WIDTH);
+            }
+        }
+        return std::max(0.0f, std::min(1.0f, cover));
+    }
+
+    sf::Image buildShapeMasks() {
+        const unsigned cell = static_cast<unsigned>(TILEMAP_MASK_CELL);
+        sf::Image masks({ cell * AUTOTILE_SHAPES, cell }, sf::Color::Transparent);
+        for (int shape = 0; shape < AUTOTILE_SHAPES; shape++) {
+            std::uint8_t mask = getAutotileMask(static_cast<std::uint8_t>(shape));
+            for (unsigned y = 0; y < cell; y++) {
+                for (unsigned x = 0; x < cell; x++) {
+                    float cover = getShapeCoverage(mask, (x + 0.5f) / cell, (y + 0.5f) / cell);
+                    masks.setPixel({ shape * cell + x, y }, sf::Color(255, 255, 255, static_cast<std::uint8_t>(cover * 255.0f + 0.5f)));
+                }
+            }
+        }
+        return masks;
+    }
+}
+
+bool TilemapRenderer::load(const sf::Image& atlas) {
+    loadAttempted = true;
+    if (!sf::Shader::isAvailable() || !shader.loadFromMemory(TILEMAP_SHADER, sf::Shader::Type::Fragment)) {
+        std::cout << "Tilemap shader unavailable, drawing terrain as sprites" << std::endl;
+        return false;
+    }
+    if (!atlasTexture.loadFromImage(atlas) || !maskTexture.loadFromImage(buildShapeMasks()) ||
+        !tileTexture.resize({ static_cast<unsigned>(WINDOW_TILES), static_cast<unsigned>(WINDOW_TILES) })) {
+        std::cout << "Could not create tilemap textures, drawing terrain as sprites" << std::endl;
+        return false;
+    }
+    atlasTexture.setSmooth(false);
+    maskTexture.setSmooth(false);
+    tileTexture.setSmooth(false);
+
+    // Every slot starts empty: fully transparent, so unloaded chunks show the coarse layer
+    std::vector<std::uint8_t> empty(static_cast<size_t>(WINDOW_TILES) * WINDOW_TILES * 4, 0);
+    tileTexture.update(empty.data(), { static_cast<unsigned>(WINDOW_TILES), static_cast<unsigned>(WINDOW_TILES) }, { 0, 0 });
+    slots.assign(static_cast<size_t>(TILEMAP_WINDOW_CHUNKS) * TILEMAP_WINDOW_CHUNKS, Slot());
+    blockPixels.assign(static_cast<size_t>(CHUNK_SIZE) * CHUNK_SIZE * 4, 0);
+
+    unsigned atlasCells = atlas.getSize().x / TILEMAP_ATLAS_CELL;
+    shader.setUniform("tiles", tileTexture);
+    shader.setUniform("atlas", atlasTexture);
+    shader.setUniform("masks", maskTexture);
+    shader.setUniform("windowTiles", static_cast<float>(WINDOW_TILES));
+    shader.setUniform("atlasCells", static_cast<float>(atlasCells));
+    shader.setUniform("waterCell", static_cast<float>(TileType::WATER));
+    shader.setUniform("groundCell", static_cast<float>(TileType::DIRT));
+    shader.setUniform("shapeCount", static_cast<float>(AUTOTILE_SHAPES));
+    shader.setUniform("cellInset", 0.5f / TILEMAP_ATLAS_CELL);
+    shader.setUniform("maskInset", 0.5f / TILEMAP_MASK_CELL);
+    shaderLoaded = true;
+    return true;
+}
+
+TilemapRenderer::Slot& TilemapRenderer::getSlot(ChunkCoord coord) {
+    return slots[static_cast<size_t>(ringIndex(coord.y) * TILEMAP_WINDOW_CHUNKS + ringIndex(coord.x))];
+}
+
+void TilemapRenderer::uploadChunk(Slot& slot, ChunkCoord coord, const std::shared_ptr<const ChunkMesh>& mesh) {
+    sf::Vector2u corner = {
+        static_cast<unsigned>(ringIndex(coord.x) * CHUNK_SIZE),
+        static_cast<unsigned>(ringIndex(coord.y) * CHUNK_SIZE)
+    };
+
+    // The same chunk with a newer mesh: only the texels that changed, unless that is most of them
+    if (slot.mesh && mesh && slot.coord == coord) {
+        int changed = 0;
+        for (int y = 0; y < CHUNK_SIZE && changed <= CHUNK_SIZE; y++) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                changed += texelChanged(*slot.mesh, *mesh, x, y);
+            }
+        }
+        if (changed <= CHUNK_SIZE) {
+            for (int y = 0; y < CHUNK_SIZE; y++) {
+                for (int x = 0; x < CHUNK_SIZE; x++) {
+                    if (texelChanged(*slot.mesh, *mesh, x, y)) {
+                        std::uint8_t texel[4];
+                        setTexel(texel, *mesh, x, y);
+                        tileTexture.update(texel, { 1, 1 }, { corner.x + x, corner.y + y });
+                        lastTexelUploads++;
+                    }
+                }
+            }
+            slot.mesh = mesh;
+            return;
+        }
+    }
+
+    // A new chunk in the slot, or an emptied one: the whole block
+    if (mesh) {
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                setTexel(&blockPixels[(static_cast<size_t>(y) * CHUNK_SIZE + x) * 4], *mesh, x, y);
+            }
+        }
+    }
+    else {
+        std::fill(blockPixels.begin(), blockPixels.end(), 0);
+    }
+    tileTexture.update(blockPixels.data(), { static_cast<unsigned>(CHUNK_SIZE), static_cast<unsigned>(CHUNK_SIZE) }, corner);
+    lastTexelUploads += CHUNK_SIZE * CHUNK_SIZE;
+    slot.coord = coord;
+    slot.mesh = mesh;
+}
+
+bool TilemapRenderer::draw(sf::RenderWindow& window, const RenderOrigin& origin, const std::vector<std::shared_ptr<const ChunkMesh>>& chunks,
+    int startX, int startY, int endX, int endY) {
+    lastTexelUploads = 0;
+    if (!shaderLoaded || endX <= startX || endY <= startY) {
+        return false;
+    }
+
+    // Chunks sharing a slot must never be visible together
+    int startChunkX = floorDiv(startX, CHUNK_SIZE);
+    int startChunkY = floorDiv(startY, CHUNK_SIZE);
+    int endChunkX = floorDiv(endX - 1, CHUNK_SIZE);
+    int endChunkY = floorDiv(endY - 1, CHUNK_SIZE);
+    if (endChunkX - startChunkX >= TILEMAP_WINDOW_CHUNKS || endChunkY - startChunkY >= TILEMAP_WINDOW_CHUNKS) {
+        return false;
+    }
+
+    frame++;
+    for (const auto& mesh : chunks) {
+        if (mesh->coord.x < startChunkX || mesh->coord.x > endChunkX || mesh->coord.y < startChunkY || mesh->coord.y > endChunkY) {
+            continue;
+        }
+        Slot& slot = getSlot(mesh->coord);
+        if (slot.mesh != mesh) {
+            uploadChunk(slot, mesh->coord, mesh);
+        }
+        slot.drawnFrame = frame;
+    }
+
+    // Visible chunks that aren't loaded (any more) read as empty
+    for (int chunkY = startChunkY; chunkY <= endChunkY; chunkY++) {
+        for (int chunkX = startChunkX; chunkX <= endChunkX; chunkX++) {
+            ChunkCoord coord = { chunkX, chunkY };
+            Slot& slot = getSlot(coord);
+            if (slot.mesh && slot.drawnFrame != frame) {
+                uploadChunk(slot, coord, nullptr);
+            }
+        }
+    }
+
+    sf::Vector2f topLeft = origin.tileToLocal(startX, startY);
+    sf::Vector2f bottomRight = origin.tileToLocal(endX, endY);
+    sf::Vector2f tileTopLeft = topLeft / static_cast<float>(TILE_SIZE);
+    sf::Vector2f tileBottomRight = bottomRight / static_cast<float>(TILE_SIZE);
+    quad[0].position = topLeft;
+    quad[1].position = { bottomRight.x, topLeft.y };
+    quad[2].position = { topLeft.x, bottomRight.y };
+    quad[3].position = bottomRight;
+    quad[0].texCoords = tileTopLeft;
+    quad[1].texCoords = { tileBottomRight.x, tileTopLeft.y };
+    quad[2].texCoords = { tileTopLeft.x, tileBottomRight.y };
+    quad[3].texCoords = tileBottomRight;
+    for (int i = 0; i < 4; i++) {
+        quad[i].color = sf::Color::White;
+    }
+
+    // The origin's own ring offset; texture coordinates stay small however far out the origin is
+    shader.setUniform("originTile", sf::Glsl::Vec2(
+        static_cast<float>(ringIndex(origin.chunk.x) * CHUNK_SIZE),
+        static_cast<float>(ringIndex(origin.chunk.y) * CHUNK_SIZE)));
+
+    // No texture in the states, so SFML passes the tile coordinates through unscaled
+    sf::RenderStates states;
+    states.shader = &shader;
+    window.draw(quad, states);
+    return true;
+}
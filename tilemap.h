@@ -0,0 +1,62 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "constants.h"
+#include "chunk.h"
+
+// Draws the visible terrain as one quad. The tiles of the chunks around the camera live in
+// a single tile texture, one texel per tile (type in red, standing water in green, autotile
+// shape in blue, alpha where a chunk is loaded), and a fragment shader picks each pixel's
+// color out of a tile atlas. Where a tile's shape leaves an edge or corner open toward
+// another terrain, the shader fades it into dirt through that shape's edge mask. The
+// texture is a ring of TILEMAP_WINDOW_CHUNKS chunks each way, addressed by world tile
+// modulo its size, so moving the camera or the render origin uploads nothing; a chunk is
+// uploaded when it first shows up in its slot, and after that only the texels its new
+// meshes changed, so a tile edit updates a single texel.
+class TilemapRenderer {
+public:
+    // Atlas: TILEMAP_ATLAS_CELL pixel cells in a row, indexed by TileType. Without shader
+    // support this fails and the map keeps drawing sprites.
+    bool load(const sf::Image& atlas);
+    bool isLoaded() const { return shaderLoaded; }
+    bool wasLoadAttempted() const { return loadAttempted; }
+
+    // Tiles in [startX, endX) x [startY, endY); false if it can't be drawn this way (no
+    // shader, or a view wider than the ring), in which case nothing was drawn
+    bool draw(sf::RenderWindow& window, const RenderOrigin& origin, const std::vector<std::shared_ptr<const ChunkMesh>>& chunks,
+        int startX, int startY, int endX, int endY);
+
+    int getLastTexelUploads() const { return lastTexelUploads; }
+
+private:
+    static const int WINDOW_TILES = TILEMAP_WINDOW_CHUNKS * CHUNK_SIZE;
+
+    // What a ring slot holds; mesh is null while the slot is empty
+    struct Slot {
+        ChunkCoord coord{ 0, 0 };
+        std::shared_ptr<const ChunkMesh> mesh;
+        long long drawnFrame = 0; // Last frame whose visible chunks included it
+    };
+
+    sf::Shader shader;
+    bool shaderLoaded = false;
+    bool loadAttempted = false;
+
+    sf::Texture atlasTexture;
+    sf::Texture maskTexture; // One TILEMAP_MASK_CELL cell per autotile shape, coverage in alpha
+    sf::Texture tileTexture;
+    std::vector<Slot> slots;
+    std::vector<std::uint8_t> blockPixels; // RGBA scratch for one chunk
+    sf::VertexArray quad{ sf::PrimitiveType::TriangleStrip, 4 };
+    int lastTexelUploads = 0;
+    long long frame = 0;
+
+    Slot& getSlot(ChunkCoord coord);
+    void uploadChunk(Slot& slot, ChunkCoord coord, const std::shared_ptr<const ChunkMesh>& mesh);
+};
+
+#endif
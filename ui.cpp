@@ -1,24 +1,32 @@
 #include "ui.h"
+#include "assets.h"
 #include <iostream>
 
-UI::UI() : positionText(font), chunkText(font), instructionText(font), fpsText(font), itemCountText(font) {
+UI::UI() : positionText(font), chunkText(font), instructionText(font), fpsText(font), renderText(font), streamingText(font), itemCountText(font) {
     // Use default font if loading fails
     if (!font.openFromFile("fonts/arial.ttf")) {
         std::cout << "Using default font" << std::endl;
     }
 
     // Try to load item textures for inventory display
-    if (itemGrassTexture.loadFromFile("textures/grass.png") &&
-        itemWaterTexture.loadFromFile("textures/water.png") &&
-        itemStoneTexture.loadFromFile("textures/stone.png") &&
-        itemTreeTexture.loadFromFile("textures/tree.png") &&
-        itemWoodTexture.loadFromFile("textures/wood.png") &&
-        itemStone2Texture.loadFromFile("textures/stone2.png") &&
-        itemWoodPickaxeTexture.loadFromFile("textures/wood_pickaxe.png") &&
-        itemWoodAxeTexture.loadFromFile("textures/wood_axe.png") &&
-        itemDirtTexture.loadFromFile("textures/dirt.png")) {
+    if (loadTextures({
+        { &itemGrassTexture, "textures/grass.png" },
+        { &itemWaterTexture, "textures/water.png" },
+        { &itemStoneTexture, "textures/stone.png" },
+        { &itemTreeTexture, "textures/tree.png" },
+        { &itemWoodTexture, "textures/wood.png" },
+        { &itemStone2Texture, "textures/stone2.png" },
+        { &itemWoodPickaxeTexture, "textures/wood_pickaxe.png" },
+        { &itemWoodAxeTexture, "textures/wood_axe.png" },
+        { &itemDirtTexture, "textures/dirt.png" } })) {
         useItemTextures = true;
         std::cout << "Item textures loaded successfully" << std::endl;
+
+        sf::Image torchImage({ 32, 32 }, sf::Color::Transparent);
+        drawTorch(torchImage);
+        if (!itemTorchTexture.loadFromImage(torchImage)) {
+            std::cout << "Failed to build torch item texture" << std::endl;
+        }
     }
     else {
         std::cout << "Using colored rectangles for inventory items" << std::endl;
@@ -54,7 +62,7 @@ UI::UI() : positionText(font), chunkText(font), instructionText(font), fpsText(f
     chunkText.setFillColor(sf::Color::White);
 
     instructionText.setFont(font);
-    instructionText.setString("WASD to move | SHIFT to sprint | M for map | E for inventory | C for crafting | Right-click to harvest");
+    instructionText.setString("WASD to move | SHIFT to sprint | Wheel to zoom | M for map | E for inventory | C for crafting | Right-click or F to harvest | Left-click to walk | T for torch");
     instructionText.setCharacterSize(14);
     instructionText.setFillColor(sf::Color::Yellow);
 
@@ -63,6 +71,16 @@ UI::UI() : positionText(font), chunkText(font), instructionText(font), fpsText(f
     fpsText.setCharacterSize(16);
     fpsText.setFillColor(sf::Color::White);
 
+    renderText.setFont(font);
+    renderText.setString("Zoom: 1.0x | Draw calls: 0");
+    renderText.setCharacterSize(16);
+    renderText.setFillColor(sf::Color::White);
+
+    streamingText.setFont(font);
+    streamingText.setString("Missing visible: 0/0 frames");
+    streamingText.setCharacterSize(16);
+    streamingText.setFillColor(sf::Color::White);
+
     itemCountText.setFont(font);
     itemCountText.setCharacterSize(18);
     itemCountText.setFillColor(sf::Color::White);
@@ -112,6 +130,11 @@ UI::UI() : positionText(font), chunkText(font), instructionText(font), fpsText(f
     toolSlotBackground.setFillColor({ 32, 32, 64 });
     toolSlotBackground.setOutlineColor(sf::Color::Cyan);
     toolSlotBackground.setOutlineThickness(2);
+
+    harvestTargetHighlight.setSize({ static_cast<float>(TILE_SIZE), static_cast<float>(TILE_SIZE) });
+    harvestTargetHighlight.setFillColor(sf::Color::Transparent);
+    harvestTargetHighlight.setOutlineColor({ 255, 255, 0, 180 });
+    harvestTargetHighlight.setOutlineThickness(-3);
 }
 
 sf::Color UI::getItemColor(int itemId) {
@@ -123,6 +146,7 @@ sf::Color UI::getItemColor(int itemId) {
     case 4: return sf::Color{ 139, 69, 19 };   // Wood - brown
     case 5: return sf::Color{ 160, 82, 45 };   // Wood Pickaxe - saddle brown
     case 6: return sf::Color{ 205, 133, 63 };  // Wood Axe - peru
+    case 7: return sf::Color{ 255, 140, 20 };  // Torch - orange
     default: return sf::Color::White;
     }
 }
@@ -154,6 +178,7 @@ void UI::drawInventorySlot(sf::RenderWindow& window, const InventorySlot& slot,
             case 4: texture = &itemWoodTexture; break;
             case 5: texture = &itemWoodPickaxeTexture; break;
             case 6: texture = &itemWoodAxeTexture; break;
+            case 7: texture = &itemTorchTexture; break;
             default: texture = &itemGrassTexture; break;
             }
 
@@ -201,7 +226,7 @@ void UI::drawInventorySlot(sf::RenderWindow& window, const InventorySlot& slot,
     }
 }
 
-void UI::drawToolSlots(sf::RenderWindow& window, const Player& player) {
+void UI::drawToolSlots(sf::RenderWindow& window, const PlayerView& player) {
     sf::Vector2u windowSize = window.getSize();
     sf::Vector2f toolSlotsPos{
         static_cast<float>((windowSize.x - inventoryBackground.getSize().x) / 2 + inventoryBackground.getSize().x - 180),
@@ -266,7 +291,7 @@ void UI::drawToolSlots(sf::RenderWindow& window, const Player& player) {
     }
 }
 
-void UI::drawCrafting(sf::RenderWindow& window, const Player& player) {
+void UI::drawCrafting(sf::RenderWindow& window, const PlayerView& player) {
     if (!craftingOpen) return;
 
     sf::Vector2u windowSize = window.getSize();
@@ -437,7 +462,7 @@ bool UI::isCraftButtonAtPosition(sf::Vector2f mousePos, sf::Vector2f craftingPos
 }
 
 
-void UI::handleInventoryClick(sf::Vector2f mousePos, Player& player, bool isPressed) {
+void UI::handleInventoryClick(sf::Vector2f mousePos, const PlayerView& player, bool isPressed, SpscQueue<InputCommand>& commands) {
     sf::Vector2u windowSize = sf::Vector2u{ 2560, 1440 };
 
     // Handle crafting clicks
@@ -456,7 +481,10 @@ void UI::handleInventoryClick(sf::Vector2f mousePos, Player& player, bool isPres
                 if (selectedCraftingRecipeIndex != -1) {
                     const auto& recipes = player.getCraftingRecipes();
                     if (selectedCraftingRecipeIndex < static_cast<int>(recipes.size())) {
-                        player.craft(recipes[selectedCraftingRecipeIndex]);
+                        InputCommand craft;
+                        craft.type = InputCommandType::CRAFT;
+                        craft.a = selectedCraftingRecipeIndex;
+                        commands.push(craft);
                         // Optionally, deselect after crafting or keep selected
                         // selectedCraftingRecipeIndex = -1; 
                     }
@@ -498,17 +526,33 @@ void UI::handleInventoryClick(sf::Vector2f mousePos, Player& player, bool isPres
     else {
         // Mouse button released
         if (isDragging) {
+            // The simulation owns the inventory; send it the move
+            InputCommand move;
+            bool moved = true;
             if (isDraggingFromTool && clickedSlot >= 0) {
                 // Moving from tool slot to inventory
-                player.moveItemFromTool(draggedToolSlot, clickedSlot);
+                move.type = InputCommandType::MOVE_ITEM_FROM_TOOL;
+                move.a = draggedToolSlot;
+                move.b = clickedSlot;
             }
             else if (!isDraggingFromTool && clickedToolSlot >= 0) {
                 // Moving from inventory to tool slot
-                player.moveItemToTool(draggedSlot, clickedToolSlot);
+                move.type = InputCommandType::MOVE_ITEM_TO_TOOL;
+                move.a = draggedSlot;
+                move.b = clickedToolSlot;
             }
             else if (!isDraggingFromTool && clickedSlot >= 0 && draggedSlot != clickedSlot) {
                 // Moving between inventory slots
-                player.moveItem(draggedSlot, clickedSlot);
+                move.type = InputCommandType::MOVE_ITEM;
+                move.a = draggedSlot;
+                move.b = clickedSlot;
+            }
+            else {
+                moved = false;
+            }
+
+            if (moved) {
+                commands.push(move);
             }
         }
         isDragging = false;
@@ -518,7 +562,7 @@ void UI::handleInventoryClick(sf::Vector2f mousePos, Player& player, bool isPres
     }
 }
 
-void UI::drawDraggedItem(sf::RenderWindow& window, const Player& player, sf::Vector2f mousePos) {
+void UI::drawDraggedItem(sf::RenderWindow& window, const PlayerView& player, sf::Vector2f mousePos) {
     if (!isDragging) return;
 
     const InventorySlot* slot = nullptr;
@@ -555,6 +599,7 @@ void UI::drawDraggedItem(sf::RenderWindow& window, const Player& player, sf::Vec
         case 4: texture = &itemWoodTexture; break;
         case 5: texture = &itemWoodPickaxeTexture; break;
         case 6: texture = &itemWoodAxeTexture; break;
+        case 7: texture = &itemTorchTexture; break;
         default: texture = &itemGrassTexture; break;
         }
 
@@ -622,7 +667,7 @@ int UI::getSlotAtPosition(sf::Vector2f mousePos, sf::Vector2f inventoryPos) {
     return -1;
 }
 
-void UI::drawHotbar(sf::RenderWindow& window, const Player& player) {
+void UI::drawHotbar(sf::RenderWindow& window, const PlayerView& player) {
     sf::Vector2u windowSize = window.getSize();
     sf::Vector2f hotbarPos{
         static_cast<float>((windowSize.x - hotbarBackground.getSize().x) / 2),
@@ -644,7 +689,7 @@ void UI::drawHotbar(sf::RenderWindow& window, const Player& player) {
     }
 }
 
-void UI::drawInventory(sf::RenderWindow& window, const Player& player) {
+void UI::drawInventory(sf::RenderWindow& window, const PlayerView& player) {
     if (!inventoryOpen) return;
 
     sf::Vector2u windowSize = window.getSize();
@@ -700,7 +745,7 @@ void UI::drawInventory(sf::RenderWindow& window, const Player& player) {
     }
 }
 
-void UI::drawHarvestProgressBar(sf::RenderWindow& window, const Player& player) {
+void UI::drawHarvestProgressBar(sf::RenderWindow& window, const PlayerView& player) {
     if (!player.getIsHarvesting()) return;
 
     sf::Vector2u windowSize = window.getSize();
@@ -744,24 +789,30 @@ void UI::drawHarvestProgressBar(sf::RenderWindow& window, const Player& player)
     window.draw(harvestText);
 }
 
-void UI::markChunkExplored(ChunkCoord chunk) {
-    exploredChunks[chunk] = true;
+void UI::drawHarvestTargetHighlight(sf::RenderWindow& window, const PlayerView& player, const RenderOrigin& origin) {
+    if (!player.hasHarvestHighlight || mapOpen || inventoryOpen || craftingOpen) return;
+
+    harvestTargetHighlight.setPosition(origin.tileToLocal(player.harvestHighlightX, player.harvestHighlightY));
+    window.draw(harvestTargetHighlight);
 }
 
 sf::Color UI::getBiomeColor(BiomeType biome) {
-    switch (biome) {
-    case BiomeType::GRASSLAND: return sf::Color{ 34, 139, 34 };
-    case BiomeType::FOREST: return sf::Color{ 0, 100, 0 };
-    case BiomeType::MOUNTAIN: return sf::Color{ 128, 128, 128 };
-    case BiomeType::LAKE: return sf::Color{ 30, 144, 255 };
-    case BiomeType::RIVER: return sf::Color{ 30, 144, 255 };
+    return Map::getBiomeColor(biome);
+}
+
+sf::Color UI::getTileColor(TileType tileType) {
+    switch (tileType) {
+    case TileType::GRASS: return sf::Color{ 34, 139, 34 };
+    case TileType::TREE: return sf::Color{ 0, 100, 0 };
+    case TileType::STONE: return sf::Color{ 128, 128, 128 };
+    case TileType::WATER: return sf::Color{ 30, 144, 255 };
+    case TileType::DIRT: return sf::Color{ 139, 90, 43 };
+    case TileType::TORCH: return sf::Color{ 255, 140, 20 };
     default: return sf::Color::Black;
     }
 }
 
-void UI::drawMinimap(sf::RenderWindow& window, const Player& player, const Map& gameMap) {
-    sf::Vector2f playerPos = player.getWorldPosition();
-
+void UI::drawMinimap(sf::RenderWindow& window, const PlayerView& player, const ExploredMapView& exploredMap) {
     // Position minimap in top-right corner
     sf::Vector2u windowSize = window.getSize();
     sf::Vector2f minimapPos{ static_cast<float>(windowSize.x - MINIMAP_SIZE - 20), 20.0f };
@@ -770,32 +821,24 @@ void UI::drawMinimap(sf::RenderWindow& window, const Player& player, const Map&
     window.draw(minimapBackground);
 
     // Draw explored chunks on minimap
-    int playerChunkX = static_cast<int>(playerPos.x) / CHUNK_SIZE;
-    int playerChunkY = static_cast<int>(playerPos.y) / CHUNK_SIZE;
+    ChunkCoord playerChunk = player.getChunk();
 
     for (int dy = -MINIMAP_RANGE; dy <= MINIMAP_RANGE; dy++) {
         for (int dx = -MINIMAP_RANGE; dx <= MINIMAP_RANGE; dx++) {
-            int chunkX = playerChunkX + dx;
-            int chunkY = playerChunkY + dy;
-
-            if (chunkX >= 0 && chunkX < CHUNKS_X && chunkY >= 0 && chunkY < CHUNKS_Y) {
-                ChunkCoord chunk = { chunkX, chunkY };
-
-                if (exploredChunks.find(chunk) != exploredChunks.end()) {
-                    // Sample biome from center of chunk
-                    int sampleX = chunkX * CHUNK_SIZE + CHUNK_SIZE / 2;
-                    int sampleY = chunkY * CHUNK_SIZE + CHUNK_SIZE / 2;
-                    BiomeType biome = gameMap.determineBiome(sampleX, sampleY);
-
-                    sf::RectangleShape chunkRect;
-                    chunkRect.setSize({ static_cast<float>(MINIMAP_TILE_SIZE), static_cast<float>(MINIMAP_TILE_SIZE) });
-                    chunkRect.setFillColor(getBiomeColor(biome));
-                    chunkRect.setPosition({
-                        minimapPos.x + (dx + MINIMAP_RANGE) * MINIMAP_TILE_SIZE,
-                        minimapPos.y + (dy + MINIMAP_RANGE) * MINIMAP_TILE_SIZE
-                        });
-                    window.draw(chunkRect);
-                }
+            std::int64_t chunkX = playerChunk.x + dx;
+            std::int64_t chunkY = playerChunk.y + dy;
+
+            // Center tile of each explored chunk, sampled by the simulation
+            TileType tileType;
+            if (exploredMap.getCell(chunkX, chunkY, tileType)) {
+                sf::RectangleShape chunkRect;
+                chunkRect.setSize({ static_cast<float>(MINIMAP_TILE_SIZE), static_cast<float>(MINIMAP_TILE_SIZE) });
+                chunkRect.setFillColor(getTileColor(tileType));
+                chunkRect.setPosition({
+                    minimapPos.x + (dx + MINIMAP_RANGE) * MINIMAP_TILE_SIZE,
+                    minimapPos.y + (dy + MINIMAP_RANGE) * MINIMAP_TILE_SIZE
+                    });
+                window.draw(chunkRect);
             }
         }
     }
@@ -810,7 +853,7 @@ void UI::drawMinimap(sf::RenderWindow& window, const Player& player, const Map&
     window.draw(playerDot);
 }
 
-void UI::drawFullMap(sf::RenderWindow& window, const Player& player, const Map& gameMap) {
+void UI::drawFullMap(sf::RenderWindow& window, const PlayerView& player, const ExploredMapView& exploredMap) {
     if (!mapOpen) return;
 
     sf::Vector2u windowSize = window.getSize();
@@ -831,9 +874,7 @@ void UI::drawFullMap(sf::RenderWindow& window, const Player& player, const Map&
     window.draw(mapTitle);
 
     // Draw explored chunks
-    sf::Vector2f playerPos = player.getWorldPosition();
-    int playerChunkX = static_cast<int>(playerPos.x) / CHUNK_SIZE;
-    int playerChunkY = static_cast<int>(playerPos.y) / CHUNK_SIZE;
+    ChunkCoord playerChunk = player.getChunk();
 
     // Calculate map bounds
     float mapStartX = mapPos.x + 10;
@@ -845,32 +886,25 @@ void UI::drawFullMap(sf::RenderWindow& window, const Player& player, const Map&
     int chunksPerRow = static_cast<int>(mapWidth / MAP_TILE_SIZE);
     int chunksPerCol = static_cast<int>(mapHeight / MAP_TILE_SIZE);
 
-    int startChunkX = playerChunkX - chunksPerRow / 2;
-    int startChunkY = playerChunkY - chunksPerCol / 2;
+    std::int64_t startChunkX = playerChunk.x - chunksPerRow / 2;
+    std::int64_t startChunkY = playerChunk.y - chunksPerCol / 2;
 
     for (int y = 0; y < chunksPerCol; y++) {
         for (int x = 0; x < chunksPerRow; x++) {
-            int chunkX = startChunkX + x;
-            int chunkY = startChunkY + y;
-
-            if (chunkX >= 0 && chunkX < CHUNKS_X && chunkY >= 0 && chunkY < CHUNKS_Y) {
-                ChunkCoord chunk = { chunkX, chunkY };
-
-                if (exploredChunks.find(chunk) != exploredChunks.end()) {
-                    // Sample biome from center of chunk
-                    int sampleX = chunkX * CHUNK_SIZE + CHUNK_SIZE / 2;
-                    int sampleY = chunkY * CHUNK_SIZE + CHUNK_SIZE / 2;
-                    BiomeType biome = gameMap.determineBiome(sampleX, sampleY);
-
-                    sf::RectangleShape chunkRect;
-                    chunkRect.setSize({ static_cast<float>(MAP_TILE_SIZE), static_cast<float>(MAP_TILE_SIZE) });
-                    chunkRect.setFillColor(getBiomeColor(biome));
-                    chunkRect.setPosition({
-                        mapStartX + x * MAP_TILE_SIZE,
-                        mapStartY + y * MAP_TILE_SIZE
-                        });
-                    window.draw(chunkRect);
-                }
+            std::int64_t chunkX = startChunkX + x;
+            std::int64_t chunkY = startChunkY + y;
+
+            // Center tile of each explored chunk, sampled by the simulation
+            TileType tileType;
+            if (exploredMap.getCell(chunkX, chunkY, tileType)) {
+                sf::RectangleShape chunkRect;
+                chunkRect.setSize({ static_cast<float>(MAP_TILE_SIZE), static_cast<float>(MAP_TILE_SIZE) });
+                chunkRect.setFillColor(getTileColor(tileType));
+                chunkRect.setPosition({
+                    mapStartX + x * MAP_TILE_SIZE,
+                    mapStartY + y * MAP_TILE_SIZE
+                    });
+                window.draw(chunkRect);
             }
         }
     }
@@ -927,11 +961,23 @@ bool UI::isCraftingOpen() const {
     return craftingOpen;
 }
 
-void UI::update(const Player& player, int loadedChunks) {
-    sf::Vector2f worldPos = player.getWorldPosition();
+void UI::getExploredMapExtent(int& halfWidth, int& halfHeight) const {
+    if (mapOpen) {
+        // Same layout as drawFullMap
+        halfWidth = static_cast<int>((mapBackground.getSize().x - 20) / MAP_TILE_SIZE) / 2;
+        halfHeight = static_cast<int>((mapBackground.getSize().y - 50) / MAP_TILE_SIZE) / 2;
+    }
+    else {
+        halfWidth = MINIMAP_RANGE;
+        halfHeight = MINIMAP_RANGE;
+    }
+}
+
+void UI::update(const PlayerView& player, int loadedChunks) {
+    sf::Vector2i tile = tileOf(player.position);
     std::string sprintStatus = player.sprinting ? " (SPRINTING)" : "";
-    positionText.setString("Position: (" + std::to_string(static_cast<int>(worldPos.x)) +
-        ", " + std::to_string(static_cast<int>(worldPos.y)) + ")" + sprintStatus);
+    positionText.setString("Position: (" + std::to_string(tile.x) +
+        ", " + std::to_string(tile.y) + ")" + sprintStatus);
 
     chunkText.setString("Loaded Chunks: " + std::to_string(loadedChunks));
 
@@ -942,21 +988,40 @@ void UI::update(const Player& player, int loadedChunks) {
         frameCount = 0;
         fpsTimer.restart();
     }
+}
 
-    // Mark current chunk as explored
-    ChunkCoord currentChunk = {
-        static_cast<int>(worldPos.x) / CHUNK_SIZE,
-        static_cast<int>(worldPos.y) / CHUNK_SIZE
-    };
-    markChunkExplored(currentChunk);
+void UI::setRenderStats(float zoom, int drawCalls, float simulationMilliseconds, int entityCount, float flowFieldMilliseconds) {
+    std::string zoomText = std::to_string(zoom);
+    zoomText = zoomText.substr(0, zoomText.find('.') + 2);
+    std::string stepText = std::to_string(simulationMilliseconds);
+    stepText = stepText.substr(0, stepText.find('.') + 3);
+    std::string flowText = std::to_string(flowFieldMilliseconds);
+    flowText = flowText.substr(0, flowText.find('.') + 3);
+    renderText.setString("Zoom: " + zoomText + "x | Draw calls: " + std::to_string(drawCalls) + " | Sim step: " + stepText + " ms" +
+        " | Entities: " + std::to_string(entityCount) + " | Flow field: " + flowText + " ms");
+}
+
+void UI::setStreamingStats(const StreamingStats& stats, const ChunkCacheStats& cacheStats) {
+    streamingText.setString("Missing visible: " + std::to_string(stats.framesWithMissingVisible) +
+        "/" + std::to_string(stats.frames) + " frames | Loaded: " + std::to_string(stats.chunksLoaded) +
+        " (prefetched " + std::to_string(stats.chunksPrefetched) + ") | Unloaded: " + std::to_string(stats.chunksUnloaded) +
+        " | Cache: " + std::to_string(cacheStats.hits) + " hits, " + std::to_string(cacheStats.misses) + " misses, " +
+        std::to_string(cacheStats.entries) + " chunks in " + std::to_string(cacheStats.usedBytes / 1024) + " KB");
 }
 
-void UI::draw(sf::RenderWindow& window, const Player& player, const Map& gameMap) {
+void UI::draw(sf::RenderWindow& window, const FrameSnapshot& frame) {
+    const PlayerView& player = frame.player;
+
+    // Highlight the F-key harvest target while still in world space
+    drawHarvestTargetHighlight(window, player, frame.origin);
+
     sf::View originalView = window.getView();
     window.setView(window.getDefaultView());
 
     positionText.setPosition({ 10, 10 });
     chunkText.setPosition({ 10, 30 });
+    renderText.setPosition({ 10, 50 });
+    streamingText.setPosition({ 10, 70 });
     instructionText.setPosition({ 10, static_cast<float>(window.getSize().y - 50) });
 
     sf::FloatRect fpsRect = fpsText.getLocalBounds();
@@ -967,14 +1032,16 @@ void UI::draw(sf::RenderWindow& window, const Player& player, const Map& gameMap
 
     window.draw(positionText);
     window.draw(chunkText);
+    window.draw(renderText);
+    window.draw(streamingText);
     window.draw(instructionText);
     window.draw(fpsText);
 
     // Draw minimap (always visible)
-    drawMinimap(window, player, gameMap);
+    drawMinimap(window, player, frame.exploredMap);
 
     // Draw full map (only when open)
-    drawFullMap(window, player, gameMap);
+    drawFullMap(window, player, frame.exploredMap);
 
     // Draw hotbar (always visible at bottom)
     drawHotbar(window, player);
@@ -8,6 +8,9 @@
 #include "utils.h"
 #include "player.h"
 #include "map.h"
+#include "input.h"
+#include "snapshot.h"
+#include "threading.h"
 
 class UI {
 public:
@@ -16,12 +19,13 @@ public:
     sf::Text chunkText;
     sf::Text instructionText;
     sf::Text fpsText;
+    sf::Text renderText;
+    sf::Text streamingText;
     sf::Clock fpsTimer;
     int frameCount = 0;
     float fpsUpdateInterval = 1.0f;
 
     // Map system
-    std::unordered_map<ChunkCoord, bool, ChunkCoordHash> exploredChunks;
     bool mapOpen = false;
     sf::RectangleShape minimapBackground;
     sf::RectangleShape mapBackground;
@@ -47,6 +51,7 @@ public:
     sf::Texture itemWoodPickaxeTexture;
     sf::Texture itemWoodAxeTexture;
     sf::Texture itemDirtTexture;
+    sf::Texture itemTorchTexture;   // Painted by drawTorch, no file needed
     bool useItemTextures = false;
 
     // Crafting UI specific
@@ -55,6 +60,9 @@ public:
     std::unique_ptr<sf::Sprite> craftButtonSprite; // Changed to unique_ptr
     int selectedCraftingRecipeIndex = -1; // -1 means no recipe selected
 
+    // Auto-target highlight (drawn in world space)
+    sf::RectangleShape harvestTargetHighlight;
+
     // Inventory interaction
     int draggedSlot = -1;
     int draggedToolSlot = -1;
@@ -80,25 +88,26 @@ public:
 
     UI();
 
-    void markChunkExplored(ChunkCoord chunk);
     sf::Color getBiomeColor(BiomeType biome);
+    sf::Color getTileColor(TileType tileType);
     sf::Color getItemColor(int itemId);
-    void drawMinimap(sf::RenderWindow& window, const Player& player, const Map& gameMap);
-    void drawFullMap(sf::RenderWindow& window, const Player& player, const Map& gameMap);
-    void drawHotbar(sf::RenderWindow& window, const Player& player);
-    void drawInventory(sf::RenderWindow& window, const Player& player);
-    void drawCrafting(sf::RenderWindow& window, const Player& player);
-    void drawToolSlots(sf::RenderWindow& window, const Player& player);
+    void drawMinimap(sf::RenderWindow& window, const PlayerView& player, const ExploredMapView& exploredMap);
+    void drawFullMap(sf::RenderWindow& window, const PlayerView& player, const ExploredMapView& exploredMap);
+    void drawHotbar(sf::RenderWindow& window, const PlayerView& player);
+    void drawInventory(sf::RenderWindow& window, const PlayerView& player);
+    void drawCrafting(sf::RenderWindow& window, const PlayerView& player);
+    void drawToolSlots(sf::RenderWindow& window, const PlayerView& player);
     void drawInventorySlot(sf::RenderWindow& window, const InventorySlot& slot, sf::Vector2f position, bool selected = false);
-    void drawDraggedItem(sf::RenderWindow& window, const Player& player, sf::Vector2f mousePos);
-    void drawHarvestProgressBar(sf::RenderWindow& window, const Player& player);
+    void drawDraggedItem(sf::RenderWindow& window, const PlayerView& player, sf::Vector2f mousePos);
+    void drawHarvestProgressBar(sf::RenderWindow& window, const PlayerView& player);
+    void drawHarvestTargetHighlight(sf::RenderWindow& window, const PlayerView& player, const RenderOrigin& origin);
 
     // Inventory interaction methods
     int getSlotAtPosition(sf::Vector2f mousePos, sf::Vector2f inventoryPos);
     int getToolSlotAtPosition(sf::Vector2f mousePos, sf::Vector2f toolSlotsPos);
     int getCraftingRecipeAtPosition(sf::Vector2f mousePos, sf::Vector2f craftingPos);
     bool isCraftButtonAtPosition(sf::Vector2f mousePos, sf::Vector2f craftingPos);
-    void handleInventoryClick(sf::Vector2f mousePos, Player& player, bool isPressed);
+    void handleInventoryClick(sf::Vector2f mousePos, const PlayerView& player, bool isPressed, SpscQueue<InputCommand>& commands);
 
     void toggleMap();
     void closeMap();
@@ -112,8 +121,11 @@ public:
     void closeCrafting();
     bool isCraftingOpen() const;
 
-    void update(const Player& player, int loadedChunks);
-    void draw(sf::RenderWindow& window, const Player& player, const Map& gameMap);
+    void getExploredMapExtent(int& halfWidth, int& halfHeight) const; // Chunks the simulation should sample around the player
+    void update(const PlayerView& player, int loadedChunks);
+    void setRenderStats(float zoom, int drawCalls, float simulationMilliseconds, int entityCount, float flowFieldMilliseconds);
+    void setStreamingStats(const StreamingStats& stats, const ChunkCacheStats& cacheStats);
+    void draw(sf::RenderWindow& window, const FrameSnapshot& frame);
 };
 
 #endif
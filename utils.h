@@ -2,11 +2,22 @@
 #define UTILS_H
 
 #include <functional>
+#include <cstdint>
+#include <unordered_map>
+#include <chrono>
 #include "chunk.h"
 
 struct ChunkCoordHash {
     std::size_t operator()(const ChunkCoord& coord) const {
-        return std::hash<int>()(coord.x) ^ (std::hash<int>()(coord.y) << 1);
+        // x spread by the golden ratio, y folded in, then splitmix64's finalizer so every input bit
+        // reaches the low bits the buckets use; std::hash of an integer is usually the identity
+        std::uint64_t hash = static_cast<std::uint64_t>(coord.x) * 0x9E3779B97F4A7C15ull ^ static_cast<std::uint64_t>(coord.y);
+        hash ^= hash >> 30;
+        hash *= 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 27;
+        hash *= 0x94D049BB133111EBull;
+        hash ^= hash >> 31;
+        return static_cast<std::size_t>(hash);
     }
 };
 
@@ -16,4 +27,11 @@ struct PairHash {
     }
 };
 
+// Chunks the player has visited, for the minimap and full map
+using ExploredChunks = std::unordered_map<ChunkCoord, bool, ChunkCoordHash>;
+
+inline double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
 #endif
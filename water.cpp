@@ -0,0 +1,176 @@
+#include "water.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WATER_SSE2 1
+#endif
+
+void WaterSimulation::buildPadded(const LoadedChunks& chunks, const Chunk& chunk) {
+    std::memset(&padded, 0, sizeof(padded));
+
+    auto findChunk = [&chunks](std::int64_t chunkX, std::int64_t chunkY) -> const Chunk* {
+        auto chunkIt = chunks.find({ chunkX, chunkY });
+        return (chunkIt != chunks.end()) ? chunkIt->second.get() : nullptr;
+    };
+
+    // Unloaded or missing neighbors are dry walls, so nothing flows across that edge
+    auto fill = [this](const Chunk* source, int tileX, int tileY, int paddedX, int paddedY) {
+        if (!source) {
+            return;
+        }
+        TileType tileType = source->tileTypes[tileY][tileX];
+        if (tileType == TileType::WATER) {
+            padded.level[paddedY][paddedX] = 0xFF;
+            padded.flowable[paddedY][paddedX] = 0xFF;
+            padded.source[paddedY][paddedX] = 0xFF;
+        }
+        else if (tileType == TileType::DIRT) {
+            padded.level[paddedY][paddedX] = source->waterLevels[tileY][tileX];
+            padded.flowable[paddedY][paddedX] = 0xFF;
+        }
+    };
+
+    for (int y = 0; y < CHUNK_SIZE; y++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            fill(&chunk, x, y, x + 1, y + 1);
+        }
+    }
+
+    // Edge rows and columns of the four direct neighbors; corners are never read
+    const Chunk* north = findChunk(chunk.coord.x, chunk.coord.y - 1);
+    const Chunk* south = findChunk(chunk.coord.x, chunk.coord.y + 1);
+    const Chunk* west = findChunk(chunk.coord.x - 1, chunk.coord.y);
+    const Chunk* east = findChunk(chunk.coord.x + 1, chunk.coord.y);
+    for (int i = 0; i < CHUNK_SIZE; i++) {
+        fill(north, i, CHUNK_SIZE - 1, i + 1, 0);
+        fill(south, i, 0, i + 1, PADDED - 1);
+        fill(west, CHUNK_SIZE - 1, i, 0, i + 1);
+        fill(east, 0, i, PADDED - 1, i + 1);
+    }
+}
+
+void WaterSimulation::stepRowsScalar(StepResult& result) const {
+    static const int OFFSETS[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+
+    for (int y = 1; y <= CHUNK_SIZE; y++) {
+        for (int x = 1; x <= CHUNK_SIZE; x++) {
+            int level = padded.level[y][x];
+            int flowable = padded.flowable[y][x];
+            int outflow = 0;
+            int inflow = 0;
+
+            for (const auto& offset : OFFSETS) {
+                int neighborLevel = padded.level[y + offset[1]][x + offset[0]];
+                int neighborFlowable = padded.flowable[y + offset[1]][x + offset[0]];
+                if (level > neighborLevel) {
+                    outflow += ((level - neighborLevel) >> 3) & neighborFlowable;
+                }
+                else {
+                    inflow += ((neighborLevel - level) >> 3) & flowable;
+                }
+            }
+
+            // Outflow is at most half the level and inflow at most half the headroom, so this stays in 0-255
+            int newLevel = (level - outflow + inflow) & flowable;
+            result.level[y - 1][x - 1] = static_cast<std::uint8_t>(std::max<int>(newLevel, padded.source[y][x]));
+        }
+    }
+}
+
+void WaterSimulation::stepRowsVectorized(StepResult& result) const {
+#ifdef WATER_SSE2
+    // Same arithmetic as stepRowsScalar on 16 tiles of a row at once. None of the sums
+    // can leave 0-255, so the saturating byte operations give the exact scalar result.
+    if (CHUNK_SIZE % 16 != 0) {
+        stepRowsScalar(result); // Rows of 8 are too short for a vector
+        return;
+    }
+    const __m128i lowFiveBits = _mm_set1_epi8(0x1F);
+    auto eighth = [&lowFiveBits](__m128i value) {
+        return _mm_and_si128(_mm_srli_epi16(value, 3), lowFiveBits);
+    };
+    auto load = [](const std::uint8_t* bytes) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    };
+
+    for (int y = 1; y <= CHUNK_SIZE; y++) {
+        for (int x = 1; x <= CHUNK_SIZE; x += 16) {
+            __m128i level = load(&padded.level[y][x]);
+            __m128i flowable = load(&padded.flowable[y][x]);
+            __m128i outflow = _mm_setzero_si128();
+            __m128i inflow = _mm_setzero_si128();
+
+            auto exchange = [&](__m128i neighborLevel, __m128i neighborFlowable) {
+                outflow = _mm_adds_epu8(outflow, _mm_and_si128(eighth(_mm_subs_epu8(level, neighborLevel)), neighborFlowable));
+                inflow = _mm_adds_epu8(inflow, _mm_and_si128(eighth(_mm_subs_epu8(neighborLevel, level)), flowable));
+            };
+            exchange(load(&padded.level[y - 1][x]), load(&padded.flowable[y - 1][x]));
+            exchange(load(&padded.level[y + 1][x]), load(&padded.flowable[y + 1][x]));
+            exchange(load(&padded.level[y][x - 1]), load(&padded.flowable[y][x - 1]));
+            exchange(load(&padded.level[y][x + 1]), load(&padded.flowable[y][x + 1]));
+
+            __m128i newLevel = _mm_and_si128(_mm_adds_epu8(_mm_subs_epu8(level, outflow), inflow), flowable);
+            newLevel = _mm_max_epu8(newLevel, load(&padded.source[y][x]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&result.level[y - 1][x - 1]), newLevel);
+        }
+    }
+#else
+    stepRowsScalar(result);
+#endif
+}
+
+void WaterSimulation::step(LoadedChunks& chunks, std::vector<ChunkCoord>& changedChunks, std::vector<sf::Vector2i>& floodedTiles) {
+    changedChunks.clear();
+    floodedTiles.clear();
+    if (active.empty()) {
+        return;
+    }
+
+    // Dirty chunks and their neighbors, the ones water can reach this step
+    steppingSet.clear();
+    stepping.clear();
+    static const int OFFSETS[5][2] = { { 0, 0 }, { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+    for (ChunkCoord coord : active) {
+        for (const auto& offset : OFFSETS) {
+            ChunkCoord neighbor = { coord.x + offset[0], coord.y + offset[1] };
+            auto chunkIt = chunks.find(neighbor);
+            if (chunkIt != chunks.end() && steppingSet.insert(neighbor).second) {
+                stepping.push_back(chunkIt->second.get());
+            }
+        }
+    }
+
+    // Every chunk steps from the old levels before any are written back
+    results.resize(stepping.size());
+    for (size_t i = 0; i < stepping.size(); i++) {
+        buildPadded(chunks, *stepping[i]);
+        if (vectorized) {
+            stepRowsVectorized(results[i]);
+        }
+        else {
+            stepRowsScalar(results[i]);
+        }
+    }
+
+    active.clear();
+    for (size_t i = 0; i < stepping.size(); i++) {
+        Chunk& chunk = *stepping[i];
+        if (std::memcmp(results[i].level, chunk.waterLevels, sizeof(chunk.waterLevels)) == 0) {
+            continue;
+        }
+
+        std::memcpy(chunk.waterLevels, results[i].level, sizeof(chunk.waterLevels));
+        active.insert(chunk.coord);
+        changedChunks.push_back(chunk.coord);
+
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                if (chunk.tileTypes[y][x] == TileType::DIRT && chunk.waterLevels[y][x] >= WATER_FLOOD_LEVEL) {
+                    floodedTiles.push_back(chunkTileToWorld(chunk.coord, x, y));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef WATER_H
+#define WATER_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include "constants.h"
+#include "chunk.h"
+#include "utils.h"
+
+using LoadedChunks = std::unordered_map<ChunkCoord, std::unique_ptr<Chunk>, ChunkCoordHash>;
+
+// Cellular-automaton water on the tile grid. Every DIRT tile holds a fill level
+// (Chunk::waterLevels, 0-255); WATER tiles are sources pinned at 255 and everything else
+// stays dry. Each step, a tile passes an eighth of its level difference to each lower
+// neighbor, computed from the previous step's levels so flow between chunks is symmetric.
+//
+// Only dirty chunks are stepped: those whose levels changed last step or that were woken
+// by a tile change, plus their neighbors. A world with no flow costs nothing. Rows are
+// one byte per tile, so on SSE2 a chunk row is stepped 16 tiles to a vector.
+class WaterSimulation {
+public:
+    bool vectorized = true; // The scalar path is for platforms without SSE2, and for comparison
+
+    void wake(ChunkCoord chunk) { active.insert(chunk); }
+    void clear() { active.clear(); }
+
+    // One step over the dirty chunks. Reports the chunks whose levels changed and the
+    // DIRT tiles (world coordinates) that filled past WATER_FLOOD_LEVEL.
+    void step(LoadedChunks& chunks, std::vector<ChunkCoord>& changedChunks, std::vector<sf::Vector2i>& floodedTiles);
+
+    size_t getActiveChunks() const { return active.size(); }
+    size_t getLastSteppedChunks() const { return stepping.size(); }
+
+private:
+    static const int PADDED = CHUNK_SIZE + 2; // One tile of halo on every side
+
+    // A chunk's levels and flow masks with the neighbors' edge tiles around them
+    struct PaddedChunk {
+        std::uint8_t level[PADDED][PADDED];
+        std::uint8_t flowable[PADDED][PADDED]; // 0xFF where water can be
+        std::uint8_t source[PADDED][PADDED];   // 0xFF on WATER tiles
+    };
+
+    struct StepResult {
+        std::uint8_t level[CHUNK_SIZE][CHUNK_SIZE];
+    };
+
+    std::unordered_set<ChunkCoord, ChunkCoordHash> active;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> steppingSet;
+    std::vector<Chunk*> stepping;
+    std::vector<StepResult> results;
+    PaddedChunk padded;
+
+    void buildPadded(const LoadedChunks& chunks, const Chunk& chunk);
+    void stepRowsScalar(StepResult& result) const;
+    void stepRowsVectorized(StepResult& result) const;
+};
+
+#endif
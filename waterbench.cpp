@@ -0,0 +1,130 @@
+// Water benchmark: floods a square of mined-out dirt chunks from a water edge and times the
+// water steps, once with the vectorized row stepping and once with the scalar one.
+//
+// Usage: waterbench [CHUNKS] [--steps N]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include "constants.h"
+#include "water.h"
+#include "benchutil.h"
+
+namespace {
+    struct FloodRun {
+        double totalMilliseconds = 0.0;
+        double maxMilliseconds = 0.0;
+        long long chunkSteps = 0;
+        int steps = 0;
+        int floodedTiles = 0;
+        LoadedChunks chunks;
+    };
+
+    // Every tile is dirt except a water column along the west edge
+    LoadedChunks buildArea(int areaChunks) {
+        LoadedChunks chunks;
+        for (int chunkY = 0; chunkY < areaChunks; chunkY++) {
+            for (int chunkX = 0; chunkX < areaChunks; chunkX++) {
+                auto chunk = std::make_unique<Chunk>(ChunkCoord{ chunkX, chunkY });
+                for (int y = 0; y < CHUNK_SIZE; y++) {
+                    for (int x = 0; x < CHUNK_SIZE; x++) {
+                        chunk->tileTypes[y][x] = (chunkX == 0 && x == 0) ? TileType::WATER : TileType::DIRT;
+                    }
+                }
+                chunks[chunk->coord] = std::move(chunk);
+            }
+        }
+        return chunks;
+    }
+
+    FloodRun runFlood(int areaChunks, int maxSteps, bool vectorized) {
+        FloodRun run;
+        run.chunks = buildArea(areaChunks);
+
+        WaterSimulation water;
+        water.vectorized = vectorized;
+        for (int chunkY = 0; chunkY < areaChunks; chunkY++) {
+            water.wake({ 0, chunkY });
+        }
+
+        std::vector<ChunkCoord> changedChunks;
+        std::vector<sf::Vector2i> floodedTiles;
+        for (; run.steps < maxSteps && water.getActiveChunks() > 0; run.steps++) {
+            auto start = std::chrono::steady_clock::now();
+            water.step(run.chunks, changedChunks, floodedTiles);
+            double milliseconds = millisecondsSince(start);
+
+            run.totalMilliseconds += milliseconds;
+            run.maxMilliseconds = std::max(run.maxMilliseconds, milliseconds);
+            run.chunkSteps += static_cast<long long>(water.getLastSteppedChunks());
+
+            // What Map::stepWater does through replaceTile
+            for (sf::Vector2i tile : floodedTiles) {
+                ChunkCoord coord = { tile.x / CHUNK_SIZE, tile.y / CHUNK_SIZE };
+                run.chunks[coord]->tileTypes[tile.y % CHUNK_SIZE][tile.x % CHUNK_SIZE] = TileType::WATER;
+                water.wake(coord);
+            }
+            run.floodedTiles += static_cast<int>(floodedTiles.size());
+        }
+        return run;
+    }
+
+    void report(const std::string& name, const FloodRun& run) {
+        std::cout << name << ": " << run.steps << " steps, " << run.floodedTiles << " tiles flooded, "
+            << run.totalMilliseconds / std::max(1, run.steps) << " ms/step avg, " << run.maxMilliseconds << " ms max, "
+            << run.totalMilliseconds * 1e6 / std::max(1LL, run.chunkSteps) << " ns per chunk step ("
+            << run.chunkSteps / std::max(1, run.steps) << " chunks/step avg)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int areaChunks = 64;
+    int maxSteps = 3000;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--steps" && hasValue) maxSteps = std::max(1, std::atoi(argv[++i]));
+        else if (!arg.empty() && arg[0] != '-') areaChunks = std::max(1, std::atoi(arg.c_str()));
+        else {
+            std::cout << "Usage: waterbench [CHUNKS] [--steps N]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Flooding " << areaChunks << "x" << areaChunks << " chunks of dirt from the west edge, up to "
+        << maxSteps << " steps" << std::endl;
+
+    FloodRun vectorized = runFlood(areaChunks, maxSteps, true);
+    report("Vectorized", vectorized);
+    FloodRun scalar = runFlood(areaChunks, maxSteps, false);
+    report("Scalar", scalar);
+
+    // Both paths must produce the same world
+    bool identical = vectorized.steps == scalar.steps;
+    for (const auto& entry : vectorized.chunks) {
+        const Chunk& a = *entry.second;
+        const Chunk& b = *scalar.chunks[entry.first];
+        identical = identical && std::memcmp(a.waterLevels, b.waterLevels, sizeof(a.waterLevels)) == 0 &&
+            std::memcmp(a.tileTypes, b.tileTypes, sizeof(a.tileTypes)) == 0;
+    }
+    std::cout << "Vectorized and scalar results " << (identical ? "match" : "DIFFER") << std::endl;
+
+    // A settled world is not stepped at all
+    WaterSimulation quiet;
+    std::vector<ChunkCoord> changedChunks;
+    std::vector<sf::Vector2i> floodedTiles;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100000; i++) {
+        quiet.step(vectorized.chunks, changedChunks, floodedTiles);
+    }
+    double quietNanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / 100000;
+    std::cout << "Quiet world: " << quietNanoseconds << " ns/step" << std::endl;
+
+    return identical ? 0 : 1;
+}
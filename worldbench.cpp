@@ -0,0 +1,130 @@
+// Infinite world benchmark: walks a straight line out from spawn across an infinite world,
+// streaming, ticking and lighting the map the way the simulation does every tick, and
+// reports step times, what is resident and the process's memory every so often. Everything
+// but the edits should stay flat however far the walk goes.
+//
+// Usage: worldbench [--tiles N] [--speed TILES_PER_TICK] [--reports N] [--world PATH]
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+
+#include "constants.h"
+#include "map.h"
+#include "player.h"
+#include "benchutil.h"
+
+namespace {
+    // Resident set size in KB, or -1 where /proc isn't available
+    long residentKilobytes() {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmRSS:", 0) == 0) {
+                return std::atol(line.c_str() + 6);
+            }
+        }
+        return -1;
+    }
+
+    void report(const Map& gameMap, double walkedTiles, WorldVector position, const std::vector<double>& stepTimes) {
+        size_t noiseEntries = gameMap.generator.noiseCache.size();
+        size_t riverFields = gameMap.generator.riverFields.size();
+        for (const WorldGenerator& workerGenerator : gameMap.workerGenerators) {
+            noiseEntries += workerGenerator.noiseCache.size();
+            riverFields += workerGenerator.riverFields.size();
+        }
+        const ChunkCacheStats& cacheStats = gameMap.chunkCache.getStats();
+        sf::Vector2i tile = tileOf(position);
+
+        std::cout << static_cast<long long>(walkedTiles) << " tiles, at (" << tile.x << ", " << tile.y << "): "
+            << gameMap.loadedChunks.size() << " loaded, " << gameMap.interest.getTrackedChunks() << " tracked, "
+            << cacheStats.entries << " cached (" << cacheStats.usedBytes / 1024 << " KB), "
+            << gameMap.generatedTileCache.size() << " generated tiles, " << noiseEntries << " noise values, " << riverFields << " river fields, "
+            << gameMap.pathFinder.getCachedChunks() << " path graphs, " << gameMap.worldTicker.getScheduledEvents() << " tick events, "
+            << residentKilobytes() / 1024 << " MB resident | step " << percentile(stepTimes, 0.5) << " ms p50, "
+            << percentile(stepTimes, 0.99) << " ms p99, " << percentile(stepTimes, 1.0) << " ms max" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    double totalTiles = 1000000.0;
+    double speed = 1.0;     // Tiles per tick; a sprint is a few tiles a second, so this is a fast walk
+    int reports = 10;
+    std::string worldPath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--tiles" && hasValue) totalTiles = std::max(1.0, std::atof(argv[++i]));
+        else if (arg == "--speed" && hasValue) speed = std::max(0.01, std::atof(argv[++i]));
+        else if (arg == "--reports" && hasValue) reports = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--world" && hasValue) worldPath = argv[++i];
+        else {
+            std::cout << "Usage: worldbench [--tiles N] [--speed TILES_PER_TICK] [--reports N] [--world PATH]" << std::endl;
+            return 1;
+        }
+    }
+
+    Map gameMap(true);
+    Player player(true);
+    if (!worldPath.empty()) {
+        gameMap.openBakedWorld(worldPath);
+    }
+    gameMap.setInfinite(true);
+    player.findSafeSpawnPosition(gameMap);
+
+    // Up and to the left, so the walk crosses into negative coordinates early; the streamer
+    // may load as much per tick as it needs to keep up
+    WorldVector direction = { -0.8, -0.6 };
+    sf::Vector2f velocity = { static_cast<float>(direction.x * speed * TILE_SIZE * 60.0), static_cast<float>(direction.y * speed * TILE_SIZE * 60.0) };
+    gameMap.streamer.loadsPerFrame = 8;
+    gameMap.streamer.catchUpLoadsPerFrame = 32;
+
+    WorldVector start = player.getPosition();
+    WorldVector tileSize{ static_cast<double>(TILE_SIZE), static_cast<double>(TILE_SIZE) };
+    const sf::Vector2f viewSize{ 2560, 1440 };
+    long long ticks = static_cast<long long>(std::ceil(totalTiles / speed));
+    long long ticksPerReport = std::max(1LL, ticks / reports);
+    std::cout << "Walking " << static_cast<long long>(totalTiles) << " tiles from (" << tileOf(start).x << ", " << tileOf(start).y
+        << ") in " << ticks << " ticks" << std::endl;
+
+    std::vector<double> stepTimes;
+    auto benchStart = std::chrono::steady_clock::now();
+    for (long long tick = 1; tick <= ticks; tick++) {
+        WorldVector position = start + direction * (static_cast<double>(tick) * speed * TILE_SIZE);
+
+        auto stepStart = std::chrono::steady_clock::now();
+        gameMap.loadChunksAroundPlayer(position, velocity);
+        gameMap.unloadDistantChunks(position, velocity);
+        gameMap.tickWorld(tick, { WorldRect(position - tileSize / 2.0, tileSize) });
+        if (tick % WATER_STEP_TICKS == 0) {
+            gameMap.stepWater();
+        }
+        gameMap.updateLighting();
+        gameMap.flowField.update(gameMap, tileOf(position));
+
+        // The streamer catches up on frames that showed a missing chunk
+        int startX, startY, endX, endY;
+        Map::getVisibleTileRange(position, viewSize, startX, startY, endX, endY);
+        gameMap.streamer.recordVisibility(gameMap, floorDiv(startX, CHUNK_SIZE), floorDiv(startY, CHUNK_SIZE),
+            floorDiv(endX - 1, CHUNK_SIZE), floorDiv(endY - 1, CHUNK_SIZE));
+        stepTimes.push_back(millisecondsSince(stepStart));
+
+        if (tick % ticksPerReport == 0 || tick == ticks) {
+            report(gameMap, static_cast<double>(tick) * speed, position, stepTimes);
+            stepTimes.clear();
+        }
+    }
+
+    const StreamingStats& stats = gameMap.streamer.stats;
+    std::cout << "Done in " << millisecondsSince(benchStart) / 1000.0 << " s: " << stats.chunksLoaded << " chunks loaded, "
+        << stats.chunksUnloaded << " unloaded, " << stats.framesWithMissingVisible << "/" << stats.frames
+        << " ticks with a visible chunk missing" << std::endl;
+    return 0;
+}
@@ -0,0 +1,116 @@
+#ifndef WORLDCOORDS_H
+#define WORLDCOORDS_H
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <cmath>
+#include <cstdlib>
+#include "constants.h"
+
+// 64-bit so chunk coordinates never wrap, however far an infinite world is walked. Tile
+// coordinates stay int: chunk * CHUNK_SIZE + local fits for any chunk a tile can be in.
+struct ChunkCoord {
+    std::int64_t x, y;
+
+    bool operator==(const ChunkCoord& other) const {
+        return x == other.x && y == other.y;
+    }
+};
+
+// Simulation positions are world pixels in doubles, exact to well under a pixel at any tile an
+// int can address. Floats (SFML's vertices, the camera) only ever hold positions relative to a
+// RenderOrigin, so they stay small however far from spawn the player is.
+using WorldVector = sf::Vector2<double>;
+using WorldRect = sf::Rect<double>;
+
+// Division and remainder rounding toward negative infinity: tile -1 is tile 15 of chunk -1
+inline int floorDiv(int value, int divisor) {
+    int quotient = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+}
+
+inline int floorMod(int value, int divisor) {
+    int remainder = value % divisor;
+    return (remainder != 0 && (remainder < 0) != (divisor < 0)) ? remainder + divisor : remainder;
+}
+
+inline ChunkCoord chunkOfTile(int worldX, int worldY) {
+    return { floorDiv(worldX, CHUNK_SIZE), floorDiv(worldY, CHUNK_SIZE) };
+}
+
+// Index of a tile within its chunk, y * CHUNK_SIZE + x
+inline int localTileIndex(int worldX, int worldY) {
+    return floorMod(worldY, CHUNK_SIZE) * CHUNK_SIZE + floorMod(worldX, CHUNK_SIZE);
+}
+
+// World tile of a tile within a chunk
+inline sf::Vector2i chunkTileToWorld(ChunkCoord chunk, int localX, int localY) {
+    return { static_cast<int>(chunk.x * CHUNK_SIZE + localX), static_cast<int>(chunk.y * CHUNK_SIZE + localY) };
+}
+
+inline sf::Vector2i tileOf(WorldVector pixels) {
+    return {
+        static_cast<int>(std::floor(pixels.x / TILE_SIZE)),
+        static_cast<int>(std::floor(pixels.y / TILE_SIZE))
+    };
+}
+
+inline ChunkCoord chunkOf(WorldVector pixels) {
+    sf::Vector2i tile = tileOf(pixels);
+    return chunkOfTile(tile.x, tile.y);
+}
+
+inline WorldVector tileCenter(int worldX, int worldY) {
+    return { (worldX + 0.5) * TILE_SIZE, (worldY + 0.5) * TILE_SIZE };
+}
+
+// Floating origin for drawing: a chunk corner that everything on screen is drawn relative
+// to. The simulation moves it with the player in steps of RENDER_ORIGIN_REBASE_CHUNKS and
+// publishes it with each frame, so the camera, chunk meshes and sprites of one frame always
+// share the same origin.
+struct RenderOrigin {
+    ChunkCoord chunk{ 0, 0 };
+
+    WorldVector getPixels() const {
+        return { static_cast<double>(chunk.x) * CHUNK_SIZE * TILE_SIZE, static_cast<double>(chunk.y) * CHUNK_SIZE * TILE_SIZE };
+    }
+
+    sf::Vector2f toLocal(WorldVector pixels) const {
+        WorldVector local = pixels - getPixels();
+        return { static_cast<float>(local.x), static_cast<float>(local.y) };
+    }
+
+    WorldVector toWorld(sf::Vector2f local) const {
+        return getPixels() + WorldVector(local);
+    }
+
+    // Top-left corner of a tile; the subtraction is done in whole tiles, so it is exact
+    sf::Vector2f tileToLocal(int worldX, int worldY) const {
+        return {
+            static_cast<float>((worldX - chunk.x * CHUNK_SIZE) * TILE_SIZE),
+            static_cast<float>((worldY - chunk.y * CHUNK_SIZE) * TILE_SIZE)
+        };
+    }
+
+    sf::Vector2f chunkToLocal(ChunkCoord coord) const {
+        return {
+            static_cast<float>((coord.x - chunk.x) * CHUNK_SIZE * TILE_SIZE),
+            static_cast<float>((coord.y - chunk.y) * CHUNK_SIZE * TILE_SIZE)
+        };
+    }
+
+    sf::Vector2i localToTile(sf::Vector2f local) const {
+        return tileOf(toWorld(local));
+    }
+
+    // Rebases once the player is more than RENDER_ORIGIN_REBASE_CHUNKS from the origin
+    void follow(WorldVector playerPixels) {
+        ChunkCoord playerChunk = chunkOf(playerPixels);
+        if (std::llabs(playerChunk.x - chunk.x) > RENDER_ORIGIN_REBASE_CHUNKS ||
+            std::llabs(playerChunk.y - chunk.y) > RENDER_ORIGIN_REBASE_CHUNKS) {
+            chunk = playerChunk;
+        }
+    }
+};
+
+#endif
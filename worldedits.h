@@ -0,0 +1,24 @@
+#ifndef WORLDEDITS_H
+#define WORLDEDITS_H
+
+#include <unordered_map>
+#include <memory>
+#include "constants.h"
+#include "utils.h"
+
+// Tile edits for one chunk, keyed by local tile index (y * CHUNK_SIZE + x)
+using ChunkEdits = std::unordered_map<int, TileType>;
+
+// Every tile edit in the world (felled trees, mined stone). Shared copy-on-write:
+// a save snapshot just keeps a reference, and Map clones only what is still shared
+// the next time it writes.
+struct WorldEdits {
+    std::unordered_map<ChunkCoord, std::shared_ptr<ChunkEdits>, ChunkCoordHash> chunks;
+
+    const ChunkEdits* find(ChunkCoord coord) const {
+        auto it = chunks.find(coord);
+        return (it != chunks.end()) ? it->second.get() : nullptr;
+    }
+};
+
+#endif
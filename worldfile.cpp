@@ -0,0 +1,182 @@
+#include "worldfile.h"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::uint64_t alignToPage(std::uint64_t offset) {
+        return (offset + BAKED_WORLD_PAGE_SIZE - 1) / BAKED_WORLD_PAGE_SIZE * BAKED_WORLD_PAGE_SIZE;
+    }
+}
+
+BakedWorldHeader makeBakedWorldHeader(std::uint32_t seed, int worldWidth, int worldHeight) {
+    BakedWorldHeader header{};
+    std::memcpy(header.magic, BAKED_WORLD_MAGIC, sizeof(header.magic));
+    header.version = BAKED_WORLD_VERSION;
+    header.seed = seed;
+    header.worldWidth = static_cast<std::uint32_t>(worldWidth);
+    header.worldHeight = static_cast<std::uint32_t>(worldHeight);
+    header.chunkSize = CHUNK_SIZE;
+    header.chunksX = static_cast<std::uint32_t>((worldWidth + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    header.chunksY = static_cast<std::uint32_t>((worldHeight + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    header.indexOffset = sizeof(BakedWorldHeader);
+
+    std::uint64_t chunkCount = static_cast<std::uint64_t>(header.chunksX) * header.chunksY;
+    header.dataOffset = alignToPage(header.indexOffset + chunkCount * sizeof(std::uint64_t));
+    return header;
+}
+
+bool writeBakedWorld(const std::string& path, const BakedWorldHeader& header, const std::vector<TileType>& chunkTiles) {
+    const std::uint64_t chunkBytes = static_cast<std::uint64_t>(header.chunkSize) * header.chunkSize;
+    const std::uint64_t chunkCount = static_cast<std::uint64_t>(header.chunksX) * header.chunksY;
+    if (chunkTiles.size() != chunkCount * chunkBytes) {
+        std::cout << "Baked world data does not match header dimensions" << std::endl;
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Could not open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<std::uint64_t> index(chunkCount);
+    for (std::uint64_t i = 0; i < chunkCount; i++) {
+        index[i] = header.dataOffset + i * chunkBytes;
+    }
+    file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(std::uint64_t));
+
+    // Pad so chunk data starts on a page boundary
+    std::vector<char> padding(header.dataOffset - header.indexOffset - index.size() * sizeof(std::uint64_t), 0);
+    file.write(padding.data(), padding.size());
+
+    file.write(reinterpret_cast<const char*>(chunkTiles.data()), chunkTiles.size());
+    return static_cast<bool>(file);
+}
+
+BakedWorld::~BakedWorld() {
+    close();
+}
+
+bool BakedWorld::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    mappedData = static_cast<const std::uint8_t*>(view);
+    mappedSize = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0 || fileInfo.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<std::size_t>(fileInfo.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    fileDescriptor = fd;
+    mappedData = static_cast<const std::uint8_t*>(view);
+    mappedSize = static_cast<std::size_t>(fileInfo.st_size);
+#endif
+
+    // Validate the header and that the index and data fit in the file
+    if (mappedSize < sizeof(BakedWorldHeader)) {
+        close();
+        return false;
+    }
+    std::memcpy(&header, mappedData, sizeof(header));
+
+    std::uint64_t chunkCount = static_cast<std::uint64_t>(header.chunksX) * header.chunksY;
+    std::uint64_t chunkBytes = static_cast<std::uint64_t>(header.chunkSize) * header.chunkSize;
+    if (std::memcmp(header.magic, BAKED_WORLD_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != BAKED_WORLD_VERSION ||
+        header.chunkSize != static_cast<std::uint32_t>(CHUNK_SIZE) ||
+        header.indexOffset + chunkCount * sizeof(std::uint64_t) > mappedSize ||
+        header.dataOffset + chunkCount * chunkBytes > mappedSize) {
+        std::cout << "Baked world " << path << " is invalid, from an older baker or built for a different chunk size" << std::endl;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void BakedWorld::close() {
+#ifdef _WIN32
+    if (mappedData) UnmapViewOfFile(mappedData);
+    if (mappingHandle) CloseHandle(static_cast<HANDLE>(mappingHandle));
+    if (fileHandle) CloseHandle(static_cast<HANDLE>(fileHandle));
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#else
+    if (mappedData) munmap(const_cast<std::uint8_t*>(mappedData), mappedSize);
+    if (fileDescriptor >= 0) ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+    mappedData = nullptr;
+    mappedSize = 0;
+    header = BakedWorldHeader{};
+}
+
+const TileType* BakedWorld::getChunkTiles(std::int64_t chunkX, std::int64_t chunkY) const {
+    if (!mappedData || chunkX < 0 || chunkY < 0 ||
+        chunkX >= static_cast<std::int64_t>(header.chunksX) || chunkY >= static_cast<std::int64_t>(header.chunksY)) {
+        return nullptr;
+    }
+
+    std::uint64_t offset;
+    std::size_t indexPosition = header.indexOffset + (static_cast<std::size_t>(chunkY) * header.chunksX + chunkX) * sizeof(std::uint64_t);
+    std::memcpy(&offset, mappedData + indexPosition, sizeof(offset));
+    if (offset + static_cast<std::uint64_t>(CHUNK_SIZE) * CHUNK_SIZE > mappedSize) {
+        return nullptr;
+    }
+
+    return reinterpret_cast<const TileType*>(mappedData + offset);
+}
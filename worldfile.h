@@ -0,0 +1,63 @@
+#ifndef WORLDFILE_H
+#define WORLDFILE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "constants.h"
+
+// Prebuilt world file produced by the baker:
+//   header | chunk index (one uint64 offset per chunk, row-major) | page-aligned chunk data
+// Each chunk is CHUNK_SIZE * CHUNK_SIZE one-byte TileType values in row-major order, so a
+// mapped chunk can be read in place without decoding.
+struct BakedWorldHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t seed;
+    std::uint32_t worldWidth;
+    std::uint32_t worldHeight;
+    std::uint32_t chunkSize;
+    std::uint32_t chunksX;
+    std::uint32_t chunksY;
+    std::uint64_t indexOffset;
+    std::uint64_t dataOffset;
+};
+
+const char BAKED_WORLD_MAGIC[4] = { 'S', 'A', 'E', 'W' };
+const std::uint32_t BAKED_WORLD_VERSION = 2; // 2: rivers traced per region (the generator beyond a bake must match it)
+const std::size_t BAKED_WORLD_PAGE_SIZE = 4096;
+
+bool writeBakedWorld(const std::string& path, const BakedWorldHeader& header, const std::vector<TileType>& chunkTiles);
+BakedWorldHeader makeBakedWorldHeader(std::uint32_t seed, int worldWidth, int worldHeight);
+
+// Read-only memory mapping of a baked world; pages are brought in by the OS on first access
+class BakedWorld {
+public:
+    BakedWorld() = default;
+    ~BakedWorld();
+    BakedWorld(const BakedWorld&) = delete;
+    BakedWorld& operator=(const BakedWorld&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return mappedData != nullptr; }
+
+    const BakedWorldHeader& getHeader() const { return header; }
+
+    // Pointer into the mapping, or nullptr outside the baked area
+    const TileType* getChunkTiles(std::int64_t chunkX, std::int64_t chunkY) const;
+
+private:
+    BakedWorldHeader header{};
+    const std::uint8_t* mappedData = nullptr;
+    std::size_t mappedSize = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+};
+
+#endif
@@ -0,0 +1,431 @@
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "worldgen.h"
+
+static_assert(RIVER_REGION_TILES % 64 == 0, "A chunk of any edge lies within one river region");
+
+namespace {
+    // Every noise field a tile reads, as noise(x + offsetX, y + offsetY, scale)
+    enum NoiseField {
+        FIELD_ELEVATION,
+        FIELD_MOISTURE,
+        FIELD_TEMPERATURE,
+        FIELD_RIDGE_1,
+        FIELD_RIDGE_2,
+        FIELD_PEAKS_1,
+        FIELD_PEAKS_2,
+        FIELD_DETAIL,
+        FIELD_COUNT
+    };
+
+    struct NoiseFieldSpec {
+        int offsetX;
+        int offsetY;
+        int scale;
+    };
+
+    const NoiseFieldSpec NOISE_FIELDS[FIELD_COUNT] = {
+        { 0, 0, 150 },       // Elevation
+        { 1000, 1000, 120 }, // Moisture
+        { 2000, 2000, 180 }, // Temperature
+        { 0, 0, 200 },       // Mountain ridges
+        { 500, 500, 150 },
+        { 0, 0, 100 },       // Mountain peaks
+        { 1000, 1000, 120 },
+        { 0, 0, 50 }         // Mountain detail
+    };
+
+    const float MOUNTAIN_THRESHOLD = 0.4f; // Mountain height above which the biome is mountain
+
+    // River courses. Horizontal and vertical rivers run every so many tiles, swinging
+    // sinusoidally with noise on top; diagonal ones follow x + 0.3y = 100 pi k, pushed
+    // sideways by noise. These are where the zeros of the old per-tile distance curves were.
+    const double HORIZONTAL_RIVER_SPACING = 300.0;
+    const double VERTICAL_RIVER_SPACING = 400.0;
+    const double DIAGONAL_RIVER_SPACING = 100.0 * M_PI;
+    const double DIAGONAL_RIVER_SLOPE = 0.3;
+
+    // Single tiles: through the generator's noise cache
+    struct CachedNoise {
+        WorldGenerator& generator;
+
+        float operator()(NoiseField field, int x, int y) const {
+            const NoiseFieldSpec& spec = NOISE_FIELDS[field];
+            return generator.noise(x + spec.offsetX, y + spec.offsetY, spec.scale);
+        }
+
+        float distanceToRiver(int x, int y) const {
+            return generator.getDistanceToRiver(x, y);
+        }
+    };
+
+    // Whole chunks: each field's lattice cells overlapping the chunk, computed up front.
+    // A sample outside them (which the bounds rule out) still gets the right value from the cache.
+    struct BlockNoise {
+        struct Block {
+            int cellX = 0;
+            int cellY = 0;
+            int width = 0;
+            int height = 0;
+            std::vector<float> values;
+        };
+
+        WorldGenerator& generator;
+        Block blocks[FIELD_COUNT];
+        const RiverDistanceField* rivers = nullptr; // The chunk's region
+        int riverOriginX = 0;
+        int riverOriginY = 0;
+
+        explicit BlockNoise(WorldGenerator& owner) : generator(owner) {}
+
+        float operator()(NoiseField field, int x, int y) const {
+            const NoiseFieldSpec& spec = NOISE_FIELDS[field];
+            const Block& block = blocks[field];
+            int cellX = (x + spec.offsetX) / spec.scale - block.cellX;
+            int cellY = (y + spec.offsetY) / spec.scale - block.cellY;
+            if (cellX < 0 || cellX >= block.width || cellY < 0 || cellY >= block.height) {
+                return generator.noise(x + spec.offsetX, y + spec.offsetY, spec.scale);
+            }
+            return block.values[cellY * block.width + cellX];
+        }
+
+        float distanceToRiver(int x, int y) const {
+            return rivers->getDistance(x - riverOriginX + 0.5f, y - riverOriginY + 0.5f);
+        }
+    };
+}
+
+WorldGenerator::WorldGenerator(std::uint32_t worldSeed) : seed(worldSeed) {
+}
+
+void WorldGenerator::setSeed(std::uint32_t worldSeed) {
+    if (seed != worldSeed) {
+        seed = worldSeed;
+        noiseCache.clear();
+        riverFields.clear();
+    }
+}
+
+std::mt19937::result_type WorldGenerator::seedOffset() const {
+    // Seed 0 leaves every RNG stream untouched, so it reproduces the original world
+    return static_cast<std::mt19937::result_type>(seed) * 2654435761u;
+}
+
+std::mt19937::result_type WorldGenerator::tileSeed(int worldX, int worldY) {
+    // worldX * 1000 + worldY, in unsigned math so it wraps instead of overflowing
+    return static_cast<std::uint32_t>(worldX) * 1000u + static_cast<std::uint32_t>(worldY);
+}
+
+float WorldGenerator::noise(int x, int y, int scale) {
+    auto key = std::make_pair(x / scale, y / scale);
+    auto it = noiseCache.find(key);
+    if (it != noiseCache.end()) {
+        return it->second;
+    }
+    if (noiseCache.size() >= NOISE_CACHE_LIMIT) {
+        noiseCache.clear();
+    }
+
+    float result = evaluateNoiseCell(x / scale, y / scale);
+    noiseCache[key] = result;
+    return result;
+}
+
+float WorldGenerator::evaluateNoiseCell(int cellX, int cellY) {
+    noiseEvaluations++;
+
+    // Simple multi-octave noise simulation
+    float result = 0.0f;
+    float amplitude = 1.0f;
+    std::int64_t frequency = 1;
+    float maxValue = 0.0f;
+
+    for (int i = 0; i < 3; i++) {
+        // Integer math, wrapped to 32 bits: the same seeds as the float expression this
+        // replaced wherever that was exact, and no overflow far from spawn
+        std::int64_t cellSeed = static_cast<std::int64_t>(cellX) * frequency * 1000 + static_cast<std::int64_t>(cellY) * frequency + i * 10000;
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(cellSeed) + seedOffset());
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        result += dist(rng) * amplitude;
+        maxValue += amplitude;
+        amplitude *= 0.5f;
+        frequency *= 2;
+    }
+
+    return result / maxValue;
+}
+
+void WorldGenerator::traceRivers(int regionX, int regionY, std::vector<RiverPolyline>& rivers) {
+    // Everything that can reach the region's field, plus a vertex, so segments run past its edges.
+    // Vertices sit on a world-wide lattice, so neighboring regions trace the same segments.
+    const double spacing = RIVER_VERTEX_SPACING;
+    const double reach = RIVER_FIELD_MAX_DISTANCE + 2.0 * RIVER_FIELD_CELL + spacing;
+    double originX = static_cast<double>(regionX) * RIVER_REGION_TILES;
+    double originY = static_cast<double>(regionY) * RIVER_REGION_TILES;
+    double minX = originX - reach;
+    double minY = originY - reach;
+    double maxX = originX + RIVER_REGION_TILES + reach;
+    double maxY = originY + RIVER_REGION_TILES + reach;
+    double firstX = std::floor(minX / spacing) * spacing;
+    double firstY = std::floor(minY / spacing) * spacing;
+
+    auto sampleNoise = [this](double x, double y, int scale) {
+        return noise(static_cast<int>(std::floor(x)), static_cast<int>(std::floor(y)), scale);
+    };
+    auto toRegion = [originX, originY](double x, double y) {
+        return RiverPoint{ static_cast<float>(x - originX), static_cast<float>(y - originY) };
+    };
+
+    // Horizontal meandering, 70 tiles of swing above the middle of each band and 30 below
+    for (double k = std::floor((minY - 180.0) / HORIZONTAL_RIVER_SPACING); k <= std::floor((maxY - 80.0) / HORIZONTAL_RIVER_SPACING); k++) {
+        double baseY = k * HORIZONTAL_RIVER_SPACING + 150.0;
+        RiverPolyline river;
+        for (double x = firstX; x <= maxX + spacing; x += spacing) {
+            river.push_back(toRegion(x, baseY - std::sin(x * 0.02) * 30.0 - sampleNoise(x, baseY, 80) * 40.0));
+        }
+        rivers.push_back(std::move(river));
+    }
+
+    // Vertical meandering
+    for (double k = std::floor((minX - 225.0) / VERTICAL_RIVER_SPACING); k <= std::floor((maxX - 140.0) / VERTICAL_RIVER_SPACING); k++) {
+        double baseX = k * VERTICAL_RIVER_SPACING + 200.0;
+        RiverPolyline river;
+        for (double y = firstY; y <= maxY + spacing; y += spacing) {
+            river.push_back(toRegion(baseX - std::sin(y * 0.015) * 25.0 - sampleNoise(baseX, y, 90) * 35.0, y));
+        }
+        rivers.push_back(std::move(river));
+    }
+
+    // Diagonal flow, each line pushed up to 100 asin(0.6) tiles along x, alternating sides
+    const double diagonalSwing = 100.0 * std::asin(0.6);
+    double minDiagonal = minX + DIAGONAL_RIVER_SLOPE * minY - diagonalSwing;
+    double maxDiagonal = maxX + DIAGONAL_RIVER_SLOPE * maxY + diagonalSwing;
+    for (double k = std::floor(minDiagonal / DIAGONAL_RIVER_SPACING); k <= std::ceil(maxDiagonal / DIAGONAL_RIVER_SPACING); k++) {
+        double side = (static_cast<long long>(k) % 2 == 0) ? -1.0 : 1.0;
+        RiverPolyline river;
+        for (double y = firstY; y <= maxY + spacing; y += spacing) {
+            double baseX = k * DIAGONAL_RIVER_SPACING - DIAGONAL_RIVER_SLOPE * y;
+            double push = side * 100.0 * std::asin(0.6 * sampleNoise(baseX, y, 50));
+            river.push_back(toRegion(baseX + push, y));
+        }
+        rivers.push_back(std::move(river));
+    }
+}
+
+const RiverDistanceField& WorldGenerator::getRiverField(int regionX, int regionY) {
+    auto key = std::make_pair(regionX, regionY);
+    auto it = riverFields.find(key);
+    if (it != riverFields.end()) {
+        return it->second;
+    }
+    if (riverFields.size() >= RIVER_FIELD_CACHE_LIMIT) {
+        riverFields.clear();
+    }
+
+    std::vector<RiverPolyline> rivers;
+    traceRivers(regionX, regionY, rivers);
+    RiverDistanceField& field = riverFields[key];
+    field.build(rivers);
+    return field;
+}
+
+float WorldGenerator::getDistanceToRiver(int worldX, int worldY) {
+    int regionX = floorDiv(worldX, RIVER_REGION_TILES);
+    int regionY = floorDiv(worldY, RIVER_REGION_TILES);
+    const RiverDistanceField& field = getRiverField(regionX, regionY);
+    return field.getDistance(worldX - regionX * RIVER_REGION_TILES + 0.5f, worldY - regionY * RIVER_REGION_TILES + 0.5f);
+}
+
+template <class Sampler>
+float WorldGenerator::sampleMountainHeight(int worldX, int worldY, const Sampler& sample) {
+    // Create multiple mountain ranges with different characteristics
+    float height = 0.0f;
+
+    // Primary mountain range - large scale ridges
+    float ridge1 = std::abs(std::sin((worldX + worldY) * 0.003f)) * 0.8f;
+    float ridge1Noise = sample(FIELD_RIDGE_1, worldX, worldY) * 0.3f;
+    height = std::max(height, ridge1 + ridge1Noise);
+
+    // Secondary mountain range - perpendicular ridges
+    float ridge2 = std::abs(std::sin((worldX - worldY) * 0.004f)) * 0.7f;
+    float ridge2Noise = sample(FIELD_RIDGE_2, worldX, worldY) * 0.25f;
+    height = std::max(height, ridge2 + ridge2Noise);
+
+    // Tertiary peaks - isolated mountains
+    float peaks = sample(FIELD_PEAKS_1, worldX, worldY) * sample(FIELD_PEAKS_2, worldX, worldY);
+    if (peaks > 0.6f) {
+        height = std::max(height, peaks);
+    }
+
+    // Add fine detail noise
+    float detail = sample(FIELD_DETAIL, worldX, worldY) * 0.15f;
+    height += detail;
+
+    return std::min(height, 1.0f);
+}
+
+template <class Sampler>
+BiomeType WorldGenerator::sampleBiome(int worldX, int worldY, const Sampler& sample) {
+    float elevation = sample(FIELD_ELEVATION, worldX, worldY);
+    float moisture = sample(FIELD_MOISTURE, worldX, worldY);
+    float temperature = sample(FIELD_TEMPERATURE, worldX, worldY);
+    float distanceToRiver = sample.distanceToRiver(worldX, worldY);
+
+    // River check first
+    if (distanceToRiver < RIVER_HALF_WIDTH) {
+        return BiomeType::RIVER;
+    }
+
+    // Lake generation in low elevation areas
+    if (elevation < 0.25f && moisture > 0.4f) {
+        return BiomeType::LAKE;
+    }
+
+    // Mountain generation using new mountain height system
+    if (sampleMountainHeight(worldX, worldY, sample) > MOUNTAIN_THRESHOLD) {
+        return BiomeType::MOUNTAIN;
+    }
+
+    // Forest generation - depends on moisture and temperature
+    if (moisture > 0.55f && temperature > 0.3f && temperature < 0.8f) {
+        return BiomeType::FOREST;
+    }
+
+    // Default to grassland
+    return BiomeType::GRASSLAND;
+}
+
+template <class Sampler>
+TileType WorldGenerator::sampleTileType(int worldX, int worldY, const Sampler& sample) {
+    BiomeType biome = sampleBiome(worldX, worldY, sample);
+    float elevation = sample(FIELD_ELEVATION, worldX, worldY);
+
+    std::mt19937 rng(tileSeed(worldX, worldY) + seedOffset());
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    float random = dist(rng);
+
+    switch (biome) {
+    case BiomeType::LAKE:
+    case BiomeType::RIVER:
+        return TileType::WATER;
+
+    case BiomeType::MOUNTAIN:
+    {
+        float mountainHeight = sampleMountainHeight(worldX, worldY, sample);
+        return generateMountainTileType(worldX, worldY, elevation, mountainHeight);
+    }
+
+    case BiomeType::FOREST:
+        // Forests have varying tree density
+        if (random < 0.75f) {
+            return TileType::TREE;
+        }
+        else {
+            return TileType::GRASS;
+        }
+
+    default: // GRASSLAND
+        // Grasslands have sparse trees
+        if (random < 0.05f) {
+            return TileType::TREE;
+        }
+        else {
+            return TileType::GRASS;
+        }
+    }
+}
+
+float WorldGenerator::getMountainHeight(int worldX, int worldY) {
+    return sampleMountainHeight(worldX, worldY, CachedNoise{ *this });
+}
+
+bool WorldGenerator::isInMountainRange(int worldX, int worldY) {
+    float mountainHeight = getMountainHeight(worldX, worldY);
+    return mountainHeight > MOUNTAIN_THRESHOLD; // Threshold for mountain areas
+}
+
+TileType WorldGenerator::generateMountainTileType(int worldX, int worldY, float elevation, float mountainHeight) {
+    std::mt19937 rng(tileSeed(worldX, worldY) + seedOffset());
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    float random = dist(rng);
+
+    // Higher mountain areas are more likely to be stone
+    float stoneThreshold = 0.3f + (mountainHeight - 0.4f) * 1.5f; // Increases with height
+    stoneThreshold = std::min(stoneThreshold, 0.9f);
+
+    // Very high peaks are almost always stone
+    if (mountainHeight > 0.8f) {
+        return (random < 0.95f) ? TileType::STONE : TileType::GRASS;
+    }
+
+    // Medium height mountains have mixed stone and grass
+    if (random < stoneThreshold) {
+        return TileType::STONE;
+    }
+
+    // Lower mountain areas can have some trees
+    if (mountainHeight < 0.6f && random < 0.1f) {
+        return TileType::TREE;
+    }
+
+    return TileType::GRASS;
+}
+
+BiomeType WorldGenerator::determineBiome(int worldX, int worldY) const {
+    WorldGenerator* mutableThis = const_cast<WorldGenerator*>(this);
+    return mutableThis->sampleBiome(worldX, worldY, CachedNoise{ *mutableThis });
+}
+
+TileType WorldGenerator::generateTileType(int worldX, int worldY) {
+    return sampleTileType(worldX, worldY, CachedNoise{ *this });
+}
+
+template <int Size>
+void WorldGenerator::generateChunk(std::int64_t chunkX, std::int64_t chunkY, TileType* out) {
+    int startX = static_cast<int>(chunkX * Size);
+    int startY = static_cast<int>(chunkY * Size);
+    int endX = startX + Size - 1;
+    int endY = startY + Size - 1;
+
+    BlockNoise blockNoise(*this);
+    int regionX = floorDiv(startX, RIVER_REGION_TILES);
+    int regionY = floorDiv(startY, RIVER_REGION_TILES);
+    blockNoise.rivers = &getRiverField(regionX, regionY);
+    blockNoise.riverOriginX = regionX * RIVER_REGION_TILES;
+    blockNoise.riverOriginY = regionY * RIVER_REGION_TILES;
+
+    for (int field = 0; field < FIELD_COUNT; field++) {
+        const NoiseFieldSpec& spec = NOISE_FIELDS[field];
+        int firstX = startX + spec.offsetX;
+        int firstY = startY + spec.offsetY;
+        int lastX = endX + spec.offsetX;
+        int lastY = endY + spec.offsetY;
+
+        // Division truncates, so cells are contiguous even across zero
+        BlockNoise::Block& block = blockNoise.blocks[field];
+        block.cellX = firstX / spec.scale;
+        block.cellY = firstY / spec.scale;
+        block.width = lastX / spec.scale - block.cellX + 1;
+        block.height = lastY / spec.scale - block.cellY + 1;
+        block.values.resize(static_cast<size_t>(block.width) * block.height);
+        for (int cellY = 0; cellY < block.height; cellY++) {
+            for (int cellX = 0; cellX < block.width; cellX++) {
+                block.values[cellY * block.width + cellX] = evaluateNoiseCell(block.cellX + cellX, block.cellY + cellY);
+            }
+        }
+    }
+
+    for (int y = 0; y < Size; y++) {
+        for (int x = 0; x < Size; x++) {
+            out[y * Size + x] = sampleTileType(startX + x, startY + y, blockNoise);
+        }
+    }
+}
+
+template void WorldGenerator::generateChunk<8>(std::int64_t, std::int64_t, TileType*);
+template void WorldGenerator::generateChunk<16>(std::int64_t, std::int64_t, TileType*);
+template void WorldGenerator::generateChunk<32>(std::int64_t, std::int64_t, TileType*);
+template void WorldGenerator::generateChunk<64>(std::int64_t, std::int64_t, TileType*);
@@ -0,0 +1,65 @@
+#ifndef WORLDGEN_H
+#define WORLDGEN_H
+
+#include <unordered_map>
+#include <random>
+#include <cstdint>
+#include "constants.h"
+#include "utils.h"
+#include "riverfield.h"
+
+// Procedural terrain generation. Has no rendering dependencies, so it can run headless
+// (world baker, server) and one instance per thread (its noise cache is not shared).
+class WorldGenerator {
+public:
+    // Noise cache for performance; cleared when it reaches the limit, so walking an
+    // infinite world doesn't grow it without end
+    std::unordered_map<std::pair<int, int>, float, PairHash> noiseCache;
+    static const size_t NOISE_CACHE_LIMIT = 1 << 16;
+    long long noiseEvaluations = 0; // Lattice cells computed so far, cached or not
+
+    // River distance fields by region, cleared the same way
+    std::unordered_map<std::pair<int, int>, RiverDistanceField, PairHash> riverFields;
+    static const size_t RIVER_FIELD_CACHE_LIMIT = 64;
+
+    explicit WorldGenerator(std::uint32_t worldSeed = 0);
+
+    std::uint32_t getSeed() const { return seed; }
+    void setSeed(std::uint32_t worldSeed);
+
+    float noise(int x, int y, int scale);
+    float getDistanceToRiver(int worldX, int worldY); // Tiles to the nearest river centerline, up to RIVER_FIELD_MAX_DISTANCE
+    const RiverDistanceField& getRiverField(int regionX, int regionY);
+    BiomeType determineBiome(int worldX, int worldY) const;
+    TileType generateTileType(int worldX, int worldY);
+
+    // New mountain generation methods
+    float getMountainHeight(int worldX, int worldY);
+    bool isInMountainRange(int worldX, int worldY);
+    TileType generateMountainTileType(int worldX, int worldY, float elevation, float mountainHeight);
+
+    // Fills Size * Size tiles of the chunk with edge Size at (chunkX, chunkY) in row-major
+    // order, the same tiles generateTileType gives. Noise is constant over each scale x scale
+    // lattice cell, so every field's few cells overlapping the chunk are computed once up
+    // front and the tiles read them, and the region's river field, without the caches.
+    // Instantiated for 8, 16, 32 and 64.
+    template <int Size = CHUNK_SIZE>
+    void generateChunk(std::int64_t chunkX, std::int64_t chunkY, TileType* out);
+
+private:
+    std::uint32_t seed;
+
+    std::mt19937::result_type seedOffset() const;
+    static std::mt19937::result_type tileSeed(int worldX, int worldY);
+    float evaluateNoiseCell(int cellX, int cellY);
+    void traceRivers(int regionX, int regionY, std::vector<RiverPolyline>& rivers);
+
+    // The terrain rules for one tile. They read noise through sample(field, x, y) and rivers
+    // through sample.distanceToRiver(x, y): the caches for single tiles, or a chunk's
+    // precomputed lattice cells and river field in generateChunk.
+    template <class Sampler> float sampleMountainHeight(int worldX, int worldY, const Sampler& sample);
+    template <class Sampler> BiomeType sampleBiome(int worldX, int worldY, const Sampler& sample);
+    template <class Sampler> TileType sampleTileType(int worldX, int worldY, const Sampler& sample);
+};
+
+#endif
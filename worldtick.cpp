@@ -0,0 +1,219 @@
+#include "worldtick.h"
+#include "map.h"
+#include <cmath>
+#include <algorithm>
+
+void TimingWheel::schedule(const TickEvent& event) {
+    TickEvent scheduled = event;
+    scheduled.dueTick = std::max(scheduled.dueTick, currentTick + 1);
+    insert(scheduled);
+    eventCount++;
+}
+
+void TimingWheel::insert(const TickEvent& event) {
+    long long delta = event.dueTick - currentTick;
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        int shift = WHEEL_BITS * level;
+        if (delta < (1LL << (shift + WHEEL_BITS))) {
+            slots[level][(event.dueTick >> shift) & (WHEEL_SLOTS - 1)].push_back(event);
+            return;
+        }
+    }
+    overflow.push_back(event);
+}
+
+void TimingWheel::cascade(int level) {
+    // Everything in the slot the wheel just reached is now close enough for a lower level
+    std::vector<TickEvent> events;
+    if (level == WHEEL_LEVELS) {
+        events.swap(overflow);
+    }
+    else {
+        events.swap(slots[level][(currentTick >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)]);
+    }
+    for (const TickEvent& event : events) {
+        insert(event);
+    }
+}
+
+void TimingWheel::advance(long long tick, std::vector<TickEvent>& due) {
+    while (currentTick < tick) {
+        currentTick++;
+
+        // Highest level first, so its events can land in slots cascaded right after
+        for (int level = WHEEL_LEVELS; level >= 1; level--) {
+            if ((currentTick & ((1LL << (WHEEL_BITS * level)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+
+        std::vector<TickEvent>& slot = slots[0][currentTick & (WHEEL_SLOTS - 1)];
+        eventCount -= slot.size();
+        due.insert(due.end(), slot.begin(), slot.end());
+        slot.clear();
+    }
+}
+
+void TimingWheel::clear() {
+    for (auto& level : slots) {
+        for (auto& slot : level) {
+            slot.clear();
+        }
+    }
+    overflow.clear();
+    eventCount = 0;
+}
+
+WorldTicker::WorldTicker() : rng(20240611u) {
+}
+
+long long WorldTicker::regrowDelay() {
+    // Spread regrowth out so a cleared forest doesn't come back all at once
+    std::uniform_real_distribution<float> spread(0.75f, 1.25f);
+    return static_cast<long long>(TREE_REGROW_TICKS * spread(rng));
+}
+
+void WorldTicker::scheduleRegrowth(ChunkCoord chunk, int tileIndex, long long now) {
+    Regrowth regrowth = { static_cast<std::uint16_t>(tileIndex), now + regrowDelay() };
+    chunkStates[chunk].regrowths.push_back(regrowth);
+    wheel.schedule({ regrowth.dueTick, chunk, regrowth.tileIndex });
+}
+
+bool WorldTicker::hasGrassNeighbor(const Map& gameMap, const Chunk& chunk, int tileX, int tileY) {
+    static const int OFFSETS[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+    for (const auto& offset : OFFSETS) {
+        int x = tileX + offset[0];
+        int y = tileY + offset[1];
+
+        // Neighbors across the chunk edge come from the map
+        sf::Vector2i world = chunkTileToWorld(chunk.coord, x, y);
+        TileType neighbor = (x >= 0 && x < CHUNK_SIZE && y >= 0 && y < CHUNK_SIZE)
+            ? chunk.tileTypes[y][x]
+            : gameMap.getTile(world.x, world.y);
+        if (neighbor == TileType::GRASS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorldTicker::randomUpdate(const Map& gameMap, const Chunk& chunk, std::vector<TileChange>& changes) {
+    int tileIndex = static_cast<int>(rng() % (CHUNK_SIZE * CHUNK_SIZE));
+    int tileX = tileIndex % CHUNK_SIZE;
+    int tileY = tileIndex / CHUNK_SIZE;
+
+    // Grass creeps back over bare dirt, but not under standing water
+    if (chunk.tileTypes[tileY][tileX] == TileType::DIRT && chunk.waterLevels[tileY][tileX] == 0) {
+        std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+        if (chance(rng) < GRASS_SPREAD_CHANCE && hasGrassNeighbor(gameMap, chunk, tileX, tileY)) {
+            sf::Vector2i tile = chunkTileToWorld(chunk.coord, tileX, tileY);
+            changes.push_back({ tile.x, tile.y, TileType::DIRT, TileType::GRASS });
+        }
+    }
+}
+
+void WorldTicker::advance(const Map& gameMap, long long tick, const std::vector<WorldRect>& keepClear, std::vector<TileChange>& changes) {
+    dueEvents.clear();
+    wheel.advance(tick, dueEvents);
+
+    for (const TickEvent& event : dueEvents) {
+        // Unloaded chunks keep their regrowths for catchUp(); events they missed are dropped
+        auto stateIt = chunkStates.find(event.chunk);
+        if (stateIt == chunkStates.end() || !gameMap.findChunk(event.chunk)) {
+            continue;
+        }
+
+        // A chunk reloaded before its old event fired has it scheduled twice; only the first counts
+        std::vector<Regrowth>& regrowths = stateIt->second.regrowths;
+        auto regrowthIt = std::find_if(regrowths.begin(), regrowths.end(), [&event](const Regrowth& regrowth) {
+            return regrowth.tileIndex == event.tileIndex && regrowth.dueTick == event.dueTick;
+        });
+        if (regrowthIt == regrowths.end()) {
+            continue;
+        }
+
+        sf::Vector2i tile = chunkTileToWorld(event.chunk, event.tileIndex % CHUNK_SIZE, event.tileIndex / CHUNK_SIZE);
+        WorldRect tileRect({ static_cast<double>(tile.x) * TILE_SIZE, static_cast<double>(tile.y) * TILE_SIZE },
+            { static_cast<double>(TILE_SIZE), static_cast<double>(TILE_SIZE) });
+        bool occupied = std::any_of(keepClear.begin(), keepClear.end(), [&tileRect](const WorldRect& area) {
+            return area.findIntersection(tileRect).has_value();
+        });
+        if (occupied) {
+            regrowthIt->dueTick = tick + REGROW_RETRY_TICKS;
+            wheel.schedule({ regrowthIt->dueTick, event.chunk, event.tileIndex });
+            continue;
+        }
+
+        changes.push_back({ tile.x, tile.y, TileType::GRASS, TileType::TREE });
+        *regrowthIt = regrowths.back();
+        regrowths.pop_back();
+    }
+
+    for (const auto& entry : gameMap.loadedChunks) {
+        for (int i = 0; i < RANDOM_TICKS_PER_CHUNK; i++) {
+            randomUpdate(gameMap, *entry.second, changes);
+        }
+    }
+}
+
+void WorldTicker::catchUp(const Map& gameMap, const Chunk& chunk, long long now, std::vector<TileChange>& changes) {
+    ChunkTickState& state = chunkStates[chunk.coord];
+    if (state.unloadedTick < 0) {
+        return;
+    }
+
+    long long elapsed = now - state.unloadedTick;
+    state.unloadedTick = -1;
+
+    // Regrowths that came due while away happen now; the rest go back on the wheel
+    for (size_t i = 0; i < state.regrowths.size();) {
+        Regrowth& regrowth = state.regrowths[i];
+        if (regrowth.dueTick <= now) {
+            sf::Vector2i tile = chunkTileToWorld(chunk.coord, regrowth.tileIndex % CHUNK_SIZE, regrowth.tileIndex / CHUNK_SIZE);
+            changes.push_back({ tile.x, tile.y, TileType::GRASS, TileType::TREE });
+            regrowth = state.regrowths.back();
+            state.regrowths.pop_back();
+        }
+        else {
+            wheel.schedule({ regrowth.dueTick, chunk.coord, regrowth.tileIndex });
+            i++;
+        }
+    }
+
+    // Each tick a tile is updated with probability p, so over the elapsed ticks dirt next to
+    // grass has turned with probability 1 - (1 - p)^elapsed. Spreading further into a dirt
+    // patch through tiles that turned meanwhile is left to the live updates.
+    double p = static_cast<double>(RANDOM_TICKS_PER_CHUNK) * GRASS_SPREAD_CHANCE / (CHUNK_SIZE * CHUNK_SIZE);
+    double turned = 1.0 - std::exp(static_cast<double>(elapsed) * std::log1p(-p));
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    for (int y = 0; y < CHUNK_SIZE; y++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            if (chunk.tileTypes[y][x] == TileType::DIRT && chunk.waterLevels[y][x] == 0 &&
+                hasGrassNeighbor(gameMap, chunk, x, y) && chance(rng) < turned) {
+                sf::Vector2i tile = chunkTileToWorld(chunk.coord, x, y);
+                changes.push_back({ tile.x, tile.y, TileType::DIRT, TileType::GRASS });
+            }
+        }
+    }
+}
+
+void WorldTicker::onChunkUnloaded(const Chunk& chunk, long long now) {
+    bool hasDirt = std::find(&chunk.tileTypes[0][0], &chunk.tileTypes[0][0] + CHUNK_SIZE * CHUNK_SIZE, TileType::DIRT)
+        != &chunk.tileTypes[0][0] + CHUNK_SIZE * CHUNK_SIZE;
+
+    // Nothing would change while away, so there is nothing to remember
+    auto stateIt = chunkStates.find(chunk.coord);
+    if (!hasDirt && (stateIt == chunkStates.end() || stateIt->second.regrowths.empty())) {
+        if (stateIt != chunkStates.end()) {
+            chunkStates.erase(stateIt);
+        }
+        return;
+    }
+
+    chunkStates[chunk.coord].unloadedTick = now;
+}
+
+void WorldTicker::clear() {
+    wheel.clear();
+    chunkStates.clear();
+}
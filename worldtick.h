@@ -0,0 +1,99 @@
+#ifndef WORLDTICK_H
+#define WORLDTICK_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <cstdint>
+#include "constants.h"
+#include "chunk.h"
+#include "utils.h"
+
+class Map; // Forward declaration
+
+struct TickEvent {
+    long long dueTick;
+    ChunkCoord chunk;
+    std::uint16_t tileIndex; // y * CHUNK_SIZE + x within the chunk
+};
+
+// Hierarchical timing wheel: level L has WHEEL_SLOTS slots of WHEEL_SLOTS^L ticks each.
+// Events go into the lowest level whose span covers them and cascade one level down each
+// time the wheel below wraps, so scheduling and firing are O(1) per event however far
+// ahead it is due. Events beyond the top level wait in an overflow list.
+class TimingWheel {
+public:
+    static const int WHEEL_BITS = 6;
+    static const int WHEEL_SLOTS = 1 << WHEEL_BITS;
+    static const int WHEEL_LEVELS = 4; // 2^24 ticks, about three days at 60 ticks per second
+
+    void schedule(const TickEvent& event); // Events already due fire on the next advance
+    void advance(long long tick, std::vector<TickEvent>& due); // Appends every event due up to tick
+    void clear();
+
+    long long getCurrentTick() const { return currentTick; }
+    size_t size() const { return eventCount; }
+
+private:
+    std::vector<TickEvent> slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    std::vector<TickEvent> overflow;
+    long long currentTick = 0;
+    size_t eventCount = 0;
+
+    void insert(const TickEvent& event);
+    void cascade(int level);
+};
+
+// A tile change decided by the ticker; Map applies it only if the tile is still `expected`
+struct TileChange {
+    int worldX;
+    int worldY;
+    TileType expected;
+    TileType replacement;
+};
+
+// Timed world behaviour: felled trees regrow, and random tile updates let grass spread
+// back over mined-out dirt. Only loaded chunks are ticked. An unloaded chunk keeps just
+// its unload tick and pending regrowths, and catchUp() settles the time it was away in
+// one step when it loads again, so the cost follows the loaded area, not the world size.
+class WorldTicker {
+public:
+    WorldTicker();
+
+    void scheduleRegrowth(ChunkCoord chunk, int tileIndex, long long now);
+    bool hasState(ChunkCoord chunk) const { return chunkStates.find(chunk) != chunkStates.end(); }
+
+    // Advances to tick: fires due regrowths and runs random updates in loaded chunks.
+    // Regrowth under any keepClear rectangle (pixels) is put off instead of trapping whoever stands there.
+    void advance(const Map& gameMap, long long tick, const std::vector<WorldRect>& keepClear, std::vector<TileChange>& changes);
+
+    // Changes for the time a chunk spent unloaded, from its tiles as loaded
+    void catchUp(const Map& gameMap, const Chunk& chunk, long long now, std::vector<TileChange>& changes);
+    void onChunkUnloaded(const Chunk& chunk, long long now);
+    void clear();
+
+    size_t getScheduledEvents() const { return wheel.size(); }
+
+private:
+    struct Regrowth {
+        std::uint16_t tileIndex;
+        long long dueTick;
+    };
+
+    struct ChunkTickState {
+        long long unloadedTick = -1; // -1 while loaded
+        std::vector<Regrowth> regrowths;
+    };
+
+    TimingWheel wheel;
+    std::unordered_map<ChunkCoord, ChunkTickState, ChunkCoordHash> chunkStates;
+    std::vector<TickEvent> dueEvents;
+    std::mt19937 rng;
+
+    long long regrowDelay();
+    void randomUpdate(const Map& gameMap, const Chunk& chunk, std::vector<TileChange>& changes);
+    static bool hasGrassNeighbor(const Map& gameMap, const Chunk& chunk, int tileX, int tileY);
+};
+
+#endif